@@ -0,0 +1,163 @@
+// Benchmark and correctness check of the batched (AVX2) drop-cutter kernels,
+// and of the compile-time specialized MeshDropEngine.
+//
+// Drops CylCutter, BallCutter and BullCutter on a grid of CL-points with
+// MeshQuery, once with the scalar DropKernel and once with the AVX2 DropKernel,
+// and checks that the results are identical. A subset of the points is also
+// dropped with MillingCutter::dropCutterSTL(), the brute-force test against
+// every triangle (as BatchDropCutter::dropCutter1), and checked against the
+// MeshQuery result.
+// Then Cyl, Ball, Bull and ConeCutter are dropped with MeshQuery through the 
+// virtual calls of MeshDropEngine<MillingCutter>, and through the MeshDropEngine 
+// of the cutter type, and the results are checked to be identical.
+//
+// usage: dropcutter_benchmark file.stl [points-per-side] [brute-force-points]
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <omp.h>
+
+#include <opencamlib/stlsurf.hpp>
+#include <opencamlib/stlreader.hpp>
+#include <opencamlib/clpoint.hpp>
+#include <opencamlib/cylcutter.hpp>
+#include <opencamlib/ballcutter.hpp>
+#include <opencamlib/bullcutter.hpp>
+#include <opencamlib/conecutter.hpp>
+#include <opencamlib/surfaceindex.hpp>
+#include <opencamlib/meshquery.hpp>
+#include <opencamlib/dropkernel.hpp>
+#include <opencamlib/meshdropengine.hpp>
+
+using namespace ocl;
+
+/// drop all points with kernel k, and return the time taken
+double drop(const SurfaceIndex& index, const DropKernel& k, std::vector<CLPoint>& pts) {
+    MeshQuery query( index.mesh() );
+    double t0 = omp_get_wtime();
+    for (unsigned int n=0; n<pts.size(); ++n)
+        query.dropCutter( index.xyTree(), k, pts[n] );
+    return omp_get_wtime() - t0;
+}
+
+/// drop all points with engine e, and return the time taken
+template <class CutterT>
+double drop(const SurfaceIndex& index, const MeshDropEngine<CutterT>& e, std::vector<CLPoint>& pts) {
+    MeshQuery query( index.mesh() );
+    double t0 = omp_get_wtime();
+    for (unsigned int n=0; n<pts.size(); ++n)
+        query.dropCutter( index.xyTree(), e, pts[n] );
+    return omp_get_wtime() - t0;
+}
+
+/// true if a and b have the same z and cc-point
+bool same(const CLPoint& a, const CLPoint& b) {
+    return (a.z == b.z) && (a.cc == b.cc) && (a.cc.type == b.cc.type);
+}
+
+/// drop cutter c with virtual calls and with MeshDropEngine<CutterT>, print the times,
+/// and return the number of points that differ
+template <class CutterT>
+int compareEngines(const SurfaceIndex& index, const CutterT* c, const std::vector<CLPoint>& grid) {
+    std::vector<CLPoint> virt(grid), typed(grid);
+    double t_virt = drop( index, MeshDropEngine<MillingCutter>(c), virt );
+    double t_typed = drop( index, MeshDropEngine<CutterT>(c), typed );
+    std::cout << " " << c->str() << "    " << t_virt << "    " << t_typed << "    " << t_virt/t_typed << "\n";
+    int errors = 0;
+    for (unsigned int n=0; n<grid.size(); ++n) {
+        if ( !same(virt[n], typed[n]) ) {
+            if (errors < 10)
+                std::cout << "ERROR: virtual " << virt[n].str() << " typed " << typed[n].str() << "\n";
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: dropcutter_benchmark file.stl [points-per-side] [brute-force-points]\n";
+        return 1;
+    }
+    std::string fname( argv[1] );
+    int side = (argc > 2) ? atoi(argv[2]) : 200;
+    unsigned int nbrute = (argc > 3) ? atoi(argv[3]) : 200;
+
+    STLSurf s;
+    std::wstring wname( fname.begin(), fname.end() );
+    STLReader r(wname, s);
+    std::cout << "read " << s.size() << " triangles from " << fname << "\n";
+    SurfaceIndex index(s);
+    index.xyTree();
+    index.mesh();
+    std::cout << "AVX2 " << (DropKernel::hasAVX2() ? "available" : "not available") << "\n";
+
+    // grid of points covering the surface
+    std::vector<CLPoint> grid;
+    double minz = s.bb.minpt.z - 1.0;
+    for (int i=0; i<side; ++i) {
+        for (int j=0; j<side; ++j) {
+            double x = s.bb.minpt.x + (s.bb.maxpt.x - s.bb.minpt.x)*i/(side-1);
+            double y = s.bb.minpt.y + (s.bb.maxpt.y - s.bb.minpt.y)*j/(side-1);
+            grid.push_back( CLPoint(x, y, minz) );
+        }
+    }
+
+    double d = 0.02 * std::max( s.bb.maxpt.x - s.bb.minpt.x, s.bb.maxpt.y - s.bb.minpt.y );
+    std::vector<MillingCutter*> cutters;
+    cutters.push_back( new CylCutter(d, 10*d) );
+    cutters.push_back( new BallCutter(d, 10*d) );
+    cutters.push_back( new BullCutter(d, d/4, 10*d) );
+
+    std::cout << "\n" << grid.size() << " points, cutter diameter " << d << "\n";
+    std::cout << "                                  scalar [s]  AVX2 [s]  speedup\n";
+    int errors = 0;
+    for (unsigned int c=0; c<cutters.size(); ++c) {
+        std::vector<CLPoint> scalar(grid), simd(grid);
+        DropKernel ks( cutters[c], false );
+        DropKernel kv( cutters[c], true );
+        double t_scalar = drop( index, ks, scalar );
+        double t_simd = drop( index, kv, simd );
+        std::cout << " " << cutters[c]->str() << "    " << t_scalar << "    " << t_simd;
+        std::cout << "    " << t_scalar/t_simd << "\n";
+        for (unsigned int n=0; n<grid.size(); ++n) {
+            if ( !same(scalar[n], simd[n]) ) {
+                if (errors < 10)
+                    std::cout << "ERROR: scalar " << scalar[n].str() << " AVX2 " << simd[n].str() << "\n";
+                ++errors;
+            }
+        }
+        // brute-force check of a subset
+        unsigned int step = std::max( 1u, (unsigned int)( grid.size() / std::max(1u, nbrute) ) );
+        for (unsigned int n=0; n<grid.size(); n+=step) {
+            CLPoint cl = grid[n];
+            cutters[c]->dropCutterSTL( cl, s );
+            if ( fabs( cl.z - simd[n].z ) > 1e-9 ) {
+                if (errors < 10)
+                    std::cout << "ERROR: brute-force " << cl.str() << " AVX2 " << simd[n].str() << "\n";
+                ++errors;
+            }
+        }
+    }
+    while (!cutters.empty()) delete cutters.back(), cutters.pop_back();
+
+    std::cout << "\n                                  virtual [s]  typed [s]  speedup\n";
+    CylCutter cyl(d, 10*d);
+    BallCutter ball(d, 10*d);
+    BullCutter bull(d, d/4, 10*d);
+    ConeCutter cone(d, 0.6, 10*d);
+    errors += compareEngines( index, &cyl, grid );
+    errors += compareEngines( index, &ball, grid );
+    errors += compareEngines( index, &bull, grid );
+    errors += compareEngines( index, &cone, grid );
+    if (errors) {
+        std::cout << "ERROR: " << errors << " points differ!\n";
+        return 1;
+    }
+    std::cout << "all points agree.\n";
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Memory and speed benchmark of the HEDIGraph half-edge diagram.
+//
+// Builds a Weave from the fibers of a grid of disks, with Weave::build1(),
+// which adds a vertex at every crossing of an x- and a y-interval, and with
+// Weave::build2(), and checks that both find one loop per disk.
+// Then adds random point-sites to a VoronoiDiagram and checks the diagram
+// with VoronoiDiagramChecker.
+// Reports the time taken and the heap memory in use after the build.
+// Run against an older opencamlib for an A/B comparison.
+//
+// usage: halfedge_benchmark [fibers] [disks-per-side] [voronoi-sites] [voronoi-bins]
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <omp.h>
+#include <malloc.h>
+
+#include <opencamlib/point.hpp>
+#include <opencamlib/fiber.hpp>
+#include <opencamlib/interval.hpp>
+#include <opencamlib/weave.hpp>
+#include <opencamlib/voronoidiagram.hpp>
+#include <opencamlib/voronoidiagram_checker.hpp>
+
+using namespace ocl;
+
+/// heap memory in use, in MB
+double heap() {
+    return mallinfo2().uordblks / (1024.0*1024.0);
+}
+
+/// fibers at n positions along the other axis, inside m*m disks of radius 0.4 at the integer points [0, m-1]
+/// x-fibers if x is true, y-fibers otherwise
+std::vector<Fiber> disk_fibers(int n, int m, bool x) {
+    const double r = 0.4;
+    const double lo = -0.5, hi = m - 0.5;
+    std::vector<Fiber> fibers;
+    for (int i=0; i<n; ++i) {
+        double c = lo + (hi-lo)*(i+0.5)/n; // fiber position
+        Fiber f = x ? Fiber( Point(lo, c, 0), Point(hi, c, 0) ) : Fiber( Point(c, lo, 0), Point(c, hi, 0) );
+        int row = (int)floor(c + 0.5);
+        double d = c - row;
+        if ( fabs(d) < r ) {
+            double w = sqrt( r*r - d*d );
+            for (int k=0; k<m; ++k) {
+                Interval ival( (k-w-lo)/(hi-lo), (k+w-lo)/(hi-lo) );
+                f.addInterval( ival );
+            }
+        }
+        fibers.push_back(f);
+    }
+    return fibers;
+}
+
+/// build a weave with build1() or build2(), print the time and memory used, and return the number of loops
+int weave(const std::vector<Fiber>& xfibers, const std::vector<Fiber>& yfibers, bool full) {
+    double mem0 = heap();
+    double t0 = omp_get_wtime();
+    weave2::Weave* w = new weave2::Weave();
+    for (unsigned int n=0; n<xfibers.size(); ++n) {
+        Fiber f = xfibers[n];
+        w->addFiber(f);
+    }
+    for (unsigned int n=0; n<yfibers.size(); ++n) {
+        Fiber f = yfibers[n];
+        w->addFiber(f);
+    }
+    if (full)
+        w->build1();
+    else
+        w->build2();
+    double t_build = omp_get_wtime() - t0;
+    double mem = heap() - mem0;
+    t0 = omp_get_wtime();
+    w->face_traverse();
+    double t_traverse = omp_get_wtime() - t0;
+    int nloops = w->getLoops().size();
+    t0 = omp_get_wtime();
+    delete w;
+    double t_delete = omp_get_wtime() - t0;
+    std::cout << (full ? " build1()     " : " build2()     ") << t_build << "    " << t_traverse << "    ";
+    std::cout << t_delete << "    " << mem << "    " << nloops << "\n";
+    return nloops;
+}
+
+int main(int argc, char** argv) {
+    int nfibers = (argc > 1) ? atoi(argv[1]) : 2000;
+    int ndisks = (argc > 2) ? atoi(argv[2]) : 10;
+    int nsites = (argc > 3) ? atoi(argv[3]) : 100000;
+    int nbins = (argc > 4) ? atoi(argv[4]) : 300;
+    int errors = 0;
+
+    std::vector<Fiber> xfibers = disk_fibers( nfibers, ndisks, true );
+    std::vector<Fiber> yfibers = disk_fibers( nfibers, ndisks, false );
+    std::cout << "weave of " << nfibers << " x " << nfibers << " fibers, " << ndisks*ndisks << " disks\n";
+    std::cout << "              build [s]   traverse [s]   delete [s]   heap [MB]   loops\n";
+    int nloops1 = weave( xfibers, yfibers, true );
+    int nloops2 = weave( xfibers, yfibers, false );
+    if ( (nloops1 != ndisks*ndisks) || (nloops2 != ndisks*ndisks) ) {
+        std::cout << "ERROR: expected " << ndisks*ndisks << " loops!\n";
+        ++errors;
+    }
+    
+    std::cout << "\nvoronoi diagram of " << nsites << " sites, " << nbins << " bins\n";
+    srand(42);
+    std::vector<Point> sites;
+    for (int n=0; n<nsites; ++n)
+        sites.push_back( Point( 0.8*rand()/RAND_MAX - 0.4, 0.8*rand()/RAND_MAX - 0.4, 0 ) );
+    double mem0 = heap();
+    double t0 = omp_get_wtime();
+    VoronoiDiagram* vd = new VoronoiDiagram(1, nbins);
+    for (int n=0; n<nsites; ++n)
+        vd->addVertexSite( sites[n] );
+    double t_build = omp_get_wtime() - t0;
+    double mem = heap() - mem0;
+    VoronoiDiagramChecker checker;
+    bool valid = checker.isValid(vd);
+    t0 = omp_get_wtime();
+    delete vd;
+    double t_delete = omp_get_wtime() - t0;
+    std::cout << "              build [s]   delete [s]   heap [MB]\n";
+    std::cout << " voronoi      " << t_build << "    " << t_delete << "    " << mem << "\n";
+    if (!valid) {
+        std::cout << "ERROR: the voronoi diagram is not valid!\n";
+        ++errors;
+    }
+    if (errors)
+        return 1;
+    std::cout << "all checks passed.\n";
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Benchmark and accuracy check of HeightMapDropCutter.
+//
+// Drops a cutter on a grid covering the surface with HeightMapDropCutter,
+// without and with the exact drop-cutter near steep walls, and with
+// BatchDropCutter, and prints the times and the errors of the heightmap
+// CL-points. The heightmap CL-points must never be below the exact ones
+// (up to the weld tolerance of the IndexedMesh).
+//
+// usage: heightmap_benchmark file.stl [points-per-side] [tolerance]
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <omp.h>
+
+#include <opencamlib/stlsurf.hpp>
+#include <opencamlib/stlreader.hpp>
+#include <opencamlib/clpoint.hpp>
+#include <opencamlib/cylcutter.hpp>
+#include <opencamlib/ballcutter.hpp>
+#include <opencamlib/bullcutter.hpp>
+#include <opencamlib/conecutter.hpp>
+#include <opencamlib/surfaceindex.hpp>
+#include <opencamlib/batchdropcutter.hpp>
+#include <opencamlib/heightmapdropcutter.hpp>
+
+using namespace ocl;
+
+/// run HeightMapDropCutter with tolerance tol, and return the time taken
+double heightmap(boost::shared_ptr<SurfaceIndex> index, const MillingCutter* c, double x, double y, 
+                 double cell, int side, double floor, double tol, std::vector<double>& z, int& exact) {
+    HeightMapDropCutter hdc;
+    hdc.setSurfaceIndex( index );
+    hdc.setCutter( c );
+    hdc.setThreads( omp_get_max_threads() );
+    hdc.setGrid( x, y, cell, side, side );
+    hdc.setZ( floor );
+    hdc.setTolerance( tol );
+    double t0 = omp_get_wtime();
+    hdc.run();
+    double t = omp_get_wtime() - t0;
+    z = hdc.getHeights();
+    exact = hdc.getExactDrops();
+    return t;
+}
+
+/// print the max and mean error of z, and the number of CL-points more than tol too high.
+/// returns the number of CL-points below the exact CL-point (gouges)
+int errors(const std::vector<double>& z, const std::vector<CLPoint>& exact, double tol) {
+    double maxerr = 0.0, sumerr = 0.0;
+    int over = 0, gouge = 0;
+    for (unsigned int n=0; n<z.size(); ++n) {
+        const double err = z[n] - exact[n].z;
+        maxerr = std::max( maxerr, fabs(err) );
+        sumerr += fabs(err);
+        if ( err > tol )
+            ++over;
+        if ( err < -1e-6 )
+            ++gouge;
+    }
+    std::cout << "    max " << maxerr << "  mean " << sumerr/z.size() << "  high by more than tolerance " << over;
+    std::cout << "  low " << gouge;
+    return gouge;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: heightmap_benchmark file.stl [points-per-side] [tolerance]\n";
+        return 1;
+    }
+    std::string fname( argv[1] );
+    int side = (argc > 2) ? atoi(argv[2]) : 300;
+    double tol = (argc > 3) ? atof(argv[3]) : 0.01;
+
+    STLSurf s;
+    std::wstring wname( fname.begin(), fname.end() );
+    STLReader r(wname, s);
+    std::cout << "read " << s.size() << " triangles from " << fname << "\n";
+    boost::shared_ptr<SurfaceIndex> index( new SurfaceIndex(s) );
+    index->xyTree();
+    index->mesh();
+
+    const double size = std::max( s.bb.maxpt.x - s.bb.minpt.x, s.bb.maxpt.y - s.bb.minpt.y );
+    const double cell = size / (side-1);
+    const double floor = s.bb.minpt.z - 1.0;
+    const double d = 0.02 * size;
+    std::vector<MillingCutter*> cutters;
+    cutters.push_back( new CylCutter(d, 10*d) );
+    cutters.push_back( new BallCutter(d, 10*d) );
+    cutters.push_back( new BullCutter(d, d/4, 10*d) );
+    cutters.push_back( new ConeCutter(d, 0.6, 10*d) );
+
+    std::cout << "\n" << side << "x" << side << " grid, cell " << cell << ", cutter diameter " << d;
+    std::cout << ", tolerance " << tol << "\n";
+    int gouges = 0;
+    for (unsigned int c=0; c<cutters.size(); ++c) {
+        BatchDropCutter bdc;
+        bdc.setSurfaceIndex( index );
+        bdc.setCutter( cutters[c] );
+        bdc.setThreads( omp_get_max_threads() );
+        for (int j=0; j<side; ++j) {
+            for (int i=0; i<side; ++i) {
+                CLPoint p( s.bb.minpt.x + i*cell, s.bb.minpt.y + j*cell, floor );
+                bdc.appendPoint( p );
+            }
+        }
+        double t0 = omp_get_wtime();
+        bdc.run();
+        double t_batch = omp_get_wtime() - t0;
+        std::vector<CLPoint> exact = bdc.getCLPoints();
+
+        std::vector<double> z;
+        int nexact;
+        double t_map = heightmap( index, cutters[c], s.bb.minpt.x, s.bb.minpt.y, cell, side, floor, 0.0, z, nexact );
+        std::cout << " " << cutters[c]->str() << "\n";
+        std::cout << "  batch      " << t_batch << " s\n";
+        std::cout << "  heightmap  " << t_map << " s  speedup " << t_batch/t_map << "\n";
+        gouges += errors( z, exact, tol );
+        std::cout << "\n";
+        t_map = heightmap( index, cutters[c], s.bb.minpt.x, s.bb.minpt.y, cell, side, floor, tol, z, nexact );
+        std::cout << "  +exact     " << t_map << " s  speedup " << t_batch/t_map << "  exact drops " << nexact << "\n";
+        gouges += errors( z, exact, tol );
+        std::cout << "\n";
+    }
+    while (!cutters.empty()) delete cutters.back(), cutters.pop_back();
+    if (gouges) {
+        std::cout << "ERROR: " << gouges << " CL-points below the exact CL-point!\n";
+        return 1;
+    }
+    std::cout << "no CL-points below the exact CL-point.\n";
+    return 0;
+}
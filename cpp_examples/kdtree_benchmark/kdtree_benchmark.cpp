@@ -0,0 +1,268 @@
+// Benchmark of KDTree<Triangle> build and query times.
+//
+// Compares the flat KDTree (contiguous node-array, in-place median split,
+// parallel build) against ListKDTree, a copy of the earlier list-based kd-tree
+// where each node is heap-allocated and owns a std::list of triangles.
+// Then compares search_cutter_overlap(), which finds the triangles overlapping the
+// square bounding-box of a cutter, with search_cutter_footprint(), which finds
+// those overlapping its circular footprint.
+//
+// usage: kdtree_benchmark file.stl [queries] [radius] [bucketsize]
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <list>
+#include <vector>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+#include <omp.h>
+
+#include <opencamlib/stlsurf.hpp>
+#include <opencamlib/stlreader.hpp>
+#include <opencamlib/triangle.hpp>
+#include <opencamlib/kdtree.hpp>
+#include <opencamlib/numeric.hpp>
+#include <opencamlib/cylcutter.hpp>
+#include <opencamlib/clpoint.hpp>
+
+using namespace ocl;
+
+/// node of the list-based reference kd-tree
+class ListKDNode {
+    public:
+        ListKDNode(int d, double cv, const std::list<Triangle>* t) : dim(d), cutval(cv), hi(0), lo(0), tris(0) {
+            if (t)
+                tris = new std::list<Triangle>(*t);
+        }
+        ~ListKDNode() {
+            delete hi;
+            delete lo;
+            delete tris;
+        }
+        int dim;
+        double cutval;
+        ListKDNode* hi;
+        ListKDNode* lo;
+        std::list<Triangle>* tris;
+};
+
+/// the list-based kd-tree, as it was before the flat KDTree
+class ListKDTree {
+    public:
+        ListKDTree(int bucket) : bucketSize(bucket), root(0) {
+            dimensions.push_back(0);
+            dimensions.push_back(1);
+            dimensions.push_back(2);
+            dimensions.push_back(3);
+        }
+        ~ListKDTree() {delete root;}
+        void build(const std::list<Triangle>& list) {root = build_node(&list);}
+        std::list<Triangle>* search(const Bbox& bb) {
+            std::list<Triangle>* tris = new std::list<Triangle>();
+            search_node(tris, bb, root);
+            return tris;
+        }
+    protected:
+        ListKDNode* build_node(const std::list<Triangle>* tris) {
+            Spread* spr = calc_spread(tris);
+            double cutvalue = spr->start + spr->val/2;
+            if ( (tris->size() <= bucketSize) || isZero_tol(spr->val) ) {
+                ListKDNode* bucket = new ListKDNode(spr->d, cutvalue, tris);
+                delete spr;
+                return bucket;
+            }
+            std::list<Triangle>* lolist = new std::list<Triangle>();
+            std::list<Triangle>* hilist = new std::list<Triangle>();
+            BOOST_FOREACH(Triangle t, *tris) {
+                if (t.bb[spr->d] > cutvalue)
+                    hilist->push_back(t);
+                else
+                    lolist->push_back(t);
+            }
+            ListKDNode* node = new ListKDNode(spr->d, cutvalue, 0);
+            if (!hilist->empty())
+                node->hi = build_node(hilist);
+            if (!lolist->empty())
+                node->lo = build_node(lolist);
+            delete spr;
+            delete lolist;
+            delete hilist;
+            return node;
+        }
+        static bool spread_compare(Spread* x, Spread* y) {return x->val > y->val;}
+        Spread* calc_spread(const std::list<Triangle>* tris) {
+            std::vector<double> maxval(6);
+            std::vector<double> minval(6);
+            bool first = true;
+            BOOST_FOREACH(Triangle t, *tris) {
+                for (unsigned int m=0;m<dimensions.size();++m) {
+                    double v = t.bb[ dimensions[m] ];
+                    if (first || maxval[ dimensions[m] ] < v)
+                        maxval[ dimensions[m] ] = v;
+                    if (first || minval[ dimensions[m] ] > v)
+                        minval[ dimensions[m] ] = v;
+                }
+                first = false;
+            }
+            std::vector<Spread*> spreads;
+            for (unsigned int m=0;m<dimensions.size();++m)
+                spreads.push_back( new Spread(dimensions[m], maxval[dimensions[m]]-minval[dimensions[m]], minval[dimensions[m]]) );
+            std::sort(spreads.begin(), spreads.end(), spread_compare);
+            Spread* s = new Spread(*spreads[0]);
+            while (!spreads.empty()) delete spreads.back(), spreads.pop_back();
+            return s;
+        }
+        void search_node(std::list<Triangle>* tris, const Bbox& bb, ListKDNode* node) {
+            if (node->tris) {
+                BOOST_FOREACH(Triangle t, *(node->tris))
+                    tris->push_back(t);
+                return;
+            }
+            bool hi = true, lo = true;
+            if ( (node->dim % 2) == 0 )
+                hi = !( node->cutval > bb[node->dim+1] );
+            else
+                lo = !( node->cutval < bb[node->dim-1] );
+            if (hi && node->hi)
+                search_node(tris, bb, node->hi);
+            if (lo && node->lo)
+                search_node(tris, bb, node->lo);
+        }
+        unsigned int bucketSize;
+        ListKDNode* root;
+        std::vector<int> dimensions;
+};
+
+/// true if the XY-projection of bounding-box b overlaps the circle of radius r at (x, y)
+bool overlapsCircle(const Bbox& b, double x, double y, double r) {
+    double dx = std::max( std::max( b.minpt.x - x, x - b.maxpt.x ), 0.0 );
+    double dy = std::max( std::max( b.minpt.y - y, y - b.maxpt.y ), 0.0 );
+    return dx*dx + dy*dy <= r*r;
+}
+
+/// true if the XY-projections of the bounding-boxes overlap
+bool overlapsXY(const Bbox& a, const Bbox& b) {
+    return !( (a.minpt.x > b.maxpt.x) || (a.maxpt.x < b.minpt.x) ||
+              (a.minpt.y > b.maxpt.y) || (a.maxpt.y < b.minpt.y) );
+}
+
+/// the square bounding-box of a cutter of radius r at cl
+Bbox cutter_bbox_of(const CLPoint& cl, double r) {
+    return Bbox( cl.x-r, cl.x+r, cl.y-r, cl.y+r, cl.z, cl.z );
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: kdtree_benchmark file.stl [queries] [radius] [bucketsize]\n";
+        return 1;
+    }
+    std::string fname( argv[1] );
+    unsigned int nqueries = (argc > 2) ? atoi(argv[2]) : 100000;
+    double radius = (argc > 3) ? atof(argv[3]) : 2.0;
+    int bucket = (argc > 4) ? atoi(argv[4]) : 1;
+
+    STLSurf s;
+    std::wstring wname( fname.begin(), fname.end() );
+    STLReader r(wname, s);
+    std::cout << "read " << s.size() << " triangles from " << fname << "\n";
+
+    // query boxes at random positions within the surface bounding-box
+    std::vector<Bbox> queries;
+    srand(42);
+    for (unsigned int n=0; n<nqueries; ++n) {
+        double x = s.bb.minpt.x + (s.bb.maxpt.x - s.bb.minpt.x)*rand()/RAND_MAX;
+        double y = s.bb.minpt.y + (s.bb.maxpt.y - s.bb.minpt.y)*rand()/RAND_MAX;
+        queries.push_back( Bbox(x-radius, x+radius, y-radius, y+radius, s.bb.minpt.z, s.bb.maxpt.z) );
+    }
+
+    double t0 = omp_get_wtime();
+    ListKDTree listtree(bucket);
+    listtree.build( s.tris );
+    double t_listbuild = omp_get_wtime() - t0;
+
+    t0 = omp_get_wtime();
+    KDTree<Triangle> tree;
+    tree.setXYDimensions();
+    tree.setBucketSize( bucket );
+    tree.build( s.tris );
+    double t_build = omp_get_wtime() - t0;
+
+    // queries with the list-based tree
+    t0 = omp_get_wtime();
+    long int nlist = 0;
+    BOOST_FOREACH( const Bbox& bb, queries ) {
+        std::list<Triangle>* tris = listtree.search( bb );
+        BOOST_FOREACH( const Triangle& t, *tris ) {
+            if ( overlapsXY(t.bb, bb) )
+                ++nlist;
+        }
+        delete tris;
+    }
+    double t_listquery = omp_get_wtime() - t0;
+
+    // queries with the flat tree and a re-used index buffer
+    t0 = omp_get_wtime();
+    long int nflat = 0;
+    std::vector<unsigned int> idx;
+    BOOST_FOREACH( const Bbox& bb, queries ) {
+        tree.search( bb, idx );
+        BOOST_FOREACH( unsigned int n, idx ) {
+            if ( overlapsXY(tree.get(n).bb, bb) )
+                ++nflat;
+        }
+    }
+    double t_query = omp_get_wtime() - t0;
+
+    std::cout << "\n" << nqueries << " queries, radius " << radius << ", bucket-size " << bucket;
+    std::cout << ", " << omp_get_max_threads() << " threads\n";
+    std::cout << "              build [s]   query [s]   overlapping triangles\n";
+    std::cout << " list-tree    " << t_listbuild << "    " << t_listquery << "    " << nlist << "\n";
+    std::cout << " flat-tree    " << t_build << "    " << t_query << "    " << nflat << "\n";
+    std::cout << " speedup      " << t_listbuild/t_build << "    " << t_listquery/t_query << "\n";
+    if (nlist != nflat) {
+        std::cout << "ERROR: the trees found a different number of overlapping triangles!\n";
+        return 1;
+    }
+
+    // square and circular footprint queries of a cutter of the same radius
+    CylCutter cutter( 2*radius, 1.0 );
+    std::vector<CLPoint> cls;
+    BOOST_FOREACH( const Bbox& bb, queries ) {
+        cls.push_back( CLPoint( (bb.minpt.x+bb.maxpt.x)/2, (bb.minpt.y+bb.maxpt.y)/2, s.bb.minpt.z ) );
+    }
+    t0 = omp_get_wtime();
+    long int nsquare = 0;
+    BOOST_FOREACH( const CLPoint& cl, cls ) {
+        tree.search_cutter_overlap( &cutter, &cl, idx );
+        BOOST_FOREACH( unsigned int n, idx ) {
+            if ( overlapsXY(tree.get(n).bb, cutter_bbox_of(cl, radius)) )
+                ++nsquare;
+        }
+    }
+    double t_square = omp_get_wtime() - t0;
+    long int ncircle = 0; // the expected number of footprint overlaps
+    BOOST_FOREACH( const CLPoint& cl, cls ) {
+        tree.search_cutter_overlap( &cutter, &cl, idx );
+        BOOST_FOREACH( unsigned int n, idx ) {
+            if ( overlapsCircle(tree.get(n).bb, cl.x, cl.y, radius) )
+                ++ncircle;
+        }
+    }
+    t0 = omp_get_wtime();
+    long int nfoot = 0;
+    BOOST_FOREACH( const CLPoint& cl, cls ) {
+        tree.search_cutter_footprint( &cutter, &cl, idx );
+        nfoot += idx.size();
+    }
+    double t_foot = omp_get_wtime() - t0;
+    std::cout << "\n              query [s]   overlapping triangles\n";
+    std::cout << " square       " << t_square << "    " << nsquare << "\n";
+    std::cout << " footprint    " << t_foot << "    " << nfoot << "  (" << nsquare - nfoot << " pruned)\n";
+    if (nfoot != ncircle) {
+        std::cout << "ERROR: the footprint query found " << nfoot << " triangles, expected " << ncircle << "!\n";
+        return 1;
+    }
+    return 0;
+}
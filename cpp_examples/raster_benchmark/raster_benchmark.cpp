@@ -0,0 +1,128 @@
+// Benchmark and correctness check of RasterDropCutter.
+//
+// Drops a cutter on a raster covering the surface, once with RasterDropCutter,
+// which sweeps an active set of triangles along each line, and once with
+// BatchDropCutter, which searches the kd-tree for each CL-point, and checks
+// that the CL-points are at the same height. The raster is run along the
+// x-axis, and along a diagonal.
+//
+// usage: raster_benchmark file.stl [lines] [points-per-line]
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <omp.h>
+
+#include <opencamlib/stlsurf.hpp>
+#include <opencamlib/stlreader.hpp>
+#include <opencamlib/clpoint.hpp>
+#include <opencamlib/cylcutter.hpp>
+#include <opencamlib/ballcutter.hpp>
+#include <opencamlib/bullcutter.hpp>
+#include <opencamlib/conecutter.hpp>
+#include <opencamlib/surfaceindex.hpp>
+#include <opencamlib/batchdropcutter.hpp>
+#include <opencamlib/rasterdropcutter.hpp>
+
+using namespace ocl;
+
+/// run the raster with cutter c, and compare with BatchDropCutter. returns the number of errors
+int compare(boost::shared_ptr<SurfaceIndex> index, const MillingCutter* c, 
+            const Point& origin, const Point& dir, double length, double stepover, int lines, double sampling) {
+    RasterDropCutter rdc;
+    rdc.setSurfaceIndex( index );
+    rdc.setCutter( c );
+    rdc.setThreads( omp_get_max_threads() );
+    rdc.setSampling( sampling );
+    rdc.setZ( index->getSTL().bb.minpt.z - 1.0 );
+    rdc.setRaster( origin, dir, length, stepover, lines );
+    double t0 = omp_get_wtime();
+    rdc.run();
+    double t_raster = omp_get_wtime() - t0;
+    std::vector<CLPoint> raster = rdc.getCLPoints();
+
+    BatchDropCutter bdc;
+    bdc.setSurfaceIndex( index );
+    bdc.setCutter( c );
+    bdc.setThreads( omp_get_max_threads() );
+    for (unsigned int n=0; n<raster.size(); ++n) {
+        CLPoint p( raster[n].x, raster[n].y, rdc.getZ() );
+        bdc.appendPoint( p );
+    }
+    t0 = omp_get_wtime();
+    bdc.run();
+    double t_batch = omp_get_wtime() - t0;
+    std::vector<CLPoint> batch = bdc.getCLPoints();
+
+    std::cout << " " << c->str() << "    " << t_batch << "    " << t_raster;
+    std::cout << "    " << t_batch/t_raster << "\n";
+    int errors = 0;
+    for (unsigned int n=0; n<raster.size(); ++n) {
+        if ( raster[n].z != batch[n].z ) {
+            if (errors < 10)
+                std::cout << "ERROR: raster " << raster[n].str() << " batch " << batch[n].str() << "\n";
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: raster_benchmark file.stl [lines] [points-per-line]\n";
+        return 1;
+    }
+    std::string fname( argv[1] );
+    int lines = (argc > 2) ? atoi(argv[2]) : 200;
+    int points = (argc > 3) ? atoi(argv[3]) : 1000;
+
+    STLSurf s;
+    std::wstring wname( fname.begin(), fname.end() );
+    STLReader r(wname, s);
+    std::cout << "read " << s.size() << " triangles from " << fname << "\n";
+    boost::shared_ptr<SurfaceIndex> index( new SurfaceIndex(s) );
+    index->xyTree(); // built here, so that it is not timed with the first BatchDropCutter
+    index->mesh();
+
+    const double dx = s.bb.maxpt.x - s.bb.minpt.x;
+    const double dy = s.bb.maxpt.y - s.bb.minpt.y;
+    const double d = 0.02 * std::max( dx, dy );
+    std::vector<MillingCutter*> cutters;
+    cutters.push_back( new CylCutter(d, 10*d) );
+    cutters.push_back( new BallCutter(d, 10*d) );
+    cutters.push_back( new BullCutter(d, d/4, 10*d) );
+    cutters.push_back( new ConeCutter(d, 0.6, 10*d) );
+
+    int errors = 0;
+    // along x, from the lower left corner
+    std::cout << "\n" << lines << " lines along x, " << points << " points per line\n";
+    std::cout << "                                  batch [s]  raster [s]  speedup\n";
+    for (unsigned int c=0; c<cutters.size(); ++c) {
+        errors += compare( index, cutters[c], s.bb.minpt, Point(1,0,0), dx, dy/(lines-1), 
+                           lines, dx/(points-1) );
+    }
+    // along the diagonal, covering the bounding-box
+    const double diag = sqrt( dx*dx + dy*dy );
+    const Point dir( dx/diag, dy/diag, 0 );
+    const Point normal( -dir.y, dir.x, 0 );
+    const double across = 2*dx*dy/diag; // width of the bounding-box across the diagonal
+    const Point center = 0.5*( s.bb.minpt + s.bb.maxpt );
+    const Point origin = center - 0.5*diag*dir - 0.5*across*normal;
+    std::cout << "\n" << lines << " lines along the diagonal, " << points << " points per line\n";
+    std::cout << "                                  batch [s]  raster [s]  speedup\n";
+    for (unsigned int c=0; c<cutters.size(); ++c) {
+        errors += compare( index, cutters[c], origin, dir, diag, across/(lines-1), 
+                           lines, diag/(points-1) );
+    }
+    while (!cutters.empty()) delete cutters.back(), cutters.pop_back();
+    if (errors) {
+        std::cout << "ERROR: " << errors << " points differ!\n";
+        return 1;
+    }
+    std::cout << "all points agree.\n";
+    return 0;
+}
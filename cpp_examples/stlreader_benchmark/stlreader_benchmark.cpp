@@ -0,0 +1,127 @@
+// Benchmark of ASCII STL reading throughput.
+//
+// Compares STLReader (memory-mapped file, hand-written float scanner, parallel
+// parsing of parts split at "endfacet" lines) against LegacyASCIIReader, a copy
+// of the earlier reader which used getline() and a std::istringstream per line.
+//
+// usage: stlreader_benchmark file.stl [repeats]
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+
+#include <boost/foreach.hpp>
+#include <omp.h>
+
+#include <opencamlib/stlsurf.hpp>
+#include <opencamlib/stlreader.hpp>
+#include <opencamlib/triangle.hpp>
+
+using namespace ocl;
+
+/// the ASCII part of STLReader, as it was before the memory-mapped reader
+void LegacyASCIIReader(const std::string& fname, STLSurf& surface) {
+    std::ifstream ifs(fname.c_str(), std::ios::binary);
+    if (!ifs)
+        return;
+    char str[1024] = "solid";
+    ifs.getline(str, 1024);
+    float n[3];
+    float x[3][3];
+    char five_chars[6] = "aaaaa";
+    int vertex = 0;
+    while (!ifs.eof()) {
+        ifs.getline(str, 1024);
+        int i = 0, j = 0;
+        for(; i<5; i++, j++) {
+            if (str[j] == 0) break;
+            while (str[j] == ' ' || str[j] == '\t') j++;
+            five_chars[i] = str[j];
+        }
+        if (i == 5) {
+            if (!strcmp(five_chars, "verte")) {
+                std::istringstream ss(str);
+                ss.imbue(std::locale("C"));
+                while (ss.peek() == ' ') ss.seekg(1, std::ios_base::cur);
+                ss.seekg(std::string("vertex").size(), std::ios_base::cur);
+                ss >> x[vertex][0] >> x[vertex][1] >> x[vertex][2];
+                vertex++;
+                if (vertex > 2) vertex = 2;
+            } else if (!strcmp(five_chars, "facet")) {
+                std::istringstream ss(str);
+                ss.imbue(std::locale("C"));
+                while (ss.peek() == ' ') ss.seekg(1, std::ios_base::cur);
+                ss.seekg(std::string("facet normal").size(), std::ios_base::cur);
+                ss >> n[0] >> n[1] >> n[2];
+                vertex = 0;
+            } else if (!strcmp(five_chars, "endfa")) {
+                if (vertex == 2) {
+                    surface.addTriangle(Triangle(Point(x[0][0], x[0][1], x[0][2]), 
+                        Point(x[1][0], x[1][1], x[1][2]), 
+                        Point(x[2][0], x[2][1], x[2][2])));
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: stlreader_benchmark file.stl [repeats]\n";
+        return 1;
+    }
+    std::string fname( argv[1] );
+    int repeats = (argc > 2) ? atoi(argv[2]) : 3;
+    std::ifstream f(fname.c_str(), std::ios::binary | std::ios::ate);
+    double mb = f.tellg() / 1.0e6;
+    f.close();
+
+    // best of repeats, so that both readers run with the file in the page-cache
+    double t_legacy = 0, t_new = 0;
+    unsigned int n_legacy = 0, n_new = 0;
+    bool same = true;
+    for (int r=0; r<repeats; ++r) {
+        STLSurf s1;
+        double t0 = omp_get_wtime();
+        LegacyASCIIReader(fname, s1);
+        double t = omp_get_wtime() - t0;
+        if (r == 0 || t < t_legacy)
+            t_legacy = t;
+        n_legacy = s1.size();
+
+        STLSurf s2;
+        std::wstring wname( fname.begin(), fname.end() );
+        t0 = omp_get_wtime();
+        STLReader reader(wname, s2);
+        t = omp_get_wtime() - t0;
+        if (r == 0 || t < t_new)
+            t_new = t;
+        n_new = s2.size();
+
+        if (r == 0 && n_legacy == n_new) { // compare the vertices
+            std::list<Triangle>::const_iterator it = s2.tris.begin();
+            BOOST_FOREACH( const Triangle& t1, s1.tris ) {
+                for (int m=0; m<3; ++m) {
+                    if ( t1.p[m].x != it->p[m].x || t1.p[m].y != it->p[m].y || t1.p[m].z != it->p[m].z )
+                        same = false;
+                }
+                ++it;
+            }
+        }
+    }
+
+    std::cout << fname << ": " << mb << " MB, " << omp_get_max_threads() << " threads\n";
+    std::cout << "              time [s]    MB/s    triangles\n";
+    std::cout << " legacy       " << t_legacy << "    " << mb/t_legacy << "    " << n_legacy << "\n";
+    std::cout << " STLReader    " << t_new << "    " << mb/t_new << "    " << n_new << "\n";
+    std::cout << " speedup      " << t_legacy/t_new << "\n";
+    if (n_legacy != n_new || !same) {
+        std::cout << "ERROR: the readers returned different triangles!\n";
+        return 1;
+    }
+    return 0;
+}
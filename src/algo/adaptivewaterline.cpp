@@ -18,6 +18,7 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
 #include <algorithm>
 #include <vector>
 
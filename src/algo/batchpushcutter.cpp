@@ -29,6 +29,7 @@
 #include "point.hpp"
 #include "triangle.hpp"
 #include "batchpushcutter.hpp"
+#include "meshquery.hpp"
 
 namespace ocl
 {
@@ -44,29 +45,28 @@ BatchPushCutter::BatchPushCutter() {
 #endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
 }
 
 BatchPushCutter::~BatchPushCutter() {
     delete fibers;
-    delete root;
 }
 
-void BatchPushCutter::setSTL(const STLSurf &s) {
-    surf = &s;
-    std::cout << "BPC::setSTL() Building kd-tree... bucketSize=" << bucketSize << "..";
-    root->setBucketSize( bucketSize );
-    if (x_direction)
-        root->setYZDimensions(); // we search for triangles in the XY plane, don't care about Z-coordinate
-    else if (y_direction)
-        root->setXZDimensions();
-    else {
-        std::cout << " ERROR: setXDirection() or setYDirection() must be called before setSTL() \n";
+// the kd-tree is looked up in set_root(), so that pushCutter1() and operations which 
+// search their own trees (MultiWaterline) don't build it
+void BatchPushCutter::setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx) {
+    Operation::setSurfaceIndex(idx);
+    root = NULL;
+    if ( !x_direction && !y_direction ) {
+        std::cout << " ERROR: setXDirection() or setYDirection() must be called before setSTL() or setSurfaceIndex() \n";
         assert(0);
     }
-    std::cout << "BPC::setSTL() root->build()...";
-    root->build(s.tris);
-    std::cout << "done.\n";
+}
+
+void BatchPushCutter::set_root() {
+    if (x_direction)
+        root = index->yzTree(); // x-fibers, search for triangles in the YZ plane
+    else
+        root = index->xzTree(); // y-fibers, search for triangles in the XZ plane
 }
 
 void BatchPushCutter::appendFiber(Fiber& f) {
@@ -81,25 +81,32 @@ void BatchPushCutter::pushCutter1() {
     nCalls = 0;
     boost::progress_display show_progress( fibers->size() );
     BOOST_FOREACH(Fiber& f, *fibers) {
-        BOOST_FOREACH( const Triangle& t, surf->tris) {// test against all triangles in s
-            Interval i;
-            cutter->pushCutter(f,i,t);
-            f.addInterval(i);
-            ++nCalls;
-        }
+        nCalls += pushCutter(f);
         ++show_progress;
     }
     std::cout << "BatchPushCutter done." << std::endl;
     return;
 }
 
+int BatchPushCutter::pushCutter(Fiber& f) const {
+    int calls = 0;
+    BOOST_FOREACH( const Triangle& t, surf->tris) {// test against all triangles in s
+        Interval i;
+        cutter->pushCutter(f,i,t);
+        f.addInterval(i);
+        ++calls;
+    }
+    return calls;
+}
+
 /// push-cutter which uses KDNode2 kd-tree search to find triangles 
 /// overlapping with the cutter.
 void BatchPushCutter::pushCutter2() {
     std::cout << "BatchPushCutter2 with " << fibers->size() << 
               " fibers and " << surf->tris.size() << " triangles..." << std::endl;
     nCalls = 0;
-    std::list<Triangle>* overlap_triangles;
+    set_root();
+    std::vector<unsigned int> tri_idx; // re-used between fibers
     boost::progress_display show_progress( fibers->size() );
     BOOST_FOREACH(Fiber& f, *fibers) {
         CLPoint cl;
@@ -114,17 +121,16 @@ void BatchPushCutter::pushCutter2() {
         } else {
             assert(0);
         }
-        overlap_triangles = root->search_cutter_overlap(cutter, &cl);
-        assert( overlap_triangles->size() <= surf->size() ); // can't possibly find more triangles than in the STLSurf 
-        BOOST_FOREACH( const Triangle& t, *overlap_triangles) {
+        root->search_cutter_overlap(cutter, &cl, tri_idx);
+        assert( tri_idx.size() <= surf->size() ); // can't possibly find more triangles than in the STLSurf 
+        BOOST_FOREACH( unsigned int n, tri_idx) {
             //if ( bb->overlaps( t.bb ) ) {
                 Interval i;
-                cutter->pushCutter(f,i,t);
+                cutter->pushCutter(f,i,root->get(n));
                 f.addInterval(i);
                 ++nCalls;
             //}
         }
-        delete( overlap_triangles );
         ++show_progress;
     }
     std::cout << "BatchPushCutter2 done." << std::endl;
@@ -138,21 +144,21 @@ void BatchPushCutter::pushCutter3() {
               " fibers and " << surf->tris.size() << " triangles." << std::endl;
     std::cout << " cutter = " << cutter->str() << "\n";
     nCalls = 0;
+    set_root();
     boost::progress_display show_progress( fibers->size() );
 #ifdef _OPENMP
     omp_set_num_threads(nthreads);
     //omp_set_nested(1);
 #endif
     unsigned int Nmax = fibers->size();         // the number of fibers to process
-    std::list<Triangle>::iterator it,it_end;    // for looping over found triabgles
-    Interval* i;
-    std::list<Triangle>* tris;
     std::vector<Fiber>& fiberr = *fibers;
     unsigned int n; // loop variable
     unsigned int calls=0;
     
-    #pragma omp parallel for schedule(dynamic) shared(calls, fiberr) private(n,i,tris,it,it_end)
-    //#pragma omp parallel for shared( calls, fiberr) private(n,i,tris,it,it_end)
+    #pragma omp parallel shared(calls, fiberr) private(n)
+    {
+    std::vector<unsigned int> tri_idx; // per-thread buffer, re-used between fibers
+    #pragma omp for schedule(dynamic)
     for (n=0; n<Nmax; ++n) { // loop through all fibers
 #ifdef _OPENMP
         if ( n== 0 ) { // first iteration
@@ -170,20 +176,18 @@ void BatchPushCutter::pushCutter3() {
             cl.y=0;
             cl.z=fiberr[n].p1.z;
         }
-        tris = root->search_cutter_overlap(cutter, &cl);
-        it_end = tris->end();
-        for ( it=tris->begin() ; it!=it_end ; ++it) { // loop through the found overlapping triangles
+        root->search_cutter_overlap(cutter, &cl, tri_idx);
+        BOOST_FOREACH( unsigned int m, tri_idx ) { // loop through the found overlapping triangles
             //if ( bb->overlaps( it->bb ) ) {
                 // todo: optimization where method-calls are skipped if triangle bbox already in the fiber
-                i = new Interval();
-                cutter->pushCutter(fiberr[n],*i,*it);  
-                fiberr[n].addInterval(*i); 
+                Interval i;
+                cutter->pushCutter(fiberr[n],i,root->get(m));  
+                fiberr[n].addInterval(i); 
                 ++calls;
-                delete i;
             //}
         }
-        delete( tris );
         ++show_progress;
+    } // end OpenMP for
     } // OpenMP parallel region ends here
     
     this->nCalls = calls;
@@ -191,5 +195,48 @@ void BatchPushCutter::pushCutter3() {
     return;
 }
 
+void BatchPushCutter::pushCutter4() {
+    std::cout << "BatchPushCutter4 with " << fibers->size() << 
+              " fibers and " << surf->tris.size() << " triangles." << std::endl;
+    std::cout << " cutter = " << cutter->str() << "\n";
+    nCalls = 0;
+    set_root();
+    const IndexedMesh* mesh = index->mesh();
+    boost::progress_display show_progress( fibers->size() );
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    unsigned int Nmax = fibers->size();         // the number of fibers to process
+    std::vector<Fiber>& fiberr = *fibers;
+    unsigned int n; // loop variable
+    unsigned int calls=0;
+    
+    #pragma omp parallel shared(fiberr) private(n) reduction(+:calls)
+    {
+    std::vector<unsigned int> tri_idx; // per-thread buffer, re-used between fibers
+    MeshQuery query( mesh ); // per-thread vertex and edge stamps
+    #pragma omp for schedule(dynamic)
+    for (n=0; n<Nmax; ++n) { // loop through all fibers
+        CLPoint cl; // cl-point on the fiber
+        if ( x_direction ) {
+            cl.x=0;
+            cl.y=fiberr[n].p1.y;
+            cl.z=fiberr[n].p1.z;
+        } else if (y_direction ) {
+            cl.x=fiberr[n].p1.x;
+            cl.y=0;
+            cl.z=fiberr[n].p1.z;
+        }
+        root->search_cutter_overlap(cutter, &cl, tri_idx);
+        calls += query.pushCutter( root, tri_idx, cutter, fiberr[n] );
+        ++show_progress;
+    } // end OpenMP for
+    } // OpenMP parallel region ends here
+    
+    this->nCalls = calls;
+    std::cout << "\nBatchPushCutter4 done." << std::endl;
+    return;
+}
+
 }// end namespace
 // end file batchpushcutter.cpp
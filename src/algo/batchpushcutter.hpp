@@ -47,8 +47,9 @@ class BatchPushCutter : public Operation {
         BatchPushCutter();
         virtual ~BatchPushCutter();
         
-        /// set the STL-surface and build kd-tree
-        void setSTL(const STLSurf& s);
+        /// use the YZ (x-direction) or XZ (y-direction) kd-tree of idx. The tree is built 
+        /// when a kd-tree version of the algorithm first runs
+        void setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx);
 
         /// set this bpc to be x-direction
         void setXDirection() {x_direction=true;y_direction=false;}
@@ -63,6 +64,10 @@ class BatchPushCutter : public Operation {
         void run() {this->pushCutter1();}
         
         std::vector<Fiber>* getFibers() const {return fibers;}
+        /// push the cutter along fiber f against all triangles of the surface, as pushCutter1(). 
+        /// Returns the number of triangles. The BatchPushCutter is not modified, 
+        /// so many threads can push fibers at the same time.
+        int pushCutter(Fiber& f) const;
         
     protected:
         /// 1st version of algorithm
@@ -71,6 +76,10 @@ class BatchPushCutter : public Operation {
         void pushCutter2();
         /// 3rd version of algorithm
         void pushCutter3();
+        /// as pushCutter3, but tests each vertex and edge of the IndexedMesh only once per fiber
+        void pushCutter4();
+        /// set root to the YZ (x-direction) or XZ (y-direction) kd-tree of the SurfaceIndex, building it if needed
+        void set_root();
         
         /// pointer to list of Fibers
         std::vector<Fiber>* fibers;
@@ -41,10 +41,10 @@ class BatchPushCutter_py : public BatchPushCutter {
                     if ( !i.empty() ) {
                         Point tmp = f.point(i.lower);
                         CLPoint p1 = CLPoint( tmp.x, tmp.y, tmp.z );
-                        p1.cc = new CCPoint(i.lower_cc);
+                        p1.cc = i.lower_cc;
                         tmp = f.point(i.upper);
                         CLPoint p2 = CLPoint( tmp.x, tmp.y, tmp.z );
-                        p2.cc = new CCPoint(i.upper_cc);
+                        p2.cc = i.upper_cc;
                         plist.append(p1);
                         plist.append(p2);
                     }
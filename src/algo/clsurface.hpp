@@ -60,10 +60,7 @@ struct VertexProps {
 
 int VertexProps::count = 0;
 
-typedef boost::adjacency_list_traits<boost::listS, 
-                                     boost::listS, 
-                                     boost::bidirectionalS, 
-                                     boost::listS >::edge_descriptor Edge;
+typedef HEDIEdge Edge;
 
 typedef unsigned int Face;  
 
@@ -103,22 +100,9 @@ struct FaceProps {
 
   
 // extra storage in graph:
-typedef HEDIGraph<     boost::listS,             // out-edge storage
-                       boost::listS,             // vertex set storage
-                       boost::bidirectionalS,    // bidirectional graph.
-                       VertexProps,              // vertex properties
-                       EdgeProps,                // edge properties
-                       FaceProps,                // face properties
-                       boost::no_property,       // graph properties
-                       boost::listS             // edge storage
-                       > CLSGraph;
+typedef HEDIGraph< VertexProps, EdgeProps, FaceProps > CLSGraph;
 
-typedef boost::graph_traits< CLSGraph >::vertex_descriptor  Vertex;
-typedef boost::graph_traits< CLSGraph >::vertex_iterator    VertexItr;
-//typedef boost::graph_traits< CLSGraph >::edge_descriptor    Edge;
-typedef boost::graph_traits< CLSGraph >::edge_iterator      EdgeItr;
-typedef boost::graph_traits< CLSGraph >::out_edge_iterator  OutEdgeItr;
-typedef boost::graph_traits< CLSGraph >::adjacency_iterator AdjacencyItr;
+typedef CLSGraph::Vertex Vertex;
 
 typedef std::vector<Vertex> VertexVector;
 typedef std::vector<Face> FaceVector;
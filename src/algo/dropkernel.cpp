@@ -0,0 +1,240 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+#include <cassert>
+
+#include <boost/static_assert.hpp>
+
+#include "dropkernel.hpp"
+#include "millingcutter.hpp"
+#include "cylcutter.hpp"
+#include "ballcutter.hpp"
+#include "bullcutter.hpp"
+#include "indexedmesh.hpp"
+#include "clpoint.hpp"
+
+// the AVX2 version is compiled with a target attribute, so the rest of ocl needs no
+// special compiler flags, and the same binary runs on CPUs without AVX2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OCL_DROPKERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace ocl
+{
+
+#ifdef OCL_DROPKERNEL_AVX2
+
+// NOTE: without "fma", so that a*b+c is rounded as in the scalar version
+#define OCL_AVX2 __attribute__((target("avx2")))
+
+/// load base[idx[0]] ... base[idx[3]]. 
+/// (the masked gather, because the unmasked one gives a spurious -Wuninitialized with some gcc versions)
+static inline OCL_AVX2 __m256d gather(const double* base, __m128i idx) {
+    const __m256d all = _mm256_castsi256_pd( _mm256_set1_epi64x(-1) );
+    return _mm256_mask_i32gather_pd( _mm256_setzero_pd(), base, idx, all, 8 );
+}
+
+/// lanes k with mask[k] true are all-ones
+static inline OCL_AVX2 __m256d lanemask(const bool* mask) {
+    return _mm256_castsi256_pd( _mm256_set_epi64x( mask[3] ? -1 : 0, mask[2] ? -1 : 0, 
+                                                   mask[1] ? -1 : 0, mask[0] ? -1 : 0 ) );
+}
+
+/// facet-drop of (clx,cly) against four faces, as in MillingCutter::meshFacetDrop().
+/// writes the tip z-height and cc-point of each face, and whether the cc-point is inside the face
+static OCL_AVX2 void facetDropAVX2(const MeshFaceData& fd, const unsigned int* idx, const bool* horiz,
+                                   double clx, double cly, double xy_normal_length, double normal_length, 
+                                   double center_height, double* tip, double* ccx, double* ccy, double* ccz, 
+                                   int* inside) {
+    const __m128i vi = _mm_loadu_si128( (const __m128i*) idx );
+    const __m256d nx = gather( &fd.nx[0], vi );
+    const __m256d ny = gather( &fd.ny[0], vi );
+    const __m256d nz = gather( &fd.nz[0], vi );
+    const __m256d d  = gather( &fd.d[0], vi );
+    const __m256d xynx = gather( &fd.xynx[0], vi );
+    const __m256d xyny = gather( &fd.xyny[0], vi );
+    const __m256d cx = _mm256_set1_pd( clx );
+    const __m256d cy = _mm256_set1_pd( cly );
+    const __m256d xnl = _mm256_set1_pd( xy_normal_length );
+    const __m256d nl = _mm256_set1_pd( normal_length );
+    // radiusvector = xy_normal_length*xyNormal + normal_length*normal
+    const __m256d rvx = _mm256_add_pd( _mm256_mul_pd( xnl, xynx ), _mm256_mul_pd( nl, nx ) );
+    const __m256d rvy = _mm256_add_pd( _mm256_mul_pd( xnl, xyny ), _mm256_mul_pd( nl, ny ) );
+    const __m256d rvz = _mm256_mul_pd( nl, nz );
+    // cc-point, in the plane of the face
+    __m256d px = _mm256_sub_pd( cx, rvx );
+    __m256d py = _mm256_sub_pd( cy, rvy );
+    const __m256d minus_d = _mm256_xor_pd( d, _mm256_set1_pd( -0.0 ) );
+    __m256d pz = _mm256_mul_pd( _mm256_div_pd( _mm256_set1_pd( 1.0 ), nz ), 
+                                _mm256_sub_pd( _mm256_sub_pd( minus_d, _mm256_mul_pd( nx, px ) ), 
+                                               _mm256_mul_pd( ny, py ) ) );
+    __m256d tz = _mm256_sub_pd( _mm256_add_pd( pz, rvz ), _mm256_set1_pd( center_height ) );
+    // horizontal faces: the cc-point is below cl, at the height of the face
+    const __m256d hmask = lanemask( horiz );
+    const __m256d x0 = gather( &fd.x[0][0], vi );
+    const __m256d y0 = gather( &fd.y[0][0], vi );
+    const __m256d z0 = gather( &fd.z[0][0], vi );
+    px = _mm256_blendv_pd( px, cx, hmask );
+    py = _mm256_blendv_pd( py, cy, hmask );
+    pz = _mm256_blendv_pd( pz, z0, hmask );
+    tz = _mm256_blendv_pd( tz, z0, hmask );
+    // inside-test, as MeshFaceData::isInside()
+    const __m256d v0x = _mm256_sub_pd( gather( &fd.x[2][0], vi ), x0 );
+    const __m256d v0y = _mm256_sub_pd( gather( &fd.y[2][0], vi ), y0 );
+    const __m256d v0z = _mm256_sub_pd( gather( &fd.z[2][0], vi ), z0 );
+    const __m256d v1x = _mm256_sub_pd( gather( &fd.x[1][0], vi ), x0 );
+    const __m256d v1y = _mm256_sub_pd( gather( &fd.y[1][0], vi ), y0 );
+    const __m256d v1z = _mm256_sub_pd( gather( &fd.z[1][0], vi ), z0 );
+    const __m256d v2x = _mm256_sub_pd( px, x0 );
+    const __m256d v2y = _mm256_sub_pd( py, y0 );
+    const __m256d v2z = _mm256_sub_pd( pz, z0 );
+    const __m256d dot02 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( v0x, v2x ), _mm256_mul_pd( v0y, v2y ) ), 
+                                         _mm256_mul_pd( v0z, v2z ) );
+    const __m256d dot12 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( v1x, v2x ), _mm256_mul_pd( v1y, v2y ) ), 
+                                         _mm256_mul_pd( v1z, v2z ) );
+    const __m256d dot00 = gather( &fd.dot00[0], vi );
+    const __m256d dot01 = gather( &fd.dot01[0], vi );
+    const __m256d dot11 = gather( &fd.dot11[0], vi );
+    const __m256d invD  = gather( &fd.invD[0], vi );
+    const __m256d u = _mm256_mul_pd( _mm256_sub_pd( _mm256_mul_pd( dot11, dot02 ), _mm256_mul_pd( dot01, dot12 ) ), invD );
+    const __m256d v = _mm256_mul_pd( _mm256_sub_pd( _mm256_mul_pd( dot00, dot12 ), _mm256_mul_pd( dot01, dot02 ) ), invD );
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d in = _mm256_and_pd( _mm256_and_pd( _mm256_cmp_pd( u, zero, _CMP_GT_OQ ), 
+                                                     _mm256_cmp_pd( v, zero, _CMP_GT_OQ ) ),
+                                      _mm256_cmp_pd( _mm256_add_pd( u, v ), _mm256_set1_pd( 1.0 ), _CMP_LT_OQ ) );
+    const int bits = _mm256_movemask_pd( in );
+    for (int k=0; k<DropKernel::WIDTH; ++k)
+        inside[k] = (bits >> k) & 1;
+    _mm256_storeu_pd( tip, tz );
+    _mm256_storeu_pd( ccx, px );
+    _mm256_storeu_pd( ccy, py );
+    _mm256_storeu_pd( ccz, pz );
+}
+
+// vertexDrop() reads the IndexedMesh vertices, a std::vector<Point>, as one array of doubles
+BOOST_STATIC_ASSERT( sizeof(Point) == 3*sizeof(double) );
+
+/// vertex-drop of (clx,cly) against four vertices at xyz[idx[k]], as in MillingCutter::singleVertexDrop().
+/// writes the cl z-height of each vertex, and whether it is within the cutter radius
+static OCL_AVX2 void vertexDropAVX2(const double* xyz, const unsigned int* idx, double clx, double cly,
+                                    double radius, double a, double b, double* z, int* inside) {
+    const __m128i vi = _mm_loadu_si128( (const __m128i*) idx );
+    const __m256d px = gather( xyz, vi );
+    const __m256d py = gather( xyz+1, vi );
+    const __m256d pz = gather( xyz+2, vi );
+    const __m256d dx = _mm256_sub_pd( _mm256_set1_pd( clx ), px );
+    const __m256d dy = _mm256_sub_pd( _mm256_set1_pd( cly ), py );
+    const __m256d q = _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ) );
+    // height(q) = b - sqrt(b^2 - (q-a)^2), zero on the flat part q <= a
+    const __m256d va = _mm256_set1_pd( a );
+    const __m256d t = _mm256_sub_pd( q, va );
+    __m256d h = _mm256_sub_pd( _mm256_set1_pd( b ), 
+                               _mm256_sqrt_pd( _mm256_sub_pd( _mm256_set1_pd( b*b ), _mm256_mul_pd( t, t ) ) ) );
+    h = _mm256_blendv_pd( h, _mm256_setzero_pd(), _mm256_cmp_pd( q, va, _CMP_LE_OQ ) );
+    _mm256_storeu_pd( z, _mm256_sub_pd( pz, h ) );
+    const int bits = _mm256_movemask_pd( _mm256_cmp_pd( q, _mm256_set1_pd( radius ), _CMP_LE_OQ ) );
+    for (int k=0; k<DropKernel::WIDTH; ++k)
+        inside[k] = (bits >> k) & 1;
+}
+
+#endif // OCL_DROPKERNEL_AVX2
+
+DropKernel::DropKernel(const MillingCutter* c, bool simd) : cutter(c), kind(OTHER), avx2(false) {
+    if ( dynamic_cast<const CylCutter*>(c) ) 
+        kind = CYL;
+    else if ( dynamic_cast<const BallCutter*>(c) ) 
+        kind = BALL;
+    else if ( dynamic_cast<const BullCutter*>(c) ) 
+        kind = BULL;
+    radius = c->radius;
+    xy_normal_length = c->xy_normal_length;
+    normal_length = c->normal_length;
+    center_height = c->center_height;
+    a = xy_normal_length;
+    b = normal_length;
+    avx2 = simd && supported() && hasAVX2();
+}
+
+bool DropKernel::hasAVX2() {
+#ifdef OCL_DROPKERNEL_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void DropKernel::facetDrop(CLPoint& cl, const IndexedMesh& m, const unsigned int* f, int n) const {
+    assert( n <= WIDTH );
+#ifdef OCL_DROPKERNEL_AVX2
+    if ( avx2 ) {
+        const MeshFaceData& fd = m.faceData();
+        unsigned int idx[WIDTH];
+        bool horiz[WIDTH];
+        for (int k=0; k<WIDTH; ++k) {
+            idx[k] = f[ (k<n) ? k : 0 ]; // unused lanes repeat the first face
+            horiz[k] = (fd.flags[ idx[k] ] & MeshFaceData::HORIZONTAL) != 0;
+        }
+        double tip[WIDTH], ccx[WIDTH], ccy[WIDTH], ccz[WIDTH];
+        int inside[WIDTH];
+        facetDropAVX2( fd, idx, horiz, cl.x, cl.y, xy_normal_length, normal_length, center_height,
+                       tip, ccx, ccy, ccz, inside );
+        for (int k=0; k<n; ++k) {
+            if ( inside[k] && !(fd.flags[ idx[k] ] & MeshFaceData::VERTICAL) ) {
+                CCPoint cc_tmp( ccx[k], ccy[k], ccz[k], FACET );
+                cl.liftZ( tip[k], cc_tmp );
+            }
+        }
+        return;
+    }
+#endif
+    for (int k=0; k<n; ++k)
+        cutter->meshFacetDrop( cl, m, f[k] );
+}
+
+void DropKernel::vertexDrop(CLPoint& cl, const IndexedMesh& m, const unsigned int* v, int n) const {
+    assert( n <= WIDTH );
+#ifdef OCL_DROPKERNEL_AVX2
+    if ( avx2 ) {
+        // the vertices are Points, three doubles each, so vertex k starts at 3*k
+        unsigned int idx[WIDTH];
+        for (int k=0; k<WIDTH; ++k)
+            idx[k] = 3*v[ (k<n) ? k : 0 ];
+        double z[WIDTH];
+        int inside[WIDTH];
+        vertexDropAVX2( &m.vertex(0).x, idx, cl.x, cl.y, radius, a, b, z, inside );
+        for (int k=0; k<n; ++k) {
+            if ( inside[k] ) {
+                CCPoint cc_tmp( m.vertex(v[k]), VERTEX );
+                cl.liftZ( z[k], cc_tmp );
+            }
+        }
+        return;
+    }
+#endif
+    for (int k=0; k<n; ++k)
+        cutter->singleVertexDrop( cl, m.vertex(v[k]) );
+}
+
+} // end namespace
+// end file dropkernel.cpp
@@ -0,0 +1,86 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DROPKERNEL_H
+#define DROPKERNEL_H
+
+namespace ocl
+{
+
+class MillingCutter;
+class IndexedMesh;
+class CLPoint;
+
+/// \brief batched facet-drop and vertex-drop for CylCutter, BallCutter and BullCutter
+///
+/// For these cutters the height of the cutter at radius r is zero for r <= a, and 
+/// b - sqrt(b^2 - (r-a)^2) outside, with a = xy_normal_length and b = normal_length,
+/// and the facet contact is the one of MillingCutter::meshFacetDrop(). DropKernel
+/// drops one CLPoint against up to WIDTH faces or vertices at a time, using the 
+/// precomputed IndexedMesh::faceData(). 
+///
+/// The AVX2 version is chosen at run-time when the CPU supports it, and computes
+/// the same (bit-identical) contacts as the scalar version, which calls 
+/// MillingCutter::meshFacetDrop() and singleVertexDrop() one feature at a time.
+/// The contacts of a batch are applied in order, so the CLPoint and its CCPoint
+/// are also the same as with one-at-a-time drops.
+class DropKernel {
+    public:
+        /// number of faces or vertices in a batch
+        enum { WIDTH = 4 };
+        /// kernel for cutter c. With simd=false the scalar version is always used.
+        DropKernel(const MillingCutter* c, bool simd = true);
+        /// true if the cutter is a CylCutter, BallCutter or BullCutter
+        bool supported() const {return kind != OTHER;}
+        /// true if the AVX2 version is used
+        bool usesSIMD() const {return avx2;}
+        /// the cutter
+        const MillingCutter* getCutter() const {return cutter;}
+        /// drop cl against the facets of faces f[0]...f[n-1] of m, with n <= WIDTH
+        void facetDrop(CLPoint& cl, const IndexedMesh& m, const unsigned int* f, int n) const;
+        /// drop cl against vertices v[0]...v[n-1] of m, with n <= WIDTH
+        void vertexDrop(CLPoint& cl, const IndexedMesh& m, const unsigned int* v, int n) const;
+        /// true if this build of ocl has the AVX2 version, and the CPU supports it
+        static bool hasAVX2();
+    protected:
+        /// the cutter
+        const MillingCutter* cutter;
+        /// type of cutter
+        enum { CYL, BALL, BULL, OTHER } kind;
+        /// use the AVX2 version
+        bool avx2;
+        /// radius of the cutter
+        double radius;
+        /// flat radius, height(r) is zero for r <= a
+        double a;
+        /// corner radius
+        double b;
+        /// MillingCutter::xy_normal_length
+        double xy_normal_length;
+        /// MillingCutter::normal_length
+        double normal_length;
+        /// MillingCutter::center_height
+        double center_height;
+};
+
+} // end namespace
+#endif
+// end file dropkernel.hpp
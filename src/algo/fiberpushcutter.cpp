@@ -43,28 +43,21 @@ FiberPushCutter::FiberPushCutter() {
 #endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
 }
 
 FiberPushCutter::~FiberPushCutter() {
-    delete root;
 }
 
-void FiberPushCutter::setSTL(const STLSurf &s) {
-    surf = &s;
-    std::cout << "BPC::setSTL() Building kd-tree... bucketSize=" << bucketSize << "..";
-    root->setBucketSize( bucketSize );
+void FiberPushCutter::setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx) {
+    Operation::setSurfaceIndex(idx);
     if (x_direction)
-        root->setYZDimensions(); 
+        root = index->yzTree(); // x-fibers, search for triangles in the YZ plane
     else if (y_direction)
-        root->setXZDimensions();
+        root = index->xzTree(); // y-fibers, search for triangles in the XZ plane
     else {
-        std::cout << " ERROR: setXDirection() or setYDirection() must be called before setSTL() \n";
+        std::cout << " ERROR: setXDirection() or setYDirection() must be called before setSTL() or setSurfaceIndex() \n";
         assert(0);
     }
-    std::cout << "BPC::setSTL() root->build()";
-    root->build(s.tris);
-    std::cout << " done.\n";
 }
 
 void FiberPushCutter::pushCutter1(Fiber& f) {
@@ -78,9 +71,6 @@ void FiberPushCutter::pushCutter1(Fiber& f) {
 }
 
 void FiberPushCutter::pushCutter2(Fiber& f) {
-    std::list<Triangle>::iterator it,it_end;    // for looping over found triangles
-    Interval* i;
-    std::list<Triangle>* tris;
     CLPoint cl;
     if ( x_direction ) {
         cl.x=0;
@@ -91,16 +81,13 @@ void FiberPushCutter::pushCutter2(Fiber& f) {
         cl.y=0;
         cl.z=f.p1.z;
     }
-    tris = root->search_cutter_overlap(cutter, &cl);
-    it_end = tris->end();
-    for ( it=tris->begin() ; it!=it_end ; ++it) {
-		i = new Interval();
-		cutter->pushCutter(f,*i,*it);
-		f.addInterval(*i); 
-		++nCalls;
-		delete i;
+    root->search_cutter_overlap(cutter, &cl, tri_idx);
+    BOOST_FOREACH( unsigned int n, tri_idx ) {
+        Interval i;
+        cutter->pushCutter(f,i,root->get(n));
+        f.addInterval(i); 
+        ++nCalls;
     }
-    delete( tris );
 }
 
 }// end namespace
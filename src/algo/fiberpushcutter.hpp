@@ -41,8 +41,8 @@ class FiberPushCutter : public Operation {
         FiberPushCutter();
         virtual ~FiberPushCutter();
         
-        /// set the STL-surface and build kd-tree
-        void setSTL(const STLSurf& s);
+        /// use the YZ (x-direction) or XZ (y-direction) kd-tree of idx
+        void setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx);
 
         /// set this bpc to be x-direction
         void setXDirection() {x_direction=true;y_direction=false;}
@@ -63,6 +63,8 @@ class FiberPushCutter : public Operation {
         bool x_direction;
         /// true if we have y-direction fibers
         bool y_direction;
+        /// indices of triangles overlapping the fiber, re-used between calls to run()
+        std::vector<unsigned int> tri_idx;
 };
 
 } // end namespace
@@ -0,0 +1,101 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MESHDROPENGINE_H
+#define MESHDROPENGINE_H
+
+#include "millingcutter.hpp"
+#include "indexedmesh.hpp"
+#include "clpoint.hpp"
+#include "ccpoint.hpp"
+
+namespace ocl
+{
+
+/// \brief the facet-, vertex- and edge-drops of MeshQuery::dropCutter() for a cutter of type CutterT
+///
+/// MillingCutter::meshFacetDrop(), singleVertexDrop() and meshEdgeDrop() call height() and
+/// singleEdgeDropCanonical() through the vtable, for every triangle, vertex and edge.
+/// MeshDropEngine<CutterT> calls CutterT::meshFacetDrop(), CutterT::height() and 
+/// CutterT::singleEdgeDropCanonical() by their qualified names, so the calls are resolved at 
+/// compile time, and inlined where the cutter defines them in its header.
+/// The cutter must be of type CutterT, not a subclass of it: use BatchDropCutter, which 
+/// picks the MeshDropEngine once per run() with dynamic_cast.
+/// MeshDropEngine<MillingCutter> calls the virtual functions, for any other cutter.
+template <class CutterT>
+class MeshDropEngine {
+    public:
+        /// engine for cutter c
+        explicit MeshDropEngine(const CutterT* c) : cutter(c) {}
+        /// the cutter
+        const MillingCutter* getCutter() const {return cutter;}
+        /// as MillingCutter::meshFacetDrop()
+        bool facetDrop(CLPoint& cl, const IndexedMesh& m, unsigned int n) const {
+            return cutter->CutterT::meshFacetDrop(cl, m, n);
+        }
+        /// as MillingCutter::singleVertexDrop()
+        bool vertexDrop(CLPoint& cl, const Point& p) const {
+            const double q = cl.xyDistance(p);
+            if ( q <= cutter->radius ) {
+                CCPoint cc_tmp(p, VERTEX);
+                return cl.liftZ( p.z - cutter->CutterT::height(q), cc_tmp );
+            }
+            return false;
+        }
+        /// as MillingCutter::meshEdgeDrop()
+        bool edgeDrop(CLPoint& cl, const IndexedMesh& m, unsigned int n) const {
+            Point up1, up2;
+            double s;
+            if ( !cutter->meshEdgeCanonical(cl, m, n, up1, up2, s) )
+                return false;
+            return MillingCutter::meshEdgeLift(cl, m, n, s, cutter->CutterT::singleEdgeDropCanonical(up1, up2));
+        }
+    private:
+        const CutterT* cutter;
+};
+
+/// MeshDropEngine for any MillingCutter, with virtual calls
+template <>
+class MeshDropEngine<MillingCutter> {
+    public:
+        /// engine for cutter c
+        explicit MeshDropEngine(const MillingCutter* c) : cutter(c) {}
+        /// the cutter
+        const MillingCutter* getCutter() const {return cutter;}
+        /// calls MillingCutter::meshFacetDrop()
+        bool facetDrop(CLPoint& cl, const IndexedMesh& m, unsigned int n) const {
+            return cutter->meshFacetDrop(cl, m, n);
+        }
+        /// calls MillingCutter::singleVertexDrop()
+        bool vertexDrop(CLPoint& cl, const Point& p) const {
+            return cutter->singleVertexDrop(cl, p);
+        }
+        /// calls MillingCutter::meshEdgeDrop()
+        bool edgeDrop(CLPoint& cl, const IndexedMesh& m, unsigned int n) const {
+            return cutter->meshEdgeDrop(cl, m, n);
+        }
+    private:
+        const MillingCutter* cutter;
+};
+
+} // end namespace
+#endif
+// end file meshdropengine.hpp
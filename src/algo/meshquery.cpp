@@ -0,0 +1,523 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/foreach.hpp>
+
+#include "meshquery.hpp"
+#include "dropkernel.hpp"
+#include "meshdropengine.hpp"
+#include "indexedmesh.hpp"
+#include "millingcutter.hpp"
+#include "cylcutter.hpp"
+#include "ballcutter.hpp"
+#include "bullcutter.hpp"
+#include "conecutter.hpp"
+#include "clpoint.hpp"
+#include "fiber.hpp"
+#include "interval.hpp"
+
+namespace ocl
+{
+
+/// the vertex and edge stamps of a MeshQuery for a single CL-point
+class QueryStamps {
+    public:
+        QueryStamps(std::vector<unsigned int>& vs, std::vector<unsigned int>& es, unsigned int s) 
+            : vstamp(vs), estamp(es), stamp(s) {}
+        /// true the first time vertex v is tested in this query
+        bool firstVertex(unsigned int v) {return first(vstamp, v);}
+        /// true the first time edge e is tested in this query
+        bool firstEdge(unsigned int e) {return first(estamp, e);}
+    private:
+        bool first(std::vector<unsigned int>& st, unsigned int n) {
+            if ( st[n] == stamp )
+                return false;
+            st[n] = stamp;
+            return true;
+        }
+        std::vector<unsigned int>& vstamp;
+        std::vector<unsigned int>& estamp;
+        unsigned int stamp;
+};
+
+/// the vertex and edge stamps of CL-point k of a packet query. A vertex or edge stamped 
+/// in this query has a mask of the CL-points that have tested it; an older stamp means none has.
+class PacketStamps {
+    public:
+        PacketStamps(std::vector<unsigned int>& vs, std::vector<unsigned int>& es, 
+                     std::vector<PacketMask>& vm, std::vector<PacketMask>& em, unsigned int s, unsigned int k) 
+            : vstamp(vs), estamp(es), vmask(vm), emask(em), stamp(s), bit( PacketMask(1) << k ) {}
+        /// true the first time vertex v is tested by CL-point k in this query
+        bool firstVertex(unsigned int v) {return first(vstamp, vmask, v);}
+        /// true the first time edge e is tested by CL-point k in this query
+        bool firstEdge(unsigned int e) {return first(estamp, emask, e);}
+    private:
+        bool first(std::vector<unsigned int>& st, std::vector<PacketMask>& mask, unsigned int n) {
+            if ( st[n] != stamp ) {
+                st[n] = stamp;
+                mask[n] = 0;
+            }
+            if ( mask[n] & bit )
+                return false;
+            mask[n] |= bit;
+            return true;
+        }
+        std::vector<unsigned int>& vstamp;
+        std::vector<unsigned int>& estamp;
+        std::vector<PacketMask>& vmask;
+        std::vector<PacketMask>& emask;
+        unsigned int stamp;
+        PacketMask bit;
+};
+
+/// visitor for MeshQuery::dropCutter(). Drops against the facet of each found triangle,
+/// and against those of its vertices and edges not yet tested in this query.
+/// A vertex or edge lifts the cutter to the same height whenever it is tested,
+/// so testing it once, with the first triangle that uses it, is enough.
+/// The bounding-box tests and the facet- and edge-drops read the precomputed
+/// MeshFaceData and MeshEdgeData, not the Triangles of the kd-tree.
+/// The drops are made by the MeshDropEngine e, of the type of the cutter.
+/// The StampsT records which vertices and edges have been tested.
+template <class CutterT, class StampsT = QueryStamps>
+class MeshDropVisitor {
+    public:
+        MeshDropVisitor(const std::vector<unsigned int>* o, const IndexedMesh* m, const MeshDropEngine<CutterT>& e, 
+                        CLPoint& p, const StampsT& s) 
+            : calls(0), pruned(0), contact(MeshQuery::NO_FACE), order(o), mesh(m), fd(m->faceData()), engine(e), 
+              radius(e.getCutter()->getRadius()), cl(p), stamps(s) {}
+        void operator()(unsigned int n) {
+            visitOverlapping( (*order)[n] );
+        }
+        /// visitFace(f), if face f overlaps the cutter and is not below cl
+        void visitOverlapping(unsigned int f) {
+            // as MillingCutter::overlaps() and CLPoint::below()
+            if ( (fd.maxx[f] < cl.x-radius) || (fd.minx[f] > cl.x+radius) || 
+                 (fd.maxy[f] < cl.y-radius) || (fd.miny[f] > cl.y+radius) || (cl.z >= fd.maxz[f]) )
+                return;
+            visitFace(f);
+        }
+        /// drop against face f, and against those of its vertices and edges not yet tested,
+        /// unless the XY-projection of f is outside the footprint of the cutter
+        void visitFace(unsigned int f) {
+            if ( fd.outsideCircle(f, cl.x, cl.y, radius) ) {
+                ++pruned;
+                return;
+            }
+            ++calls;
+            const double z0 = cl.z;
+            engine.facetDrop(cl, *mesh, f);
+            const MeshFace& face = mesh->face(f);
+            for (int m=0; m<3; ++m) {
+                const unsigned int v = face.v[m];
+                if ( stamps.firstVertex(v) ) {
+                    // a vertex can only lift the cutter if it is above cl.z
+                    if ( mesh->vertex(v).z > cl.z )
+                        engine.vertexDrop( cl, mesh->vertex(v) );
+                }
+            }
+            for (int m=0; m<3; ++m) {
+                const unsigned int e = face.e[m];
+                if ( stamps.firstEdge(e) ) {
+                    const Point& p1 = mesh->vertex( mesh->edge(e).v[0] );
+                    const Point& p2 = mesh->vertex( mesh->edge(e).v[1] );
+                    // an edge can only lift the cutter if some part of it is above cl.z
+                    if ( std::max(p1.z, p2.z) > cl.z )
+                        engine.edgeDrop( cl, *mesh, e );
+                }
+            }
+            if ( cl.z > z0 )
+                contact = f;
+        }
+        /// number of triangles dropped against
+        int calls;
+        /// number of triangles overlapping the bounding-box of the cutter, but not its footprint
+        int pruned;
+        /// the last face that lifted the cutter, or MeshQuery::NO_FACE
+        unsigned int contact;
+    private:
+        /// the face of each kd-tree index, 0 when the faces are given to visitFace()
+        const std::vector<unsigned int>* order;
+        const IndexedMesh* mesh;
+        const MeshFaceData& fd;
+        const MeshDropEngine<CutterT>& engine;
+        const double radius;
+        CLPoint& cl;
+        StampsT stamps;
+};
+
+/// visitor for the batched MeshQuery::dropCutter(). Collects the found triangles into
+/// batches of DropKernel::WIDTH, and drops against the facets of a batch, then against
+/// the not yet tested vertices of the batch with DropKernel, and last against the edges
+/// with the MeshDropEngine. As in MeshDropVisitor each vertex and edge is tested once.
+/// Call flush() after the traversal, to drop against the last, partial, batch.
+template <class CutterT, class StampsT = QueryStamps>
+class MeshBatchDropVisitor {
+    public:
+        MeshBatchDropVisitor(const std::vector<unsigned int>* o, const IndexedMesh* m, const DropKernel& k, 
+                             const MeshDropEngine<CutterT>& e, CLPoint& p, const StampsT& s) 
+            : calls(0), pruned(0), contact(MeshQuery::NO_FACE), order(o), mesh(m), fd(m->faceData()), kernel(k), 
+              engine(e), radius(k.getCutter()->getRadius()), cl(p), stamps(s), nbatch(0) {}
+        void operator()(unsigned int n) {
+            visitOverlapping( (*order)[n] );
+        }
+        /// visitFace(f), if face f overlaps the cutter and is not below cl
+        void visitOverlapping(unsigned int f) {
+            // as MillingCutter::overlaps() and CLPoint::below()
+            if ( (fd.maxx[f] < cl.x-radius) || (fd.minx[f] > cl.x+radius) || 
+                 (fd.maxy[f] < cl.y-radius) || (fd.miny[f] > cl.y+radius) || (cl.z >= fd.maxz[f]) )
+                return;
+            visitFace(f);
+        }
+        /// add face f to the batch, unless its XY-projection is outside the footprint of the cutter
+        void visitFace(unsigned int f) {
+            if ( fd.outsideCircle(f, cl.x, cl.y, radius) ) {
+                ++pruned;
+                return;
+            }
+            ++calls;
+            batch[nbatch++] = f;
+            if ( nbatch == DropKernel::WIDTH )
+                flush();
+        }
+        /// drop against the triangles of the batch
+        void flush() {
+            if ( nbatch == 0 )
+                return;
+            const double z0 = cl.z;
+            kernel.facetDrop( cl, *mesh, batch, nbatch );
+            unsigned int verts[DropKernel::WIDTH];
+            int nverts = 0;
+            for (int b=0; b<nbatch; ++b) {
+                const MeshFace& face = mesh->face( batch[b] );
+                for (int m=0; m<3; ++m) {
+                    const unsigned int v = face.v[m];
+                    if ( stamps.firstVertex(v) ) {
+                        if ( mesh->vertex(v).z > cl.z ) {
+                            verts[nverts++] = v;
+                            if ( nverts == DropKernel::WIDTH ) {
+                                kernel.vertexDrop( cl, *mesh, verts, nverts );
+                                nverts = 0;
+                            }
+                        }
+                    }
+                }
+            }
+            if ( nverts > 0 )
+                kernel.vertexDrop( cl, *mesh, verts, nverts );
+            for (int b=0; b<nbatch; ++b) {
+                const MeshFace& face = mesh->face( batch[b] );
+                for (int m=0; m<3; ++m) {
+                    const unsigned int e = face.e[m];
+                    if ( stamps.firstEdge(e) ) {
+                        const Point& p1 = mesh->vertex( mesh->edge(e).v[0] );
+                        const Point& p2 = mesh->vertex( mesh->edge(e).v[1] );
+                        if ( std::max(p1.z, p2.z) > cl.z )
+                            engine.edgeDrop( cl, *mesh, e );
+                    }
+                }
+            }
+            if ( cl.z > z0 )
+                contact = contactFace();
+            nbatch = 0;
+        }
+        /// number of triangles dropped against
+        int calls;
+        /// number of triangles overlapping the bounding-box of the cutter, but not its footprint
+        int pruned;
+        /// a face of the last batch that lifted the cutter, or MeshQuery::NO_FACE
+        unsigned int contact;
+    private:
+        /// the face of the batch whose plane is nearest to the CC-point. The CC-point of a 
+        /// facet contact is in the plane of the face, and that of a vertex or edge contact 
+        /// in the planes of all faces of the batch that use the vertex or edge.
+        unsigned int contactFace() const {
+            unsigned int best = batch[0];
+            double dmin = -1.0;
+            for (int b=0; b<nbatch; ++b) {
+                const unsigned int f = batch[b];
+                const double dist = fabs( fd.nx[f]*cl.cc.x + fd.ny[f]*cl.cc.y + fd.nz[f]*cl.cc.z + fd.d[f] );
+                if ( (dmin < 0.0) || (dist < dmin) ) {
+                    dmin = dist;
+                    best = f;
+                }
+            }
+            return best;
+        }
+        /// the face of each kd-tree index, 0 when the faces are given to visitFace()
+        const std::vector<unsigned int>* order;
+        const IndexedMesh* mesh;
+        const MeshFaceData& fd;
+        const DropKernel& kernel;
+        const MeshDropEngine<CutterT>& engine;
+        const double radius;
+        CLPoint& cl;
+        StampsT stamps;
+        /// the faces of the current batch
+        unsigned int batch[DropKernel::WIDTH];
+        /// number of faces in the batch
+        int nbatch;
+};
+
+/// visitor for the packet MeshQuery::dropCutter(). Drops against face order[n] with the 
+/// per-CL-point visitor of each CL-point in the mask given by KDTree::visit_packet_drop(), 
+/// which has already made the overlap and below tests of MeshDropVisitor::operator().
+template <class PointVisitor>
+class MeshPacketDropVisitor {
+    public:
+        MeshPacketDropVisitor(const std::vector<unsigned int>& o, std::vector<PointVisitor>& pv) 
+            : order(o), visitors(pv) {}
+        void operator()(unsigned int n, PacketMask mask) {
+            const unsigned int f = order[n];
+            for (; mask; mask &= mask-1)
+                visitors[ KDTree<Triangle>::lowest(mask) ].visitFace(f);
+        }
+    private:
+        const std::vector<unsigned int>& order;
+        std::vector<PointVisitor>& visitors;
+};
+
+/// visit the faces around face f with drop, each once: first f, then the faces sharing a corner with f.
+/// At most maxWarm faces are visited.
+template <class VisitorT>
+void warmStart(const IndexedMesh* mesh, unsigned int f, VisitorT& drop) {
+    enum { maxWarm = 32 };
+    unsigned int near[maxWarm];
+    unsigned int nnear = 0;
+    near[nnear++] = f;
+    drop.visitOverlapping(f);
+    const MeshFace& face = mesh->face(f);
+    for (int m=0; m<3; ++m) {
+        const unsigned int* vf = mesh->vertexFaces( face.v[m] );
+        const unsigned int nvf = mesh->numVertexFaces( face.v[m] );
+        for (unsigned int k=0; k<nvf; ++k) {
+            if ( std::find( near, near+nnear, vf[k] ) != near+nnear )
+                continue;
+            if ( nnear == maxWarm )
+                return;
+            near[nnear++] = vf[k];
+            drop.visitOverlapping( vf[k] );
+        }
+    }
+}
+
+MeshQuery::MeshQuery(const IndexedMesh* m) : mesh(m), stamp(0), pruned(0), contact(NO_FACE), warm(false) {
+    vstamp.resize( mesh->numVertices(), 0 );
+    estamp.resize( mesh->numEdges(), 0 );
+    vslot.resize( mesh->numVertices() );
+    eslot.resize( mesh->numEdges() );
+}
+
+void MeshQuery::newQuery() {
+    ++stamp;
+    if (stamp == 0) { // wrapped around, old stamps could match again
+        std::fill( vstamp.begin(), vstamp.end(), 0 );
+        std::fill( estamp.begin(), estamp.end(), 0 );
+        stamp = 1;
+    }
+}
+
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const MillingCutter* c, CLPoint& cl) {
+    return dropCutter( t, MeshDropEngine<MillingCutter>(c), cl );
+}
+
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const DropKernel& k, CLPoint& cl) {
+    return dropCutter( t, k, MeshDropEngine<MillingCutter>(k.getCutter()), cl );
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const MeshDropEngine<CutterT>& e, CLPoint& cl) {
+    newQuery();
+    MeshDropVisitor<CutterT> drop( &t->getOrder(), mesh, e, cl, QueryStamps(vstamp, estamp, stamp) );
+    if ( warm && (contact != NO_FACE) )
+        warmStart( mesh, contact, drop );
+    t->visit_cutter_drop( e.getCutter(), &cl, drop );
+    pruned += drop.pruned;
+    contact = drop.contact;
+    return drop.calls;
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const DropKernel& k, const MeshDropEngine<CutterT>& e, 
+                          CLPoint& cl) {
+    newQuery();
+    MeshBatchDropVisitor<CutterT> drop( &t->getOrder(), mesh, k, e, cl, QueryStamps(vstamp, estamp, stamp) );
+    if ( warm && (contact != NO_FACE) ) {
+        warmStart( mesh, contact, drop );
+        drop.flush(); // lift cl before the kd-tree traversal
+    }
+    t->visit_cutter_drop( k.getCutter(), &cl, drop );
+    drop.flush();
+    pruned += drop.pruned;
+    contact = drop.contact;
+    return drop.calls;
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const unsigned int* f, unsigned int n, const MeshDropEngine<CutterT>& e, CLPoint& cl) {
+    newQuery();
+    MeshDropVisitor<CutterT> drop( 0, mesh, e, cl, QueryStamps(vstamp, estamp, stamp) );
+    const MeshFaceData& fd = mesh->faceData();
+    for (unsigned int m=0; m<n; ++m) {
+        if ( cl.z >= fd.maxz[ f[m] ] ) // the rest of the faces are lower
+            break;
+        drop.visitFace( f[m] );
+    }
+    pruned += drop.pruned;
+    return drop.calls;
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const unsigned int* f, unsigned int n, const DropKernel& k, 
+                          const MeshDropEngine<CutterT>& e, CLPoint& cl) {
+    newQuery();
+    MeshBatchDropVisitor<CutterT> drop( 0, mesh, k, e, cl, QueryStamps(vstamp, estamp, stamp) );
+    const MeshFaceData& fd = mesh->faceData();
+    for (unsigned int m=0; m<n; ++m) {
+        if ( cl.z >= fd.maxz[ f[m] ] ) // the rest of the faces are lower
+            break;
+        drop.visitFace( f[m] );
+    }
+    drop.flush();
+    pruned += drop.pruned;
+    return drop.calls;
+}
+
+void MeshQuery::newPacket() {
+    newQuery();
+    if ( vmask.empty() ) { // allocated at the first packet query
+        vmask.resize( mesh->numVertices() );
+        emask.resize( mesh->numEdges() );
+    }
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const MeshDropEngine<CutterT>& e, CLPoint* const* cls, 
+                          unsigned int n) {
+    newPacket();
+    typedef MeshDropVisitor<CutterT, PacketStamps> PointVisitor;
+    std::vector<PointVisitor> visitors;
+    visitors.reserve(n);
+    for (unsigned int k=0; k<n; ++k)
+        visitors.push_back( PointVisitor( 0, mesh, e, *cls[k], PacketStamps(vstamp, estamp, vmask, emask, stamp, k) ) );
+    MeshPacketDropVisitor<PointVisitor> drop( t->getOrder(), visitors );
+    t->visit_packet_drop( e.getCutter(), cls, n, drop );
+    int calls = 0;
+    for (unsigned int k=0; k<n; ++k) {
+        calls += visitors[k].calls;
+        pruned += visitors[k].pruned;
+    }
+    return calls;
+}
+
+template <class CutterT>
+int MeshQuery::dropCutter(const KDTree<Triangle>* t, const DropKernel& k, const MeshDropEngine<CutterT>& e, 
+                          CLPoint* const* cls, unsigned int n) {
+    newPacket();
+    typedef MeshBatchDropVisitor<CutterT, PacketStamps> PointVisitor;
+    std::vector<PointVisitor> visitors;
+    visitors.reserve(n);
+    for (unsigned int m=0; m<n; ++m)
+        visitors.push_back( PointVisitor( 0, mesh, k, e, *cls[m], PacketStamps(vstamp, estamp, vmask, emask, stamp, m) ) );
+    MeshPacketDropVisitor<PointVisitor> drop( t->getOrder(), visitors );
+    t->visit_packet_drop( k.getCutter(), cls, n, drop );
+    int calls = 0;
+    for (unsigned int m=0; m<n; ++m) {
+        visitors[m].flush();
+        calls += visitors[m].calls;
+        pruned += visitors[m].pruned;
+    }
+    return calls;
+}
+
+// the cutter types with a MeshDropEngine of their own
+#define OCL_MESHQUERY_DROPCUTTER(CutterT) \
+    template int MeshQuery::dropCutter(const KDTree<Triangle>*, const MeshDropEngine<CutterT>&, CLPoint&); \
+    template int MeshQuery::dropCutter(const KDTree<Triangle>*, const DropKernel&, \
+                                       const MeshDropEngine<CutterT>&, CLPoint&); \
+    template int MeshQuery::dropCutter(const unsigned int*, unsigned int, const MeshDropEngine<CutterT>&, \
+                                       CLPoint&); \
+    template int MeshQuery::dropCutter(const unsigned int*, unsigned int, const DropKernel&, \
+                                       const MeshDropEngine<CutterT>&, CLPoint&); \
+    template int MeshQuery::dropCutter(const KDTree<Triangle>*, const MeshDropEngine<CutterT>&, \
+                                       CLPoint* const*, unsigned int); \
+    template int MeshQuery::dropCutter(const KDTree<Triangle>*, const DropKernel&, \
+                                       const MeshDropEngine<CutterT>&, CLPoint* const*, unsigned int);
+OCL_MESHQUERY_DROPCUTTER(MillingCutter)
+OCL_MESHQUERY_DROPCUTTER(CylCutter)
+OCL_MESHQUERY_DROPCUTTER(BallCutter)
+OCL_MESHQUERY_DROPCUTTER(BullCutter)
+OCL_MESHQUERY_DROPCUTTER(ConeCutter)
+#undef OCL_MESHQUERY_DROPCUTTER
+
+// a push-cutter Interval of one triangle runs from its lowest to its highest contact,
+// which may come from different features (e.g. a facet contact and an edge contact).
+// So the vertex and edge Intervals are computed once, and merged into every triangle that uses them.
+int MeshQuery::pushCutter(const KDTree<Triangle>* t, const std::vector<unsigned int>& idx, 
+                          const MillingCutter* c, Fiber& f) {
+    return pushCutter( t->getOrder(), idx, c, f );
+}
+
+int MeshQuery::pushCutter(const std::vector<unsigned int>& faces, const std::vector<unsigned int>& idx, 
+                          const MillingCutter* c, Fiber& f) {
+    newQuery();
+    ints.clear();
+    BOOST_FOREACH( unsigned int n, idx ) {
+        Interval i;
+        c->meshFacetPush( f, i, *mesh, faces[n] );
+        const MeshFace& face = mesh->face( faces[n] );
+        for (int m=0; m<3; ++m) {
+            const unsigned int v = face.v[m];
+            if ( vstamp[v] != stamp ) {
+                vstamp[v] = stamp;
+                vslot[v] = ints.size();
+                ints.push_back( Interval() );
+                c->singleVertexPush( f, ints.back(), mesh->vertex(v) );
+            }
+            merge( i, ints[ vslot[v] ] );
+        }
+        for (int m=0; m<3; ++m) {
+            const unsigned int e = face.e[m];
+            if ( estamp[e] != stamp ) {
+                estamp[e] = stamp;
+                eslot[e] = ints.size();
+                ints.push_back( Interval() );
+                const MeshEdge& edge = mesh->edge(e);
+                if ( edge.v[0] != edge.v[1] ) // not collapsed by welding
+                    c->singleEdgePush( f, ints.back(), mesh->vertex(edge.v[0]), mesh->vertex(edge.v[1]) );
+            }
+            merge( i, ints[ eslot[e] ] );
+        }
+        f.addInterval( i );
+    }
+    return idx.size();
+}
+
+void MeshQuery::merge(Interval& i, Interval& feature) {
+    if ( feature.upper_cc.type == NONE ) // no contact
+        return;
+    i.updateLower( feature.lower, feature.lower_cc );
+    i.updateUpper( feature.upper, feature.upper_cc );
+}
+
+} // end namespace
+// end file meshquery.cpp
@@ -0,0 +1,158 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MESHQUERY_H
+#define MESHQUERY_H
+
+#include <vector>
+
+#include "triangle.hpp"
+#include "kdtree.hpp"
+#include "interval.hpp"
+
+namespace ocl
+{
+
+class IndexedMesh;
+class MillingCutter;
+class DropKernel;
+template <class CutterT> class MeshDropEngine;
+class CLPoint;
+class Fiber;
+
+/// a set of the CL-points of a packet query, see KDTree::visit_packet_drop()
+typedef KDTree<Triangle>::PacketMask PacketMask;
+
+/// \brief drop-cutter and push-cutter against an IndexedMesh
+///
+/// MillingCutter::dropCutter() and MillingCutter::pushCutter() test the three
+/// vertices and three edges of every triangle, so a vertex shared by six triangles
+/// is tested six times, and an edge twice. MeshQuery tests the facet of each
+/// triangle found in the kd-tree, but each vertex and edge only once, by stamping
+/// the vertices and edges already tested in this query. Facets and edges are
+/// tested with MillingCutter::meshFacetDrop(), meshEdgeDrop() and meshFacetPush(),
+/// which read the data precomputed in IndexedMesh::faceData() and edgeData().
+///
+/// A triangle is dropped against only if its XY-projection is inside the circular footprint
+/// of the cutter, see MeshFaceData::outsideCircle().
+///
+/// With setWarmStart(true), a drop at a CL-point first tests the face that lifted the cutter 
+/// in the previous query, and the faces around it. When the CL-points are close together, 
+/// as along a path, this lifts the cutter near its final height before the kd-tree traversal, 
+/// which then skips the triangles below it. The height found is the same, only the CCPoint 
+/// may be another one of the same height. Faces of the warm start which the kd-tree also finds 
+/// are dropped against twice, but their vertices and edges only once.
+///
+/// The stamps make a MeshQuery stateful: use one MeshQuery per thread.
+/// The kd-tree must be built from the surface of the mesh.
+class MeshQuery {
+    public:
+        /// no face, see getContact()
+        static const unsigned int NO_FACE = 0xffffffffu;
+        /// create a query object for mesh m
+        MeshQuery(const IndexedMesh* m);
+        /// start the kd-tree dropCutter() calls for a single CL-point at the previous contact, see above. 
+        /// The default is false.
+        void setWarmStart(bool w) {warm = w;}
+        /// the face that lifted the cutter last in the previous kd-tree dropCutter() call for a 
+        /// single CL-point, or NO_FACE
+        unsigned int getContact() const {return contact;}
+        /// drop cutter c at cl against the surface, using the XY kd-tree t.
+        /// returns the number of triangles dropped against
+        int dropCutter(const KDTree<Triangle>* t, const MillingCutter* c, CLPoint& cl);
+        /// as dropCutter(), but the facets and vertices are dropped against in batches,
+        /// with the DropKernel k of the cutter
+        int dropCutter(const KDTree<Triangle>* t, const DropKernel& k, CLPoint& cl);
+        /// as dropCutter(), with the drops of MeshDropEngine e, which calls the cutter without 
+        /// virtual calls. Instantiated for MillingCutter (with virtual calls), CylCutter, BallCutter, 
+        /// BullCutter and ConeCutter.
+        template <class CutterT>
+        int dropCutter(const KDTree<Triangle>* t, const MeshDropEngine<CutterT>& e, CLPoint& cl);
+        /// as the batched dropCutter(), with the edge-drops of MeshDropEngine e. Instantiated as above.
+        template <class CutterT>
+        int dropCutter(const KDTree<Triangle>* t, const DropKernel& k, const MeshDropEngine<CutterT>& e, 
+                       CLPoint& cl);
+        /// drop against the faces f[0] ... f[n-1] of the mesh, with MeshDropEngine e, instead of those 
+        /// found in a kd-tree. The faces must overlap the cutter in XY, and be sorted by decreasing 
+        /// MeshFaceData::maxz: the drop stops at the first face below cl. Instantiated as above.
+        template <class CutterT>
+        int dropCutter(const unsigned int* f, unsigned int n, const MeshDropEngine<CutterT>& e, CLPoint& cl);
+        /// as above, with facets and vertices dropped against in batches with DropKernel k
+        template <class CutterT>
+        int dropCutter(const unsigned int* f, unsigned int n, const DropKernel& k, 
+                       const MeshDropEngine<CutterT>& e, CLPoint& cl);
+        /// drop with MeshDropEngine e at each of the n <= KDTree::maxPacket CL-points cls[0] ... cls[n-1], 
+        /// with one traversal of t for the whole packet, see KDTree::visit_packet_drop(). 
+        /// As the other dropCutter() each vertex and edge is tested once per CL-point.
+        /// Instantiated as above.
+        template <class CutterT>
+        int dropCutter(const KDTree<Triangle>* t, const MeshDropEngine<CutterT>& e, CLPoint* const* cls, 
+                       unsigned int n);
+        /// as the packet dropCutter() above, with facets and vertices dropped against in batches with DropKernel k
+        template <class CutterT>
+        int dropCutter(const KDTree<Triangle>* t, const DropKernel& k, const MeshDropEngine<CutterT>& e, 
+                       CLPoint* const* cls, unsigned int n);
+        /// the number of triangles that the dropCutter() calls of this MeshQuery have skipped because their
+        /// XY-projection is outside the circular footprint of the cutter, although their bounding-box
+        /// overlaps the square bounding-box of the cutter
+        int getPruned() const {return pruned;}
+        /// push cutter c along fiber f against the triangles idx of kd-tree t,
+        /// adding the intervals to f. returns the number of triangles pushed against
+        int pushCutter(const KDTree<Triangle>* t, const std::vector<unsigned int>& idx, 
+                       const MillingCutter* c, Fiber& f);
+        /// as above, where the triangles idx are positions in faces, the face indices of the mesh
+        int pushCutter(const std::vector<unsigned int>& faces, const std::vector<unsigned int>& idx, 
+                       const MillingCutter* c, Fiber& f);
+    protected:
+        /// start a new query, so that all vertices and edges are un-tested
+        void newQuery();
+        /// start a new packet query
+        void newPacket();
+        /// extend Interval i with the Interval of a vertex or edge, if there was a contact
+        static void merge(Interval& i, Interval& feature);
+        /// the mesh
+        const IndexedMesh* mesh;
+        /// vstamp[n] == stamp when vertex n has been tested in this query
+        std::vector<unsigned int> vstamp;
+        /// estamp[n] == stamp when edge n has been tested in this query
+        std::vector<unsigned int> estamp;
+        /// the current query
+        unsigned int stamp;
+        /// in a packet query, vmask[n] is the set of CL-points that have tested vertex n, if vstamp[n] == stamp
+        std::vector<PacketMask> vmask;
+        /// as vmask, for the edges
+        std::vector<PacketMask> emask;
+        /// vslot[n] is the position in ints of the Interval of vertex n
+        std::vector<unsigned int> vslot;
+        /// eslot[n] is the position in ints of the Interval of edge n
+        std::vector<unsigned int> eslot;
+        /// the vertex and edge Intervals of a pushCutter() query
+        std::vector<Interval> ints;
+        /// see getPruned()
+        int pruned;
+        /// see getContact()
+        unsigned int contact;
+        /// see setWarmStart()
+        bool warm;
+};
+
+} // end namespace
+#endif
+// end file meshquery.hpp
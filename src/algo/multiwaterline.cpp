@@ -0,0 +1,221 @@
+/*  $Id$
+ * 
+ *  Copyright 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <boost/foreach.hpp> 
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "millingcutter.hpp"
+#include "point.hpp"
+#include "triangle.hpp"
+#include "multiwaterline.hpp"
+#include "meshquery.hpp"
+#include "weave.hpp"
+#include "zslabindex.hpp"
+
+namespace ocl
+{
+
+//********   ********************** */
+
+MultiWaterline::MultiWaterline() : Waterline() {
+    batchSize = 16;
+    slabHeight = 0.0;
+    lengthLimit = false;
+}
+
+MultiWaterline::~MultiWaterline() {
+}
+
+void MultiWaterline::setZ(const std::vector<double>& z) {
+    levels.clear();
+    BOOST_FOREACH( double zh, z ) {
+        appendZ( zh );
+    }
+}
+
+void MultiWaterline::appendZ(double z) {
+    levels.push_back( Level(z) );
+}
+
+// push the fibers of all levels in batches, and build the weave of each level
+// on the thread that pushed its last batch
+void MultiWaterline::run() {
+    std::vector<Batch> batches;
+    init_levels(batches);
+    std::cout << "MultiWaterline with " << levels.size() << " levels and " << batches.size() << " batches of "; 
+    std::cout << batchSize << " fibers, " << surf->tris.size() << " triangles." << std::endl;
+    // build the mesh before the threads share it. The kd-trees of the slabs are built when needed
+    index->mesh();
+    // without the length limit the bands reach from their slab to the top of the surface
+    double reach = cutter->getLength();
+    if ( !lengthLimit )
+        reach = std::max( reach, surf->bb.maxpt.z - surf->bb.minpt.z );
+    ZSlabIndex zindex( *surf, ( slabHeight > 0.0 ? slabHeight : cutter->getLength() ), 
+                       reach, index->getBucketSize() );
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    unsigned int next = 0; // the next batch to push
+    std::vector<unsigned int> finished; // levels that are ready, but not yet delivered
+    int calls = 0;
+    #pragma omp parallel shared(next, finished) reduction(+:calls)
+    {
+    MeshQuery query( index->mesh() ); // per-thread vertex and edge stamps
+    std::vector<unsigned int> tri_idx; // per-thread buffer, re-used between fibers
+    bool master = true;
+#ifdef _OPENMP
+    master = ( omp_get_thread_num() == 0 );
+#endif
+    while (true) {
+        unsigned int b;
+        #pragma omp critical (multiwaterline)
+        {
+            b = next++;
+        }
+        if ( b >= batches.size() )
+            break;
+        calls += push( batches[b], zindex, reach, query, tri_idx );
+        Level& l = levels[ batches[b].level ];
+        bool last;
+        #pragma omp critical (multiwaterline)
+        {
+            last = ( --l.remaining == 0 );
+        }
+        if (last) { // all fibers of the level are pushed, so it can be woven
+            weave_level(l);
+            #pragma omp critical (multiwaterline)
+            {
+                finished.push_back( batches[b].level );
+            }
+        }
+        if (master)
+            deliver(finished);
+    }
+    } // OpenMP parallel region ends here
+    deliver(finished);
+    this->nCalls = calls;
+    std::cout << zindex.str() << std::endl;
+    std::cout << "MultiWaterline done." << std::endl;
+}
+
+void MultiWaterline::init_levels(std::vector<Batch>& batches) {
+    double minx = surf->bb.minpt.x - 2*cutter->getRadius();
+    double maxx = surf->bb.maxpt.x + 2*cutter->getRadius();
+    double miny = surf->bb.minpt.y - 2*cutter->getRadius();
+    double maxy = surf->bb.maxpt.y + 2*cutter->getRadius();
+    int Nx = (int)( (maxx-minx)/sampling );
+    int Ny = (int)( (maxy-miny)/sampling );
+    std::vector<double> xvals = generate_range(minx,maxx,Nx);
+    std::vector<double> yvals = generate_range(miny,maxy,Ny);
+    for (unsigned int n=0; n<levels.size(); ++n) {
+        Level& l = levels[n];
+        l.xfibers.clear();
+        l.yfibers.clear();
+        l.loops.clear();
+        l.done = false;
+        BOOST_FOREACH( double y, yvals ) {
+            l.xfibers.push_back( Fiber( Point( minx, y, l.z ), Point( maxx, y, l.z ) ) );
+        }
+        BOOST_FOREACH( double x, xvals ) {
+            l.yfibers.push_back( Fiber( Point( x, miny, l.z ), Point( x, maxy, l.z ) ) );
+        }
+        for (unsigned int m=0; m<l.xfibers.size(); m+=batchSize)
+            batches.push_back( Batch( n, true, m, std::min( m+batchSize, (unsigned int)l.xfibers.size() ) ) );
+        for (unsigned int m=0; m<l.yfibers.size(); m+=batchSize)
+            batches.push_back( Batch( n, false, m, std::min( m+batchSize, (unsigned int)l.yfibers.size() ) ) );
+        l.remaining = ( l.xfibers.size() + batchSize - 1 ) / batchSize + ( l.yfibers.size() + batchSize - 1 ) / batchSize;
+    }
+}
+
+// x-fibers are pushed against the YZ kd-tree, and y-fibers against the XZ kd-tree, of the ZSlabIndex band 
+// of the level. The trees hold only the triangles of the z-slab of the level, and the triangles within 
+// reach above it. The found triangles are mapped to faces of the IndexedMesh with yzFaces() or xzFaces().
+int MultiWaterline::push(const Batch& b, const ZSlabIndex& zindex, double reach, MeshQuery& query, 
+                         std::vector<unsigned int>& tri_idx) {
+    std::vector<Fiber>& fibers = b.xfibers ? levels[b.level].xfibers : levels[b.level].yfibers;
+    unsigned int s = zindex.slab( levels[b.level].z );
+    const KDTree<Triangle>* tree = b.xfibers ? zindex.yzTree(s) : zindex.xzTree(s);
+    const std::vector<unsigned int>& faces = b.xfibers ? zindex.yzFaces(s) : zindex.xzFaces(s);
+    int calls = 0;
+    for (unsigned int n=b.begin; n<b.end; ++n) {
+        CLPoint cl; // cl-point on the fiber
+        if ( b.xfibers ) {
+            cl.x=0;
+            cl.y=fibers[n].p1.y;
+            cl.z=fibers[n].p1.z;
+        } else {
+            cl.x=fibers[n].p1.x;
+            cl.y=0;
+            cl.z=fibers[n].p1.z;
+        }
+        const double r = cutter->getRadius();
+        tree->search( Bbox( cl.x-r, cl.x+r, cl.y-r, cl.y+r, cl.z, cl.z+reach ), tri_idx );
+        // a bucket of the tree may hold triangles outside the searched box. These are dropped, 
+        // so that the triangles pushed against do not depend on the layout of the buckets, or on the slab-height
+        const double side = b.xfibers ? cl.y : cl.x;
+        unsigned int found = 0;
+        BOOST_FOREACH( unsigned int m, tri_idx ) {
+            const Bbox& bb = tree->get(m).bb;
+            const double side_min = b.xfibers ? bb.minpt.y : bb.minpt.x;
+            const double side_max = b.xfibers ? bb.maxpt.y : bb.maxpt.x;
+            if ( side_max >= side - r && side_min <= side + r &&
+                 bb.maxpt.z >= cl.z && bb.minpt.z <= cl.z + reach )
+                tri_idx[found++] = m;
+        }
+        tri_idx.resize( found );
+        calls += query.pushCutter( faces, tri_idx, cutter, fibers[n] );
+    }
+    return calls;
+}
+
+void MultiWaterline::weave_level(Level& l) {
+    weave2::Weave weave;
+    BOOST_FOREACH( Fiber& f, l.xfibers ) {
+        weave.addFiber(f);
+    }
+    BOOST_FOREACH( Fiber& f, l.yfibers ) {
+        weave.addFiber(f);
+    }
+    weave.build(); 
+    weave.face_traverse();
+    l.loops = weave.getLoops();
+    std::vector<Fiber>().swap( l.xfibers );
+    std::vector<Fiber>().swap( l.yfibers );
+}
+
+void MultiWaterline::deliver(std::vector<unsigned int>& finished) {
+    std::vector<unsigned int> ready;
+    #pragma omp critical (multiwaterline)
+    {
+        ready.swap(finished);
+    }
+    BOOST_FOREACH( unsigned int n, ready ) {
+        levels[n].done = true;
+        levelDone(n);
+    }
+}
+
+}// end namespace
+// end file multiwaterline.cpp
@@ -0,0 +1,141 @@
+/*  $Id$
+ * 
+ *  Copyright 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MULTIWATERLINE_H
+#define MULTIWATERLINE_H
+
+#include <vector>
+
+#include "point.hpp"
+#include "fiber.hpp"
+#include "waterline.hpp"
+
+namespace ocl
+{
+
+class MeshQuery;
+class ZSlabIndex;
+
+/// \brief Waterline toolpaths at many z-heights, computed in one parallel run
+
+/// MultiWaterline computes the waterline loops of a list of z-heights.
+/// The triangles are sorted into slabs of z-height by a ZSlabIndex. The x- and y-fibers of a level 
+/// are pushed against the YZ and XZ kd-trees of the slab of the level, which hold only the triangles 
+/// within reach of the slab. These trees are built when a level in the slab is first pushed. 
+/// The YZ and XZ kd-trees of the SurfaceIndex are not built or used, only its IndexedMesh.
+/// The fibers are split into batches, and the batches of all levels,
+/// in order of level, are shared out to one pool of OpenMP threads.
+/// The thread that pushes the last batch of a level builds the Weave of the level and
+/// extracts its loops, while the other threads go on pushing the fibers of later levels.
+/// levelDone() is called on the thread that called run() as soon as possible after the
+/// loops of a level are ready.
+/// As Waterline::run(), a fiber is pushed against all triangles above it within the cutter radius, 
+/// so the loops are the same as those of Waterline. With setLengthLimit(true) only the triangles within 
+/// the cutter length above the fiber are pushed against, which gives smaller bands and trees, but the loops
+/// differ from those of Waterline where the part rises more than the cutter length above z.
+class MultiWaterline : public Waterline {
+    public:
+        /// create an empty MultiWaterline object
+        MultiWaterline(); 
+        virtual ~MultiWaterline();
+        
+        /// set the z-heights of the waterlines, replacing any earlier ones
+        void setZ(const std::vector<double>& z);
+        /// add a z-height
+        void appendZ(double z);
+        /// set the number of fibers in each batch that is scheduled to a thread
+        void setBatchSize(unsigned int n) {batchSize = n;}
+        /// set the height of the z-slabs of the ZSlabIndex. The default, 0, uses the cutter length
+        void setSlabHeight(double h) {slabHeight = h;}
+        /// if true, push the cutter only against the triangles within the cutter length above a fiber.
+        /// The default, false, pushes against all triangles above it, as Waterline
+        void setLengthLimit(bool l) {lengthLimit = l;}
+        /// run the MultiWaterline algorithm. setSTL, setCutter, setSampling, and setZ must
+        /// be called before a call to run()
+        virtual void run();
+        
+        /// the number of z-heights
+        unsigned int numLevels() const {return levels.size();}
+        /// the z-height of level n
+        double getZ(unsigned int n) const {return levels[n].z;}
+        /// true when the loops of level n are ready
+        bool isDone(unsigned int n) const {return levels[n].done;}
+        /// the waterline loops of level n
+        const std::vector< std::vector<Point> >& getLoops(unsigned int n) const {
+            return levels[n].loops;
+        }
+        
+    protected:
+        /// the fibers and loops of one z-height
+        struct Level {
+            /// a level at z-height zh
+            Level(double zh) : z(zh), remaining(0), done(false) {}
+            /// z-height
+            double z;
+            /// x-fibers, cleared when the loops are ready
+            std::vector<Fiber> xfibers;
+            /// y-fibers, cleared when the loops are ready
+            std::vector<Fiber> yfibers;
+            /// the number of batches not yet pushed
+            unsigned int remaining;
+            /// the waterline loops
+            std::vector< std::vector<Point> > loops;
+            /// true when levelDone() has been called
+            bool done;
+        };
+        /// fibers begin ... end-1 in the x- or y-fibers of a level
+        struct Batch {
+            /// batch of the x-fibers if x is true, otherwise of the y-fibers
+            Batch(unsigned int l, bool x, unsigned int b, unsigned int e) : level(l), xfibers(x), begin(b), end(e) {}
+            unsigned int level;
+            bool xfibers;
+            unsigned int begin;
+            unsigned int end;
+        };
+        
+        /// called on the thread that called run(), once for each level as soon as its loops are ready. 
+        /// Called in the order the levels are finished, which need not be the order of z.
+        virtual void levelDone(unsigned int n) {}
+        /// create the fibers of all levels, and split them into batches
+        void init_levels(std::vector<Batch>& batches);
+        /// push the cutter along the fibers of batch b, using the kd-trees of the slab of its level in zindex.
+        /// Triangles more than reach above a fiber are not pushed against.
+        /// return the number of triangles pushed against
+        int push(const Batch& b, const ZSlabIndex& zindex, double reach, MeshQuery& query, 
+                 std::vector<unsigned int>& tri_idx);
+        /// build the weave of level l and write its loops, then clear its fibers
+        void weave_level(Level& l);
+        /// mark the levels in finished as done, and call levelDone() for them
+        void deliver(std::vector<unsigned int>& finished);
+        
+    // DATA
+        /// the z-heights, fibers and loops
+        std::vector<Level> levels;
+        /// number of fibers in a batch
+        unsigned int batchSize;
+        /// height of the z-slabs, or 0 for the cutter length
+        double slabHeight;
+        /// push only against the triangles within the cutter length above a fiber
+        bool lengthLimit;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,79 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MULTIWATERLINE_PY_H
+#define MULTIWATERLINE_PY_H
+
+#include <boost/python.hpp>
+#include <boost/foreach.hpp>
+
+#include "multiwaterline.hpp"
+
+namespace ocl
+{
+
+/// Python wrapper for MultiWaterline
+class MultiWaterline_py : public MultiWaterline {
+    public:
+        MultiWaterline_py() : MultiWaterline() {}
+        ~MultiWaterline_py() {
+            std::cout << "~MultiWaterline_py()\n";
+        }
+        /// set the z-heights from a python list of floats
+        void py_setZ(const boost::python::list& zlist) {
+            std::vector<double> z;
+            for (int n=0; n<boost::python::len(zlist); ++n)
+                z.push_back( boost::python::extract<double>( zlist[n] ) );
+            setZ(z);
+        }
+        /// set a python callable, called with the level number as soon as the loops of a level are ready
+        void setCallback(boost::python::object f) {
+            callback = f;
+        }
+        /// return the loops of level n as a list of lists to python
+        boost::python::list py_getLoops(unsigned int n) const {
+            boost::python::list loop_list;
+            BOOST_FOREACH( const std::vector<Point>& loop, this->getLoops(n) ) {
+                boost::python::list point_list;
+                BOOST_FOREACH( Point p, loop ) {
+                    point_list.append( p );
+                }
+                loop_list.append(point_list);
+            }
+            return loop_list;
+        }
+    protected:
+        /// call the python callback. This runs on the thread that called run(), which holds the GIL.
+        virtual void levelDone(unsigned int n) {
+            if ( callback.is_none() )
+                return;
+            try {
+                callback(n);
+            } catch (boost::python::error_already_set&) {
+                PyErr_Print(); // an exception can not propagate out of the OpenMP region
+            }
+        }
+        /// the python callable, or None
+        boost::python::object callback;
+};
+
+} // end namespace
+
+#endif
@@ -25,9 +25,12 @@
 #include <string>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "point.hpp"
 #include "fiber.hpp"
 #include "kdtree.hpp"
+#include "surfaceindex.hpp"
 
 namespace ocl
 {
@@ -41,17 +44,27 @@ class MillingCutter;
 /// base-class for cam algorithms
 class Operation {
     public:
-        Operation() {}
+        Operation() : sampling(0.1), nCalls(0), nPruned(0), bucketSize(1), cutter(NULL), surf(NULL), root(NULL), nthreads(1) {}
         virtual ~Operation() {
             std::cout << "~Operation()\n";
         }
-        /// set the STL-surface and build kd-tree
+        /// set the STL-surface. A new SurfaceIndex is created for s, and 
+        /// shared with all sub-operations.
         virtual void setSTL(const STLSurf& s) {
-            surf = &s;
+            setSurfaceIndex( boost::shared_ptr<SurfaceIndex>( new SurfaceIndex(s, bucketSize) ) );
+        }
+        /// set the surface and its kd-trees from an existing SurfaceIndex.
+        /// Operations on the same STLSurf should share one SurfaceIndex, 
+        /// so that the kd-trees are built only once.
+        virtual void setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx) {
+            index = idx;
+            surf = &idx->getSTL();
             BOOST_FOREACH(Operation* op, subOp) {
-                op->setSTL(s);
+                op->setSurfaceIndex(idx);
             }
         }
+        /// return the SurfaceIndex used by this Operation
+        boost::shared_ptr<SurfaceIndex> getSurfaceIndex() const {return index;}
         /// set the MillingCutter to use
         virtual void setCutter(const MillingCutter* c) {
             cutter = c;
@@ -79,6 +92,9 @@ class Operation {
         }
         /// return number of low-level calls
         int getCalls() const {return nCalls;}
+        /// return the number of triangles that overlapped the bounding-box of the cutter,
+        /// but were skipped because they are outside its circular footprint (see MeshQuery)
+        int getPruned() const {return nPruned;}
         
         /// set the sampling interval for this Operation and all sub-operations
         virtual void setSampling(double s) {
@@ -120,14 +136,18 @@ class Operation {
         double sampling;
         /// how many low-level calls were made
         int nCalls;
+        /// how many triangles were pruned by the cutter footprint
+        int nPruned;
         /// size of bucket-node in KD-tree
         unsigned int bucketSize;
         /// the MillingCutter used
         const MillingCutter* cutter;
         /// the STLSurf which we test against.
         const STLSurf* surf;
-        /// root of a kd-tree
-        KDTree<Triangle>* root;
+        /// the shared kd-trees of surf
+        boost::shared_ptr<SurfaceIndex> index;
+        /// root of a kd-tree, owned by index
+        const KDTree<Triangle>* root;
         /// number of threads to use
         unsigned int nthreads;
         /// sub-operations, if any, of this operation
@@ -0,0 +1,100 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include "stlsurf.hpp"
+#include "surfaceindex.hpp"
+
+namespace ocl
+{
+
+SurfaceIndex::SurfaceIndex(const STLSurf& s, unsigned int bucket, double weld) 
+    : surf(&s), bucketSize(bucket), xy(NULL), yz(NULL), xz(NULL), weldTolerance(weld), imesh(NULL) {}
+
+SurfaceIndex::~SurfaceIndex() {
+    delete xy;
+    delete yz;
+    delete xz;
+    delete imesh;
+}
+
+const KDTree<Triangle>* SurfaceIndex::xyTree() const {
+    return getTree(xy, XY);
+}
+
+const KDTree<Triangle>* SurfaceIndex::yzTree() const {
+    return getTree(yz, YZ);
+}
+
+const KDTree<Triangle>* SurfaceIndex::xzTree() const {
+    return getTree(xz, XZ);
+}
+
+void SurfaceIndex::build() const {
+    xyTree();
+    yzTree();
+    xzTree();
+}
+
+const KDTree<Triangle>* SurfaceIndex::getTree(KDTree<Triangle>*& tree, Plane p) const {
+    KDTree<Triangle>* t;
+    // the first thread to ask for a tree builds it, other threads wait here
+    #pragma omp critical (surfaceindex)
+    {
+        if (!tree) {
+            KDTree<Triangle>* newtree = new KDTree<Triangle>();
+            if (p == XY)
+                newtree->setXYDimensions(); // drop-cutter, don't care about Z-coordinate
+            else if (p == YZ)
+                newtree->setYZDimensions(); // x-fibers
+            else
+                newtree->setXZDimensions(); // y-fibers
+            newtree->setBucketSize( bucketSize );
+            newtree->build( surf->tris );
+            tree = newtree;
+        }
+        t = tree;
+    }
+    return t;
+}
+
+const IndexedMesh* SurfaceIndex::mesh() const {
+    IndexedMesh* m;
+    #pragma omp critical (surfaceindex)
+    {
+        if (!imesh)
+            imesh = new IndexedMesh( *surf, weldTolerance );
+        m = imesh;
+    }
+    return m;
+}
+
+std::string SurfaceIndex::str() const {
+    std::ostringstream o;
+    o << "SurfaceIndex: " << surf->size() << " triangles, bucketSize=" << bucketSize;
+    o << ", trees built:" << (xy ? " XY" : "") << (yz ? " YZ" : "") << (xz ? " XZ" : "");
+    if (imesh)
+        o << ", " << imesh->str();
+    return o.str();
+}
+
+} // end namespace
+// end file surfaceindex.cpp
@@ -0,0 +1,94 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SURFACEINDEX_H
+#define SURFACEINDEX_H
+
+#include <boost/shared_ptr.hpp>
+
+#include "triangle.hpp"
+#include "kdtree.hpp"
+#include "indexedmesh.hpp"
+
+namespace ocl
+{
+
+class STLSurf;
+
+/// \brief the kd-trees of an STLSurf, built once and shared between Operations
+///
+/// Drop-cutter type operations search for triangles in the XY-plane,
+/// push-cutter along X-fibers in the YZ-plane, and push-cutter along Y-fibers
+/// in the XZ-plane. A SurfaceIndex builds each of these trees the first time
+/// it is requested, and after that hands out the same tree to every Operation.
+/// A job with many operations on one part (e.g. drop-cutter finishing and
+/// a waterline at every z-level) thus pays for kd-tree construction only once.
+/// The trees are never modified after they are built, so a SurfaceIndex
+/// may be used from many threads. The STLSurf must outlive the SurfaceIndex.
+class SurfaceIndex {
+    public:
+        /// create an index of surface s, with kd-tree bucket-size bucket,
+        /// and weld tolerance weld for the IndexedMesh
+        SurfaceIndex(const STLSurf& s, unsigned int bucket = 1, double weld = 1e-6);
+        virtual ~SurfaceIndex();
+        /// return the indexed surface
+        const STLSurf& getSTL() const {return *surf;}
+        /// return the kd-tree bucket-size
+        unsigned int getBucketSize() const {return bucketSize;}
+        /// kd-tree for searching in the XY-plane, used by drop-cutter
+        const KDTree<Triangle>* xyTree() const;
+        /// kd-tree for searching in the YZ-plane, used by push-cutter along X-fibers
+        const KDTree<Triangle>* yzTree() const;
+        /// kd-tree for searching in the XZ-plane, used by push-cutter along Y-fibers
+        const KDTree<Triangle>* xzTree() const;
+        /// shared-vertex mesh of the surface, used by the MeshQuery drop- and push-cutter paths
+        const IndexedMesh* mesh() const;
+        /// build all three kd-trees now, instead of on first use
+        void build() const;
+        /// string repr
+        std::string str() const;
+    protected:
+        /// plane of a kd-tree
+        enum Plane {XY, YZ, XZ};
+        /// return the tree for plane p, building it if needed
+        const KDTree<Triangle>* getTree(KDTree<Triangle>*& tree, Plane p) const;
+        /// the indexed surface
+        const STLSurf* surf;
+        /// bucket-size of the kd-trees
+        unsigned int bucketSize;
+        /// XY-plane kd-tree, or NULL when not built yet
+        mutable KDTree<Triangle>* xy;
+        /// YZ-plane kd-tree, or NULL when not built yet
+        mutable KDTree<Triangle>* yz;
+        /// XZ-plane kd-tree, or NULL when not built yet
+        mutable KDTree<Triangle>* xz;
+        /// weld tolerance of the IndexedMesh
+        double weldTolerance;
+        /// the IndexedMesh, or NULL when not built yet
+        mutable IndexedMesh* imesh;
+    private:
+        friend class SurfaceIndexCache; // restores saved trees
+        SurfaceIndex(const SurfaceIndex&); // non-copyable, the trees are owned
+        SurfaceIndex& operator=(const SurfaceIndex&);
+};
+
+} // end namespace
+
+#endif // end surfaceindex.hpp
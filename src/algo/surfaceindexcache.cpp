@@ -0,0 +1,367 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>   // std::rename, std::remove
+#include <cstring>  // std::memcpy
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <boost/foreach.hpp>
+
+#ifndef WIN32
+    #include <unistd.h> // getpid()
+#endif
+
+#include "stlsurf.hpp"
+#include "stlreader.hpp"
+#include "mappedfile.hpp"
+#include "indexedmesh.hpp"
+#include "surfaceindexcache.hpp"
+
+namespace ocl
+{
+
+/// first bytes of a cache-file
+static const char cache_magic[8] = {'O','C','L','I','N','D','E','X'};
+/// cache-file format version. Increase when the format, or the kd-tree build, changes.
+static const boost::uint32_t cache_version = 2;
+
+/// FNV-1a hash of n bytes at data, continuing from h
+static boost::uint64_t fnv1a(const unsigned char* data, std::size_t n, boost::uint64_t h) {
+    for (std::size_t i=0; i<n; ++i) {
+        h ^= data[i];
+        h *= 1099511628211ULL; // FNV prime
+    }
+    return h;
+}
+
+/// append the bytes of v to o
+template <class T>
+static void put(std::ostream& o, const T& v) {
+    o.write( reinterpret_cast<const char*>(&v), sizeof(T) );
+}
+
+/// read v from p, and advance p. Returns false if there are not enough bytes before end.
+template <class T>
+static bool get(const char*& p, const char* end, T& v) {
+    if ( static_cast<std::size_t>(end-p) < sizeof(T) )
+        return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+/// a kd-tree as read from a cache-file
+struct CachedTree {
+    std::vector<int> dims;
+    std::vector<KDNode> nodes;
+    std::vector<unsigned int> order;
+};
+
+/// read and check one tree of ntri objects
+static bool get_tree(const char*& p, const char* end, unsigned int ntri, CachedTree& t) {
+    boost::uint32_t ndims, nnodes, nobjs;
+    if ( !get(p, end, ndims) || ndims > 6 )
+        return false;
+    t.dims.resize(ndims);
+    for (unsigned int m=0; m<ndims; ++m) {
+        boost::int32_t d;
+        if ( !get(p, end, d) || d < 0 || d > 5 )
+            return false;
+        t.dims[m] = d;
+    }
+    if ( !get(p, end, nnodes) || !get(p, end, nobjs) || nobjs != ntri )
+        return false;
+    if ( static_cast<std::size_t>(end-p) < nnodes*40.0 + nobjs*4.0 ) // check size before allocating
+        return false;
+    t.nodes.resize(nnodes);
+    for (unsigned int n=0; n<nnodes; ++n) {
+        KDNode& nd = t.nodes[n];
+        boost::int32_t dim;
+        boost::uint32_t hi, begin, last, leaf, pad;
+        if ( !get(p, end, nd.cutval) || !get(p, end, nd.maxz) || !get(p, end, dim) || !get(p, end, hi) ||
+             !get(p, end, begin) || !get(p, end, last) || !get(p, end, leaf) || !get(p, end, pad) )
+            return false;
+        nd.dim = dim;
+        nd.hi = hi;
+        nd.begin = begin;
+        nd.end = last;
+        nd.isLeaf = (leaf != 0);
+        // a corrupt node would make searches run outside the arrays
+        if ( nd.isLeaf && !(nd.begin < nd.end && nd.end <= nobjs) )
+            return false;
+        if ( !nd.isLeaf && !(n+1 < nnodes && nd.hi > n+1 && nd.hi < nnodes && dim >= 0 && dim <= 5) )
+            return false;
+    }
+    t.order.resize(nobjs);
+    for (unsigned int n=0; n<nobjs; ++n) {
+        boost::uint32_t m;
+        if ( !get(p, end, m) || m >= ntri )
+            return false;
+        t.order[n] = m;
+    }
+    return true;
+}
+
+/// write one tree
+static void put_tree(std::ostream& o, const KDTree<Triangle>* tree) {
+    put(o, static_cast<boost::uint32_t>( tree->getDimensions().size() ) );
+    BOOST_FOREACH( int d, tree->getDimensions() ) {
+        put(o, static_cast<boost::int32_t>(d) );
+    }
+    put(o, static_cast<boost::uint32_t>( tree->getNodes().size() ) );
+    put(o, static_cast<boost::uint32_t>( tree->size() ) );
+    BOOST_FOREACH( const KDNode& nd, tree->getNodes() ) { // 40 bytes per node
+        put(o, nd.cutval);
+        put(o, nd.maxz);
+        put(o, static_cast<boost::int32_t>(nd.dim) );
+        put(o, static_cast<boost::uint32_t>(nd.hi) );
+        put(o, static_cast<boost::uint32_t>(nd.begin) );
+        put(o, static_cast<boost::uint32_t>(nd.end) );
+        put(o, static_cast<boost::uint32_t>(nd.isLeaf ? 1 : 0) );
+        put(o, static_cast<boost::uint32_t>(0) );
+    }
+    BOOST_FOREACH( unsigned int m, tree->getOrder() ) {
+        put(o, static_cast<boost::uint32_t>(m) );
+    }
+}
+
+/// an IndexedMesh as read from a cache-file
+struct CachedMesh {
+    double tol;
+    std::vector<Point> verts;
+    std::vector<MeshEdge> edges;
+    std::vector<MeshFace> faces;
+};
+
+/// read and check the mesh of ntri faces
+static bool get_mesh(const char*& p, const char* end, unsigned int ntri, CachedMesh& m) {
+    boost::uint32_t nverts, nedges;
+    if ( !get(p, end, m.tol) || !get(p, end, nverts) || !get(p, end, nedges) )
+        return false;
+    if ( static_cast<std::size_t>(end-p) < nverts*24.0 + nedges*8.0 + ntri*24.0 ) // check size before allocating
+        return false;
+    m.verts.resize(nverts);
+    for (unsigned int n=0; n<nverts; ++n) {
+        if ( !get(p, end, m.verts[n].x) || !get(p, end, m.verts[n].y) || !get(p, end, m.verts[n].z) )
+            return false;
+    }
+    m.edges.resize(nedges);
+    for (unsigned int n=0; n<nedges; ++n) {
+        boost::uint32_t v[2];
+        if ( !get(p, end, v) || !(v[0] <= v[1] && v[1] < nverts) ) // v[0] == v[1] when the corners are welded
+            return false;
+        m.edges[n].v[0] = v[0];
+        m.edges[n].v[1] = v[1];
+    }
+    m.faces.resize(ntri);
+    for (unsigned int n=0; n<ntri; ++n) {
+        boost::uint32_t v[3], e[3];
+        if ( !get(p, end, v) || !get(p, end, e) )
+            return false;
+        for (int k=0; k<3; ++k) { // a corrupt face would make queries run outside the arrays
+            if ( v[k] >= nverts || e[k] >= nedges )
+                return false;
+            m.faces[n].v[k] = v[k];
+            m.faces[n].e[k] = e[k];
+        }
+    }
+    return true;
+}
+
+/// write the mesh
+static void put_mesh(std::ostream& o, const IndexedMesh* mesh) {
+    put(o, mesh->getTolerance() );
+    put(o, static_cast<boost::uint32_t>( mesh->numVertices() ) );
+    put(o, static_cast<boost::uint32_t>( mesh->numEdges() ) );
+    for (unsigned int n=0; n<mesh->numVertices(); ++n) { // 24 bytes per vertex
+        put(o, mesh->vertex(n).x);
+        put(o, mesh->vertex(n).y);
+        put(o, mesh->vertex(n).z);
+    }
+    for (unsigned int n=0; n<mesh->numEdges(); ++n) { // 8 bytes per edge
+        for (int k=0; k<2; ++k)
+            put(o, static_cast<boost::uint32_t>( mesh->edge(n).v[k] ) );
+    }
+    for (unsigned int n=0; n<mesh->numFaces(); ++n) { // 24 bytes per face
+        for (int k=0; k<3; ++k)
+            put(o, static_cast<boost::uint32_t>( mesh->face(n).v[k] ) );
+        for (int k=0; k<3; ++k)
+            put(o, static_cast<boost::uint32_t>( mesh->face(n).e[k] ) );
+    }
+}
+
+SurfaceIndexCache::SurfaceIndexCache(const std::string& d) : dir(d), hit(false) {}
+
+boost::uint64_t SurfaceIndexCache::hash(const char* data, std::size_t n) {
+    const std::size_t chunk = 1<<20;
+    int nchunks = (n + chunk - 1)/chunk;
+    std::vector<boost::uint64_t> h(nchunks);
+    #pragma omp parallel for schedule(static)
+    for (int c=0; c<nchunks; ++c) {
+        std::size_t first = c*chunk;
+        std::size_t len = std::min(chunk, n-first);
+        h[c] = fnv1a( reinterpret_cast<const unsigned char*>(data+first), len, 14695981039346656037ULL );
+    }
+    // combine the length and the chunk hashes, byte by byte
+    boost::uint64_t result = 14695981039346656037ULL;
+    boost::uint64_t len = n;
+    for (int c=-1; c<nchunks; ++c) {
+        boost::uint64_t v = (c < 0) ? len : h[c];
+        unsigned char b[8];
+        for (int i=0; i<8; ++i)
+            b[i] = (v >> (8*i)) & 0xff;
+        result = fnv1a(b, 8, result);
+    }
+    return result;
+}
+
+std::string SurfaceIndexCache::cacheFile(boost::uint64_t key, unsigned int bucket) const {
+    std::ostringstream o;
+    o << dir << "/" << std::hex << std::setw(16) << std::setfill('0') << key;
+    o << std::dec << "-b" << bucket << ".oclidx";
+    return o.str();
+}
+
+boost::shared_ptr<SurfaceIndex> SurfaceIndexCache::load(const std::wstring& filepath, STLSurf& s, unsigned int bucket) {
+    hit = false;
+    if (bucket < 1)
+        bucket = 1;
+    boost::shared_ptr<SurfaceIndex> idx( new SurfaceIndex(s, bucket) );
+    std::string path( filepath.begin(), filepath.end() ); // same narrowing as STLReader
+    if ( s.size() != 0 ) { // cached trees index only the triangles of the file, not those already in s
+        std::cout << "SurfaceIndexCache::load() ERROR: the surface for " << path << " is not empty\n";
+        return idx;
+    }
+    boost::uint64_t key;
+    {
+        MappedFile stl(path);
+        if ( !stl.isOpen() ) {
+            std::cout << "SurfaceIndexCache::load() ERROR: can't open " << path << "\n";
+            return idx;
+        }
+        key = hash( stl.data(), stl.size() );
+    }
+    std::string fname = cacheFile(key, bucket);
+    if ( read(fname, key, bucket, s, *idx) ) {
+        std::cout << "SurfaceIndexCache::load() " << path << " from cache " << fname << "\n";
+        hit = true;
+        return idx;
+    }
+    std::cout << "SurfaceIndexCache::load() " << path << " not in cache, building " << fname << "\n";
+    STLReader r(filepath, s);
+    idx->build();
+    idx->mesh();
+    write(fname, key, s, *idx);
+    return idx;
+}
+
+bool SurfaceIndexCache::read(const std::string& fname, boost::uint64_t key, unsigned int bucket, STLSurf& s, SurfaceIndex& idx) const {
+    MappedFile f(fname);
+    if ( !f.isOpen() )
+        return false;
+    const char* p = f.data();
+    const char* end = p + f.size();
+    char magic[8];
+    boost::uint32_t version, filebucket, ntri, ntrees;
+    boost::uint64_t filekey;
+    if ( !get(p, end, magic) || std::memcmp(magic, cache_magic, 8) != 0 )
+        return false;
+    if ( !get(p, end, version) || version != cache_version )
+        return false;
+    if ( !get(p, end, filebucket) || filebucket != bucket )
+        return false;
+    if ( !get(p, end, filekey) || filekey != key )
+        return false;
+    if ( !get(p, end, ntri) || !get(p, end, ntrees) || ntrees != 3 )
+        return false;
+    if ( static_cast<std::size_t>(end-p) < ntri*72.0 )
+        return false;
+    std::vector<Triangle> tris;
+    tris.reserve(ntri);
+    for (unsigned int n=0; n<ntri; ++n) {
+        double x[9];
+        if ( !get(p, end, x) )
+            return false;
+        tris.push_back( Triangle( Point(x[0],x[1],x[2]), Point(x[3],x[4],x[5]), Point(x[6],x[7],x[8]) ) );
+    }
+    CachedTree t[3]; // XY, YZ, XZ
+    for (int m=0; m<3; ++m) {
+        if ( !get_tree(p, end, ntri, t[m]) )
+            return false;
+    }
+    CachedMesh mesh;
+    if ( !get_mesh(p, end, ntri, mesh) || mesh.tol != idx.weldTolerance )
+        return false;
+    // the cache-file is good, fill s and idx
+    BOOST_FOREACH( const Triangle& tri, tris ) {
+        s.addTriangle(tri);
+    }
+    KDTree<Triangle>** trees[3] = { &idx.xy, &idx.yz, &idx.xz };
+    for (int m=0; m<3; ++m) {
+        delete *trees[m];
+        *trees[m] = new KDTree<Triangle>();
+        (*trees[m])->restore( tris, t[m].dims, bucket, t[m].nodes, t[m].order );
+    }
+    delete idx.imesh;
+    idx.imesh = new IndexedMesh( s, mesh.tol, mesh.verts, mesh.edges, mesh.faces );
+    return true;
+}
+
+void SurfaceIndexCache::write(const std::string& fname, boost::uint64_t key, const STLSurf& s, const SurfaceIndex& idx) const {
+    // write to a temporary file and rename it, so that readers never see a partial cache-file
+    std::ostringstream tmp;
+    tmp << fname << ".tmp";
+#ifndef WIN32
+    tmp << getpid();
+#endif
+    std::ofstream o( tmp.str().c_str(), std::ios::binary );
+    if (!o) {
+        std::cout << "SurfaceIndexCache::write() ERROR: can't write " << tmp.str() << "\n";
+        return;
+    }
+    o.write(cache_magic, 8);
+    put(o, cache_version);
+    put(o, static_cast<boost::uint32_t>( idx.getBucketSize() ) );
+    put(o, key);
+    put(o, static_cast<boost::uint32_t>( s.size() ) );
+    put(o, static_cast<boost::uint32_t>( 3 ) );
+    BOOST_FOREACH( const Triangle& t, s.tris ) { // 72 bytes per triangle
+        for (int m=0; m<3; ++m) {
+            put(o, t.p[m].x);
+            put(o, t.p[m].y);
+            put(o, t.p[m].z);
+        }
+    }
+    put_tree(o, idx.xyTree());
+    put_tree(o, idx.yzTree());
+    put_tree(o, idx.xzTree());
+    put_mesh(o, idx.mesh());
+    o.close();
+    if ( o.fail() || std::rename( tmp.str().c_str(), fname.c_str() ) != 0 ) {
+        std::cout << "SurfaceIndexCache::write() ERROR: can't write " << fname << "\n";
+        std::remove( tmp.str().c_str() );
+    }
+}
+
+} // end namespace
+// end file surfaceindexcache.cpp
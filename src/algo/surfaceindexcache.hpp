@@ -0,0 +1,80 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SURFACEINDEXCACHE_H
+#define SURFACEINDEXCACHE_H
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+#include "surfaceindex.hpp"
+
+namespace ocl
+{
+
+class STLSurf;
+
+/// \brief on-disk cache of STL surfaces and their kd-trees
+///
+/// load() hashes the contents of an STL-file, and looks for a cache-file
+/// named after the hash and the bucket-size in the cache directory. 
+/// On a hit the triangles, all three kd-trees and the IndexedMesh of the SurfaceIndex 
+/// are read from the memory-mapped cache-file, so that neither STLReader, KDTree::build()
+/// nor the vertex welding of IndexedMesh runs. On a miss the STL-file is read, the trees 
+/// and the mesh are built, and the cache-file is written for next time.
+///
+/// The cache-file is a versioned binary file in native byte-order:
+/// a header (magic "OCLINDEX", version, bucket-size, hash, number of triangles, number of trees),
+/// the vertices of all triangles, for each tree its dimensions, nodes and build-order, and
+/// the weld tolerance, vertices, edges and faces of the IndexedMesh.
+/// A cache-file that does not match is ignored and overwritten.
+class SurfaceIndexCache {
+    public:
+        /// use cache-files in the existing directory dir
+        SurfaceIndexCache(const std::string& dir);
+        virtual ~SurfaceIndexCache() {}
+        /// add the triangles of the STL-file filepath to the empty surface s, and return
+        /// a SurfaceIndex of s with all kd-trees and the IndexedMesh built. 
+        /// If s is not empty, an error is printed, s is left unchanged, and its SurfaceIndex has no trees built.
+        boost::shared_ptr<SurfaceIndex> load(const std::wstring& filepath, STLSurf& s, unsigned int bucket = 1);
+        /// true if the last load() was served from the cache
+        bool wasHit() const {return hit;}
+        /// return the cache-file used for an STL-file with hash key, and bucket-size bucket
+        std::string cacheFile(boost::uint64_t key, unsigned int bucket) const;
+        /// content hash of n bytes at data. Fixed-size chunks are hashed in parallel
+        /// and then combined, so the result does not depend on the number of threads.
+        static boost::uint64_t hash(const char* data, std::size_t n);
+    protected:
+        /// read cache-file fname into s and idx. Returns false if fname is
+        /// missing, truncated, or does not match key and bucket. s and idx are then unchanged.
+        bool read(const std::string& fname, boost::uint64_t key, unsigned int bucket, STLSurf& s, SurfaceIndex& idx) const;
+        /// write s and the trees and mesh of idx to cache-file fname
+        void write(const std::string& fname, boost::uint64_t key, const STLSurf& s, const SurfaceIndex& idx) const;
+        /// cache directory
+        std::string dir;
+        /// true if the last load() was served from the cache
+        bool hit;
+};
+
+} // end namespace
+
+#endif // end surfaceindexcache.hpp
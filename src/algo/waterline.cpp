@@ -18,6 +18,9 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <utility>
+
 #include <boost/foreach.hpp> 
 
 #ifdef _OPENMP
@@ -45,8 +48,6 @@ Waterline::Waterline() {
     nthreads=1;
 #ifdef _OPENMP
     nthreads = omp_get_num_procs(); 
-    //omp_set_dynamic(0);
-    omp_set_nested(1);
 #endif
 
 }
@@ -57,12 +58,11 @@ Waterline::~Waterline() {
 }
 
 
-// run the batchpuschutter sub-operations to get x- and y-fibers
+// push the x- and y-fibers of the batchpushcutter sub-operations
 // pass the fibers to weave, and process the weave to get waterline-loops
 void Waterline::run() {
     init_fibers();
-    subOp[0]->run(); // these two are independent, so could/should run in parallel
-    subOp[1]->run();
+    push_fibers();
     
     xfibers = *( subOp[0]->getFibers() );
     yfibers = *( subOp[1]->getFibers() );
@@ -70,6 +70,35 @@ void Waterline::run() {
     weave2_process();
 }
 
+// the x- and y-fibers are independent, so they are interleaved into one queue
+// that is shared out to one team of threads
+void Waterline::push_fibers() {
+    const BatchPushCutter* xop = static_cast<BatchPushCutter*>( subOp[0] );
+    const BatchPushCutter* yop = static_cast<BatchPushCutter*>( subOp[1] );
+    std::vector<Fiber>& xf = *( xop->getFibers() );
+    std::vector<Fiber>& yf = *( yop->getFibers() );
+    std::vector< std::pair<const BatchPushCutter*, Fiber*> > queue;
+    for (unsigned int n=0; n < std::max( xf.size(), yf.size() ); ++n) {
+        if ( n < xf.size() )
+            queue.push_back( std::make_pair( xop, &xf[n] ) );
+        if ( n < yf.size() )
+            queue.push_back( std::make_pair( yop, &yf[n] ) );
+    }
+    std::cout << "Waterline: pushing " << xf.size() << " x-fibers and " << yf.size() << " y-fibers..." << std::flush;
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    int Nmax = queue.size();
+    int n; // loop variable
+    int calls = 0;
+    #pragma omp parallel for schedule(dynamic) private(n) reduction(+:calls)
+    for (n=0; n<Nmax; ++n) {
+        calls += queue[n].first->pushCutter( *queue[n].second );
+    }
+    this->nCalls = calls;
+    std::cout << "done.\n";
+}
+
 void Waterline::weave2_process() {
     std::cout << "Weave...\n" << std::flush;
     weave2::Weave weave;
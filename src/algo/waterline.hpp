@@ -60,6 +60,8 @@ class Waterline : public Operation {
         }
         
     protected:
+        /// push the x- and y-fibers of both sub-operations, in one parallel loop
+        void push_fibers();
         /// from xfibers and yfibers, build the weave, run face-traverse, and write toolpaths to loops
         void weave2_process(); 
         /// initialization of fibers
@@ -21,6 +21,11 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+#include <map>
+
+#include <boost/array.hpp>
+#include <boost/tuple/tuple.hpp>
 
 #include "weave.hpp"
 
@@ -100,7 +105,8 @@ std::pair<Vertex,Vertex> Weave::find_neighbor_vertices( VertexPair v_pair, Inter
 // vertices/edges belonging to non-toolpath-producing faces could then be deleted
 // and the RAM consumption should be limited to N+N (i.e. the length/perimeter of the part/toolpath
 // in contrast to the area for the naive implementation)
-void Weave::build() {
+// build2() is such a build.
+void Weave::build1() {
     // 1) add CL-points of X-fiber (if not already in graph)
     // 2) add CL-points of Y-fiber (if not already in graph)
     // 3) add intersection point (if not already in graph) (will allways be new??)
@@ -229,11 +235,11 @@ void Weave::build() {
                                 g[yu_v].next = v_xl;        g[v_xl].prev = yu_v;
                                 g[v_xl].next = xe_ul_next;  g[xe_ul_next].prev = v_xl;
                                 // delete the old edges
-                                boost::remove_edge( x_l, x_u, g);
-                                boost::remove_edge( x_u, x_l, g);
+                                hedi::remove_edge( x_l, x_u, g);
+                                hedi::remove_edge( x_u, x_l, g);
                                 if ( y_lu_edge ) {
-                                    boost::remove_edge( y_l, y_u, g);
-                                    boost::remove_edge( y_u, y_l, g);
+                                    hedi::remove_edge( y_l, y_u, g);
+                                    hedi::remove_edge( y_u, y_l, g);
                                 }
                                 
                                 // finally add new intersection vertex to the interval sets
@@ -261,6 +267,207 @@ void Weave::build() {
     } // end X-fiber loop
 }
 
+/// a crossing of an x-interval and a y-interval, found by Weave::build2()
+struct Crossing {
+    /// the x-fiber
+    const Fiber* xf;
+    /// the x-interval
+    const Interval* xi;
+    /// the y-fiber
+    const Fiber* yf;
+    /// the y-interval
+    const Interval* yi;
+    /// index of yi among all y-intervals
+    unsigned int yid;
+    /// index of the y-interval of the next crossing east along xi, or -1 at the last crossing
+    int east;
+    /// quadrants where the face of the full graph is a cell of four crossings
+    unsigned char cells;
+};
+
+/// Crossing::cells bits
+enum { CELL_NE = 1, CELL_NW = 2, CELL_SE = 4, CELL_SW = 8, CELL_ALL = 15 };
+
+/// directions of the edges at a vertex, counterclockwise
+enum { DIR_E = 0, DIR_N = 1, DIR_W = 2, DIR_S = 3 };
+
+/// orders fibers by their fixed coordinate: y for x-fibers, x for y-fibers
+struct FiberCompare {
+    FiberCompare(const std::vector<Fiber>& f, bool x) : fibers(f), xfiber(x) {}
+    bool operator()(unsigned int a, unsigned int b) const {
+        return xfiber ? (fibers[a].p1.y < fibers[b].p1.y) : (fibers[a].p1.x < fibers[b].p1.x);
+    }
+    const std::vector<Fiber>& fibers;
+    bool xfiber;
+};
+
+/// the vertices of an interval in the graph: the CL-vertices at the ends, and the crossings between
+struct IntervalVertices {
+    bool xdir;
+    Vertex lower;
+    Vertex upper;
+    std::vector<VertexPair> crossings;
+};
+
+// In the full graph of build1() every crossing has four edges, and face_traverse() turns right at 
+// every crossing, and back at every CL-vertex. A face is a "cell" if it is the 4-cycle of crossings
+// c, c.E, c.E.S, c.S (c.S.E == c.E.S). A cell has no CL-vertex, so it is never on a loop, and a 
+// crossing where all four faces are cells is never on a loop either. Leaving out such crossings,
+// and joining the remaining vertices along each interval, gives edges which may cross each other 
+// inside the cells, but each face with a CL-vertex keeps its edges and its right-turns, so 
+// face_traverse() finds the same loops.
+//
+// The x-fibers are swept in order of y. For each y-interval the last crossing found, below the 
+// current x-fiber, is pending: the cells above it are tested when the next crossing above it,
+// on the same y-interval, is found, after which it is kept or dropped. The last pending crossing 
+// of a y-interval has a CL-vertex above, so it is always kept.
+void Weave::build2() {
+    // y-fibers in order of x, x-fibers in order of y
+    std::vector<unsigned int> yorder( yfibers.size() ), xorder( xfibers.size() );
+    for (unsigned int n=0; n<yorder.size(); ++n)
+        yorder[n] = n;
+    for (unsigned int n=0; n<xorder.size(); ++n)
+        xorder[n] = n;
+    std::sort( yorder.begin(), yorder.end(), FiberCompare(yfibers, false) );
+    std::sort( xorder.begin(), xorder.end(), FiberCompare(xfibers, true) );
+    std::vector<double> ycoord( yorder.size() );
+    for (unsigned int n=0; n<yorder.size(); ++n)
+        ycoord[n] = yfibers[ yorder[n] ].p1.x;
+    // the intervals of y-fiber n have indices yfirst[n] ... yfirst[n+1]-1
+    std::vector<unsigned int> yfirst( yfibers.size()+1, 0 );
+    for (unsigned int n=0; n<yfibers.size(); ++n)
+        yfirst[n+1] = yfirst[n] + yfibers[n].ints.size();
+    std::vector<Crossing> pending( yfirst.back() );
+    std::vector<bool> has_pending( yfirst.back(), false );
+    std::vector<Crossing> kept;  // the crossings of the graph
+    std::vector<Crossing> row;   // the crossings of the current x-fiber
+    
+    BOOST_FOREACH( unsigned int xn, xorder ) {
+        const Fiber& xf = xfibers[xn];
+        row.clear();
+        BOOST_FOREACH( const Interval& xi, xf.ints ) {
+            double xmin = xf.point(xi.lower).x;
+            double xmax = xf.point(xi.upper).x;
+            if ( isZero_tol( xmax-xmin ) ) // as build1(), no zero-length x-intervals
+                continue;
+            // the y-fibers with xmin <= x <= xmax
+            unsigned int first = std::lower_bound( ycoord.begin(), ycoord.end(), xmin ) - ycoord.begin();
+            unsigned int last = std::upper_bound( ycoord.begin(), ycoord.end(), xmax ) - ycoord.begin();
+            const unsigned int start = row.size();
+            for (unsigned int k=first; k<last; ++k) {
+                const unsigned int yn = yorder[k];
+                const Fiber& yf = yfibers[yn];
+                for (unsigned int m=0; m<yf.ints.size(); ++m) {
+                    const Interval& yi = yf.ints[m];
+                    if ( (yf.point(yi.lower).y <= xf.p1.y) && (xf.p1.y <= yf.point(yi.upper).y) ) {
+                        Crossing c;
+                        c.xf = &xf;
+                        c.xi = &xi;
+                        c.yf = &yf;
+                        c.yi = &yi;
+                        c.yid = yfirst[yn] + m;
+                        c.east = -1;
+                        c.cells = 0;
+                        if ( row.size() > start )
+                            row.back().east = c.yid;
+                        row.push_back(c);
+                        break; // one crossing per y-fiber
+                    }
+                }
+            }
+        }
+        // the cells below the edges c-e of this x-fiber, with the pending crossings t (below c) and s (below e)
+        for (unsigned int n=0; n+1<row.size(); ++n) {
+            Crossing& c = row[n];
+            if ( c.east < 0 ) // no edge east of c
+                continue;
+            Crossing& e = row[n+1];
+            if ( has_pending[c.yid] && has_pending[e.yid] ) {
+                Crossing& t = pending[c.yid];
+                Crossing& s = pending[e.yid];
+                if ( (t.xi == s.xi) && (t.east == (int)e.yid) ) { // t-s is an edge
+                    c.cells |= CELL_SE;
+                    e.cells |= CELL_SW;
+                    t.cells |= CELL_NE;
+                    s.cells |= CELL_NW;
+                }
+            }
+        }
+        // the crossings below this x-fiber now have all their cells tested
+        BOOST_FOREACH( const Crossing& c, row ) {
+            if ( has_pending[c.yid] && (pending[c.yid].cells != CELL_ALL) )
+                kept.push_back( pending[c.yid] );
+            pending[c.yid] = c;
+            has_pending[c.yid] = true;
+        }
+    }
+    for (unsigned int n=0; n<pending.size(); ++n) {
+        if ( has_pending[n] )
+            kept.push_back( pending[n] );
+    }
+    
+    // the vertices, and the crossings along each interval
+    std::map<const Interval*, IntervalVertices> ivertices;
+    BOOST_FOREACH( const Crossing& c, kept ) {
+        Point position( c.yf->p1.x, c.xf->p1.y, c.xf->p1.z );
+        Vertex v = hedi::add_vertex( VertexProps( position, INT ), g );
+        for (int d=0; d<2; ++d) {
+            const Fiber* f = (d == 0) ? c.xf : c.yf;
+            const Interval* i = (d == 0) ? c.xi : c.yi;
+            std::map<const Interval*, IntervalVertices>::iterator it = ivertices.find(i);
+            if ( it == ivertices.end() ) { // first crossing of the interval, add its CL-vertices
+                IntervalVertices iv;
+                iv.xdir = (d == 0);
+                iv.lower = hedi::add_vertex( VertexProps( f->point(i->lower), CL ), g );
+                iv.upper = hedi::add_vertex( VertexProps( f->point(i->upper), CL ), g );
+                clVertices.insert( iv.lower );
+                clVertices.insert( iv.upper );
+                it = ivertices.insert( std::make_pair(i, iv) ).first;
+            }
+            it->second.crossings.push_back( VertexPair( v, (d == 0) ? position.x : position.y ) );
+        }
+    }
+    
+    // edges between consecutive vertices along each interval, and their heading
+    std::map<Vertex, boost::array<Edge,4> > out; // out-edges of the crossings, by direction
+    std::vector< std::pair<Edge, int> > edges;
+    typedef std::pair<const Interval* const, IntervalVertices> IntervalEntry;
+    BOOST_FOREACH( IntervalEntry& entry, ivertices ) {
+        IntervalVertices& iv = entry.second;
+        std::sort( iv.crossings.begin(), iv.crossings.end(), VertexPairCompare() );
+        std::vector<Vertex> chain;
+        chain.push_back( iv.lower );
+        BOOST_FOREACH( const VertexPair& vp, iv.crossings ) {
+            chain.push_back( vp.first );
+        }
+        chain.push_back( iv.upper );
+        const int up = iv.xdir ? DIR_E : DIR_N;
+        const int down = iv.xdir ? DIR_W : DIR_S;
+        for (unsigned int n=0; n+1<chain.size(); ++n) {
+            Edge e1 = hedi::add_edge( chain[n], chain[n+1], g );
+            Edge e2 = hedi::add_edge( chain[n+1], chain[n], g );
+            g[e1].twin = e2;
+            g[e2].twin = e1;
+            edges.push_back( std::make_pair( e1, up ) );
+            edges.push_back( std::make_pair( e2, down ) );
+            if ( g[ chain[n] ].type == INT )
+                out[ chain[n] ][up] = e1;
+            if ( g[ chain[n+1] ].type == INT )
+                out[ chain[n+1] ][down] = e2;
+        }
+    }
+    
+    // turn right at crossings, and back at CL-vertices
+    typedef std::pair<Edge, int> HeadedEdge;
+    BOOST_FOREACH( const HeadedEdge& he, edges ) {
+        const Edge e = he.first;
+        const Vertex v = hedi::target( e, g );
+        const Edge next = ( g[v].type == CL ) ? g[e].twin : out[v][ (he.second+3) % 4 ];
+        g[e].next = next;
+        g[next].prev = e;
+    }
+}
+
 std::vector< std::vector<Point> > Weave::getLoops() const {
     std::vector< std::vector<Point> > loop_list;
     BOOST_FOREACH( std::vector<Vertex> loop, loops ) {
@@ -274,17 +481,12 @@ std::vector< std::vector<Point> > Weave::getLoops() const {
 }
 
 
-// this can cause a build error when both face and vertex descriptors have the same type
-// i.e. unsigned int (?)
-// operator[] below "g[*itr].type" then looks for FaceProps.type which does not exist...
 void Weave::printGraph() const {
-    std::cout << " number of vertices: " << boost::num_vertices( g ) << "\n";
-    std::cout << " number of edges: " << boost::num_edges( g ) << "\n";
-    VertexItr it_begin, it_end, itr;
-    boost::tie( it_begin, it_end ) = boost::vertices( g );
+    std::cout << " number of vertices: " << hedi::num_vertices( g ) << "\n";
+    std::cout << " number of edges: " << hedi::num_edges( g ) << "\n";
     int n=0, n_cl=0, n_internal=0;
-    for ( itr=it_begin ; itr != it_end ; ++itr ) {
-        if ( g[*itr].type == CL )
+    BOOST_FOREACH( Vertex v, hedi::vertices( g ) ) {
+        if ( g[v].type == CL )
             ++n_cl;
         else
             ++n_internal;
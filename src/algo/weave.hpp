@@ -47,8 +47,20 @@ class Weave {
         /// FIXME: seprate addXFiber and addYFiber methods?
         void addFiber(Fiber& f);
         
-        /// from the list of fibers, build a graph
-        void build();
+        /// from the list of fibers, build a graph, with build2()
+        void build() {build2();}
+        /// build the full graph, with a vertex at every crossing of an x-interval and a y-interval.
+        /// Each x-interval is tested against every y-fiber, and the graph uses RAM proportional 
+        /// to the area of the part.
+        void build1();
+        /// build the graph with only the crossings that can be on a waterline loop. 
+        /// The y-fibers are sorted by x, and the y-fibers that an x-interval crosses are found 
+        /// by binary search. The x-fibers are swept in order of y, keeping one pending crossing 
+        /// per y-interval. A crossing whose four neighbouring faces in the full graph are all 
+        /// cells of four crossings is left out: such faces have no CL-vertex, so face_traverse() 
+        /// never visits them. The RAM used is proportional to the length of the loops,
+        /// and face_traverse() finds the same loops as with build1().
+        void build2();
 
         /// run planar_face_traversal to get the waterline loops
         void face_traverse();
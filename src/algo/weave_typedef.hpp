@@ -29,10 +29,7 @@ namespace weave2
 
 
 
-typedef boost::adjacency_list_traits<boost::listS, 
-                                     boost::listS, 
-                                     boost::bidirectionalS, 
-                                     boost::listS >::edge_descriptor Edge;
+typedef HEDIEdge Edge;
 
 /// vertex type: CL-point, internal point, adjacent point
 enum VertexType {CL, CL_DONE, ADJ, TWOADJ, INT };
@@ -90,22 +87,9 @@ struct FaceProps {
  
   
 // the graph type for the weave
-typedef HEDIGraph<     boost::listS,             // out-edges stored here
-                       boost::listS,             // vertex set stored here
-                       boost::bidirectionalS,    // undirecgted or bidirectional graph?
-                       VertexProps,              // vertex properties
-                       EdgeProps,                // edge properties
-                       FaceProps,                // face properties
-                       boost::no_property,       // graph properties
-                       boost::listS             // edge storage
-                       > WeaveGraph;
-
-typedef boost::graph_traits< WeaveGraph >::vertex_descriptor  Vertex;
-typedef boost::graph_traits< WeaveGraph >::vertex_iterator    VertexItr;
-// typedef boost::graph_traits< WeaveGraph >::edge_descriptor    Edge;
-typedef boost::graph_traits< WeaveGraph >::edge_iterator      EdgeItr;
-typedef boost::graph_traits< WeaveGraph >::out_edge_iterator  OutEdgeItr;
-typedef boost::graph_traits< WeaveGraph >::adjacency_iterator AdjacencyItr;
+typedef HEDIGraph< VertexProps, EdgeProps, FaceProps > WeaveGraph;
+
+typedef WeaveGraph::Vertex Vertex;
 
 /// intersections between intervals are stored as a VertexPair
 /// pair.first is a vertex descriptor of the weave graph
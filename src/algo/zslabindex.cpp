@@ -0,0 +1,148 @@
+/*  $Id$
+ * 
+ *  Copyright 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <list>
+#include <sstream>
+
+#include <boost/foreach.hpp> 
+
+#include "stlsurf.hpp"
+#include "zslabindex.hpp"
+
+namespace ocl
+{
+
+ZSlabIndex::ZSlabIndex(const STLSurf& s, double h, double len, unsigned int bucket) 
+    : zmin(s.bb.minpt.z), height(h), length(len), bucketSize(bucket) {
+    assert( height > 0.0 );
+    BOOST_FOREACH( const Triangle& t, s.tris ) {
+        tris.push_back( &t );
+    }
+    unsigned int nslabs = 1;
+    if ( s.bb.maxpt.z > zmin )
+        nslabs = std::max( 1, (int)ceil( (s.bb.maxpt.z - zmin)/height ) );
+    slabs.resize( nslabs );
+    bands.resize( nslabs );
+    first.resize( nslabs );
+    // each face goes in every slab it overlaps
+    for (unsigned int n=0; n<tris.size(); ++n) {
+        for (unsigned int m=slab( minz(n) ); m<=slab( maxz(n) ); ++m)
+            slabs[m].push_back( n );
+    }
+    for (unsigned int m=0; m<nslabs; ++m) {
+        std::sort( slabs[m].begin(), slabs[m].end(), MinZCompare(*this) );
+        first[m] = 0;
+        while ( first[m] < slabs[m].size() && slab( minz( slabs[m][ first[m] ] ) ) < m )
+            ++first[m];
+    }
+}
+
+ZSlabIndex::~ZSlabIndex() {
+    BOOST_FOREACH( Band& b, bands ) {
+        delete b.yz;
+        delete b.xz;
+    }
+}
+
+unsigned int ZSlabIndex::slab(double z) const {
+    double s = floor( (z - zmin)/height );
+    if ( s <= 0.0 )
+        return 0;
+    if ( s >= slabs.size() - 1 )
+        return slabs.size() - 1;
+    return (unsigned int)s;
+}
+
+// a face that overlaps [zmin, zmax] is found in the first slab of the range that it overlaps:
+// in the first slab of the range all faces are tested, but in the following slabs 
+// the faces that begin in an earlier slab are skipped.
+void ZSlabIndex::search(double z1, double z2, std::vector<unsigned int>& idx) const {
+    idx.clear();
+    if ( tris.empty() || z2 < z1 )
+        return;
+    unsigned int s1 = slab(z1);
+    unsigned int s2 = slab(z2);
+    for (unsigned int m=s1; m<=s2; ++m) {
+        const std::vector<unsigned int>& faces = slabs[m];
+        for (unsigned int n = ( m == s1 ? 0 : first[m] ); n<faces.size(); ++n) {
+            unsigned int f = faces[n];
+            if ( minz(f) > z2 ) // the rest of the slab is above the range
+                break;
+            if ( maxz(f) >= z1 )
+                idx.push_back( f );
+        }
+    }
+}
+
+const KDTree<Triangle>* ZSlabIndex::yzTree(unsigned int s) const {
+    return getTree( bands[s].yz, bands[s].yzfaces, s, true );
+}
+
+const KDTree<Triangle>* ZSlabIndex::xzTree(unsigned int s) const {
+    return getTree( bands[s].xz, bands[s].xzfaces, s, false );
+}
+
+const KDTree<Triangle>* ZSlabIndex::getTree(KDTree<Triangle>*& tree, std::vector<unsigned int>& faces, 
+                                            unsigned int s, bool yzplane) const {
+    KDTree<Triangle>* t;
+    // as in SurfaceIndex, the first thread to ask for a tree builds it, other threads wait here
+    #pragma omp critical (zslabindex)
+    {
+        if (!tree) {
+            std::vector<unsigned int> band;
+            search( bottom(s), bottom(s) + height + length, band );
+            std::sort( band.begin(), band.end() ); // in the order of the surface
+            std::list<Triangle> bandtris;
+            BOOST_FOREACH( unsigned int n, band ) {
+                bandtris.push_back( *tris[n] );
+            }
+            KDTree<Triangle>* newtree = new KDTree<Triangle>();
+            if (yzplane)
+                newtree->setYZDimensions(); // x-fibers
+            else
+                newtree->setXZDimensions(); // y-fibers
+            newtree->setBucketSize( bucketSize );
+            newtree->build( bandtris );
+            faces.resize( band.size() );
+            for (unsigned int n=0; n<band.size(); ++n)
+                faces[n] = band[ newtree->getOrder()[n] ];
+            tree = newtree;
+        }
+        t = tree;
+    }
+    return t;
+}
+
+std::string ZSlabIndex::str() const {
+    std::ostringstream o;
+    unsigned int built = 0;
+    BOOST_FOREACH( const Band& b, bands ) {
+        built += (b.yz ? 1 : 0) + (b.xz ? 1 : 0);
+    }
+    o << "ZSlabIndex: " << tris.size() << " triangles in " << slabs.size() << " slabs of height " << height;
+    o << ", cutter length " << length << ", " << built << " kd-trees built";
+    return o.str();
+}
+
+} // end namespace
+// end file zslabindex.cpp
@@ -0,0 +1,132 @@
+/*  $Id$
+ * 
+ *  Copyright 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ZSLABINDEX_H
+#define ZSLABINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "triangle.hpp"
+#include "kdtree.hpp"
+
+namespace ocl
+{
+
+class STLSurf;
+
+/// \brief the triangles of an STLSurf, sorted into slabs of z-height
+///
+/// A push-cutter fiber at height z can only touch triangles whose z-range overlaps 
+/// [z, z+length], where length is the cutter length. The z-range of the surface is 
+/// divided into slabs of equal height, and each slab holds the triangles overlapping it, 
+/// sorted by their minimum z. search() finds the triangles overlapping a z-range from 
+/// the slabs it spans.
+/// The band of a slab holds the triangles overlapping [bottom of slab, top of slab + length], 
+/// i.e. all triangles that a fiber within the slab can touch. The YZ and XZ kd-trees of a band 
+/// are built the first time a fiber within the slab asks for them, so a multi-level waterline 
+/// only builds trees for the slabs it has levels in, and each tree holds only a part of the surface.
+/// As SurfaceIndex, a ZSlabIndex may be used from many threads. The STLSurf must outlive it.
+class ZSlabIndex {
+    public:
+        /// index surface s in slabs of height h, for cutters of length length, 
+        /// with kd-tree bucket-size bucket
+        ZSlabIndex(const STLSurf& s, double h, double length, unsigned int bucket = 1);
+        virtual ~ZSlabIndex();
+        /// the number of slabs
+        unsigned int numSlabs() const {return slabs.size();}
+        /// the slab of height z. z below or above the surface is in the first or last slab
+        unsigned int slab(double z) const;
+        /// the triangles whose z-range overlaps [zmin, zmax]. Their positions in the surface, 
+        /// i.e. the face indices of its IndexedMesh, are placed in the buffer idx, which is cleared first.
+        void search(double zmin, double zmax, std::vector<unsigned int>& idx) const;
+        /// kd-tree in the YZ-plane of the band of slab s, for push-cutter along X-fibers within s
+        const KDTree<Triangle>* yzTree(unsigned int s) const;
+        /// kd-tree in the XZ-plane of the band of slab s, for push-cutter along Y-fibers within s
+        const KDTree<Triangle>* xzTree(unsigned int s) const;
+        /// the face indices of the objects of yzTree(s): object n is face yzFaces(s)[n] of the surface. 
+        /// Valid after yzTree(s) has been called
+        const std::vector<unsigned int>& yzFaces(unsigned int s) const {return bands[s].yzfaces;}
+        /// as yzFaces(), for xzTree(s)
+        const std::vector<unsigned int>& xzFaces(unsigned int s) const {return bands[s].xzfaces;}
+        /// string repr
+        std::string str() const;
+    protected:
+        /// the lazily built kd-trees of the band of a slab
+        struct Band {
+            Band() : yz(NULL), xz(NULL) {}
+            /// YZ-plane kd-tree, or NULL when not built yet
+            KDTree<Triangle>* yz;
+            /// XZ-plane kd-tree, or NULL when not built yet
+            KDTree<Triangle>* xz;
+            /// face index of each object of yz
+            std::vector<unsigned int> yzfaces;
+            /// face index of each object of xz
+            std::vector<unsigned int> xzfaces;
+        };
+        /// return the tree of the band of slab s, building it and its faces if needed
+        const KDTree<Triangle>* getTree(KDTree<Triangle>*& tree, std::vector<unsigned int>& faces, 
+                                        unsigned int s, bool yzplane) const;
+        /// the minimum z of face n
+        double minz(unsigned int n) const {return tris[n]->bb.minpt.z;}
+        /// the maximum z of face n
+        double maxz(unsigned int n) const {return tris[n]->bb.maxpt.z;}
+        /// the bottom of slab s
+        double bottom(unsigned int s) const {return zmin + s*height;}
+        /// orders faces by minimum z, then by face index
+        class MinZCompare {
+            public:
+                /// compare faces of zi
+                MinZCompare(const ZSlabIndex& zi) : index(zi) {}
+                /// true if face a comes before face b
+                bool operator()(unsigned int a, unsigned int b) const {
+                    if ( index.minz(a) != index.minz(b) )
+                        return index.minz(a) < index.minz(b);
+                    return a < b;
+                }
+            private:
+                /// the index of the faces
+                const ZSlabIndex& index;
+        };
+        /// the triangles of the surface, in order
+        std::vector<const Triangle*> tris;
+        /// for each slab, the faces overlapping it, sorted by minimum z
+        std::vector< std::vector<unsigned int> > slabs;
+        /// for each slab, the number of its faces that begin in an earlier slab. 
+        /// These come first, as the faces are sorted by minimum z.
+        std::vector<unsigned int> first;
+        /// the kd-trees of the bands
+        mutable std::vector<Band> bands;
+        /// bottom of the first slab
+        double zmin;
+        /// height of a slab
+        double height;
+        /// cutter length, the height of a band above its slab
+        double length;
+        /// bucket-size of the kd-trees
+        unsigned int bucketSize;
+    private:
+        ZSlabIndex(const ZSlabIndex&); // non-copyable, the trees are owned
+        ZSlabIndex& operator=(const ZSlabIndex&);
+};
+
+} // end namespace
+
+#endif // end zslabindex.hpp
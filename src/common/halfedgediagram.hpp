@@ -21,9 +21,12 @@
 #define HEDI2_H
 
 #include <vector>
-#include <list>
+#include <set>
+#include <cassert>
+#include <cstddef>
+#include <ostream>
 
-#include <boost/graph/adjacency_list.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/foreach.hpp> 
 
 #include "point.hpp"
@@ -32,16 +35,14 @@
 namespace ocl
 {
     
-// bundled BGL properties, see: http://www.boost.org/doc/libs/1_44_0/libs/graph/doc/bundles.html
-
 // dcel notes from http://www.holmes3d.net/graphics/dcel/
 
-// vertex (boost::out_edges)
+// vertex (HEDIGraph::first_out_edge)
 //  -leaving pointer to HalfEdge that has this vertex as origin
 //   if many HalfEdges have this vertex as origin, choose one arbitrarily
 
 // HalfEdge
-//  - origin pointer to vertex (boost::source)
+//  - origin pointer to vertex (HEDIGraph::source)
 //  - face to the left of halfedge
 //  - twin pointer to HalfEdge (on the right of this edge)
 //  - next pointer to HalfEdge
@@ -56,50 +57,91 @@ namespace ocl
 // special "infinite face", face on "outside" of boundary
 // may or may not store edge pointer
 
+/// handle to a vertex or a half-edge of a HEDIGraph, i.e. an index into
+/// the vertex or edge array of the graph.
+/// The Tag makes vertex and edge handles distinct types, so that
+/// HEDIGraph::operator[] can be overloaded on them.
+template <class Tag>
+struct HEDIHandle {
+    /// an invalid handle
+    HEDIHandle() : idx(NONE) {}
+    /// handle to element i of the vertex or edge array
+    explicit HEDIHandle(boost::uint32_t i) : idx(i) {}
+    bool operator==(const HEDIHandle& h) const { return idx == h.idx; }
+    bool operator!=(const HEDIHandle& h) const { return idx != h.idx; }
+    /// ordering by index, for std::set and std::map
+    bool operator<(const HEDIHandle& h) const { return idx < h.idx; }
+    /// index into the vertex or edge array
+    boost::uint32_t idx;
+    /// index of an invalid handle
+    static const boost::uint32_t NONE = 0xffffffff;
+};
+
+/// write the index of handle h to stream
+template <class Tag>
+std::ostream& operator<<(std::ostream& stream, const HEDIHandle<Tag>& h) {
+    return stream << h.idx;
+}
+
+/// tag of vertex handles
+struct HEDIVertexTag {};
+/// tag of half-edge handles
+struct HEDIEdgeTag {};
+/// vertex handle
+typedef HEDIHandle<HEDIVertexTag> HEDIVertex;
+/// half-edge handle
+typedef HEDIHandle<HEDIEdgeTag> HEDIEdge;
 
 /// HEDIGraph is a A half-edge diagram class.
 /// Templated on Vertex/Edge/Face property classes which allow
 /// attaching information to vertices/edges/faces that is 
 /// required for a particular algorithm.
 /// 
-/// Inherits from boost::adjacency_list
-/// minor additions allow storing face-properties.
+/// Vertices, half-edges and faces are stored in std::vectors, and referred to
+/// by HEDIVertex and HEDIEdge handles (32-bit indices) and unsigned int faces.
+/// The out-edges and in-edges of a vertex are singly linked lists threaded
+/// through the edge array. Removed vertices and edges are put on a free list
+/// and their slots re-used by add_vertex() and add_edge(), so a handle to a removed
+/// vertex or edge must not be used.
+/// This replaces an earlier boost::adjacency_list with listS storage, where each
+/// vertex, edge and out/in-edge entry was a separately allocated list node.
 ///
 /// the hedi namespace contains functions for manipulating HEDIGraphs
 ///
 /// For a general description of the half-edge data structure see e.g.:
 ///  - http://www.holmes3d.net/graphics/dcel/
 ///  - http://openmesh.org/index.php?id=228
-template <class TOutEdgeList, 
-          class TVertexList,
-          class TDirected, 
-          class TVertexProperties,
+template <class TVertexProperties,
           class TEdgeProperties,
-          class TFaceProperties,
-          class TGraphProperties,
-          class TEdgeList 
+          class TFaceProperties
           >
-class HEDIGraph : public boost::adjacency_list< TOutEdgeList,           // out-edge storage
-                                                TVertexList,            // vertex set storage
-                                                TDirected,              // directed tag
-                                                TVertexProperties,      // vertex properties
-                                                TEdgeProperties,        // edge properties
-                                                TGraphProperties,       // graph-properties (?)
-                                                TEdgeList               // edge storage
-                                                > 
-{
+class HEDIGraph {
     public:
+        typedef HEDIVertex Vertex;
+        typedef HEDIEdge Edge;
         typedef unsigned int HEFace; 
-        typedef typename boost::adjacency_list< TOutEdgeList,            
-                                                TVertexList,            
-                                                TDirected,   
-                                                TVertexProperties,             
-                                                TEdgeProperties,                
-                                                TGraphProperties,
-                                                TEdgeList
-                                                > BGLGraph;
-        /// use base class operator[] for vertex and edge properties
-        using BGLGraph::operator[]; 
+        typedef TVertexProperties VertexProperties;
+        typedef TEdgeProperties EdgeProperties;
+        typedef TFaceProperties FaceProperties;
+        
+        HEDIGraph() : nvertices(0), nedges(0), free_vertex(NONE), free_edge(NONE) {}
+        
+        /// operator[] to access vertex properties
+        TVertexProperties& operator[](Vertex v) { 
+            return vertex_array[v.idx].props; 
+        }
+        /// const operator[] for accessing vertex properties
+        const TVertexProperties& operator[](Vertex v) const { 
+            return vertex_array[v.idx].props; 
+        }
+        /// operator[] to access edge properties
+        TEdgeProperties& operator[](Edge e) { 
+            return edge_array[e.idx].props; 
+        }
+        /// const operator[] for accessing edge properties
+        const TEdgeProperties& operator[](Edge e) const { 
+            return edge_array[e.idx].props; 
+        }
         /// operator[] to access face properties
         TFaceProperties& operator[](HEFace f)  { 
             return faces[f]; 
@@ -108,8 +150,164 @@ class HEDIGraph : public boost::adjacency_list< TOutEdgeList,           // out-e
         const TFaceProperties& operator[](HEFace f) const  { 
             return faces[f]; 
         }
+        
+        /// add a vertex with given properties, re-using a free slot if there is one
+        Vertex add_vertex(const TVertexProperties& prop) {
+            boost::uint32_t v = free_vertex;
+            if ( v == NONE ) {
+                v = vertex_array.size();
+                vertex_array.push_back( VertexRecord(prop) );
+            } else {
+                free_vertex = vertex_array[v].out;
+                vertex_array[v] = VertexRecord(prop);
+            }
+            ++nvertices;
+            return Vertex(v);
+        }
+        /// add an edge v1-v2 with default properties, last in the out-edges of v1
+        Edge add_edge(Vertex v1, Vertex v2) {
+            boost::uint32_t e = free_edge;
+            if ( e == NONE ) {
+                e = edge_array.size();
+                edge_array.push_back( EdgeRecord(v1.idx, v2.idx) );
+            } else {
+                free_edge = edge_array[e].next_out;
+                edge_array[e] = EdgeRecord(v1.idx, v2.idx);
+            }
+            append( vertex_array[v1.idx].out, e, &EdgeRecord::next_out );
+            append( vertex_array[v2.idx].in , e, &EdgeRecord::next_in );
+            ++nedges;
+            return Edge(e);
+        }
+        /// remove edge e
+        void remove_edge(Edge e) {
+            EdgeRecord& r = edge_array[e.idx];
+            assert( r.source != NONE );
+            unlink( vertex_array[r.source].out, e.idx, &EdgeRecord::next_out );
+            unlink( vertex_array[r.target].in , e.idx, &EdgeRecord::next_in );
+            r.source = NONE;
+            r.next_out = free_edge;
+            free_edge = e.idx;
+            --nedges;
+        }
+        /// remove all edges to and from vertex v
+        void clear_vertex(Vertex v) {
+            while ( vertex_array[v.idx].out != NONE )
+                remove_edge( Edge( vertex_array[v.idx].out ) );
+            while ( vertex_array[v.idx].in != NONE )
+                remove_edge( Edge( vertex_array[v.idx].in ) );
+        }
+        /// remove vertex v, which must not have any edges
+        void remove_vertex(Vertex v) {
+            VertexRecord& r = vertex_array[v.idx];
+            assert( r.alive && r.out == NONE && r.in == NONE );
+            r.alive = false;
+            r.out = free_vertex;
+            free_vertex = v.idx;
+            --nvertices;
+        }
+        
+        /// the source vertex of edge e
+        Vertex source(Edge e) const { return Vertex( edge_array[e.idx].source ); }
+        /// the target vertex of edge e
+        Vertex target(Edge e) const { return Vertex( edge_array[e.idx].target ); }
+        /// the first out-edge of v, or an invalid Edge if v has none
+        Edge first_out_edge(Vertex v) const { return Edge( vertex_array[v.idx].out ); }
+        /// the out-edge of source(e) after e, or an invalid Edge
+        Edge next_out_edge(Edge e) const { return Edge( edge_array[e.idx].next_out ); }
+        /// the first in-edge of v, or an invalid Edge if v has none
+        Edge first_in_edge(Vertex v) const { return Edge( vertex_array[v.idx].in ); }
+        /// the in-edge of target(e) after e, or an invalid Edge
+        Edge next_in_edge(Edge e) const { return Edge( edge_array[e.idx].next_in ); }
+        /// the edge v1-v2, or an invalid Edge if there is none
+        Edge find_edge(Vertex v1, Vertex v2) const {
+            boost::uint32_t e = vertex_array[v1.idx].out;
+            while ( e != NONE && edge_array[e].target != v2.idx )
+                e = edge_array[e].next_out;
+            return Edge(e);
+        }
+        
+        /// true if slot v of the vertex array holds a vertex
+        bool is_vertex(Vertex v) const { return vertex_array[v.idx].alive; }
+        /// true if slot e of the edge array holds an edge
+        bool is_edge(Edge e) const { return edge_array[e.idx].source != NONE; }
+        /// number of vertices
+        unsigned int num_vertices() const { return nvertices; }
+        /// number of edges
+        unsigned int num_edges() const { return nedges; }
+        /// size of the vertex array, including free slots
+        unsigned int vertex_slots() const { return vertex_array.size(); }
+        /// size of the edge array, including free slots
+        unsigned int edge_slots() const { return edge_array.size(); }
+        /// reserve space for nv vertices and ne edges
+        void reserve(unsigned int nv, unsigned int ne) {
+            vertex_array.reserve(nv);
+            edge_array.reserve(ne);
+        }
+        /// bytes allocated for vertices, edges and faces
+        std::size_t memory() const {
+            return vertex_array.capacity()*sizeof(VertexRecord) 
+                 + edge_array.capacity()*sizeof(EdgeRecord) 
+                 + faces.capacity()*sizeof(TFaceProperties);
+        }
 //DATA
         std::vector< TFaceProperties > faces;
+    protected:
+        /// index of no vertex or edge
+        static const boost::uint32_t NONE = HEDIVertex::NONE;
+        /// a vertex and the heads of its out-edge and in-edge lists
+        struct VertexRecord {
+            VertexRecord(const TVertexProperties& p) : props(p), out(NONE), in(NONE), alive(true) {}
+            TVertexProperties props;
+            /// first out-edge, or the next free vertex when on the free list
+            boost::uint32_t out;
+            /// first in-edge
+            boost::uint32_t in;
+            bool alive;
+        };
+        /// a half-edge, and the links of the out-edge and in-edge lists it is in
+        struct EdgeRecord {
+            EdgeRecord(boost::uint32_t s, boost::uint32_t t) : props(), source(s), target(t), next_out(NONE), next_in(NONE) {}
+            TEdgeProperties props;
+            /// source vertex, or NONE for a free edge
+            boost::uint32_t source;
+            boost::uint32_t target;
+            /// next out-edge of source, or the next free edge when on the free list
+            boost::uint32_t next_out;
+            /// next in-edge of target
+            boost::uint32_t next_in;
+        };
+        /// append edge e to the list starting at head and linked through link
+        void append(boost::uint32_t& head, boost::uint32_t e, boost::uint32_t EdgeRecord::* link) {
+            if ( head == NONE ) {
+                head = e;
+                return;
+            }
+            boost::uint32_t n = head;
+            while ( edge_array[n].*link != NONE )
+                n = edge_array[n].*link;
+            edge_array[n].*link = e;
+        }
+        /// remove edge e from the list starting at head and linked through link
+        void unlink(boost::uint32_t& head, boost::uint32_t e, boost::uint32_t EdgeRecord::* link) {
+            if ( head == e ) {
+                head = edge_array[e].*link;
+                return;
+            }
+            boost::uint32_t n = head;
+            while ( edge_array[n].*link != e )
+                n = edge_array[n].*link;
+            edge_array[n].*link = edge_array[e].*link;
+        }
+        
+        std::vector< VertexRecord > vertex_array;
+        std::vector< EdgeRecord > edge_array;
+        unsigned int nvertices;
+        unsigned int nedges;
+        /// first free slot of the vertex array
+        boost::uint32_t free_vertex;
+        /// first free slot of the edge array
+        boost::uint32_t free_edge;
 };
 
 // FIXME: why is the class outside the namespace but the functions are inside?
@@ -117,47 +315,33 @@ namespace hedi  { // collect half-edge diagram functions here.
 
 /// add a blank vertex and return its descriptor
 template<class Graph>
-typename boost::graph_traits< Graph >::vertex_descriptor add_vertex(Graph& g) { 
-    return boost::add_vertex( g );
+typename Graph::Vertex add_vertex(Graph& g) { 
+    return g.add_vertex( typename Graph::VertexProperties() );
 }
 
 /// add a vertex with given properties, return vertex descriptor
 template <class Graph, class VertexProperty>
-typename boost::graph_traits< Graph >::vertex_descriptor add_vertex(const VertexProperty& prop, Graph& g) {
-    return boost::add_vertex( prop, g );
+typename Graph::Vertex add_vertex(const VertexProperty& prop, Graph& g) {
+    return g.add_vertex( prop );
 }
 
 /// add an edge between vertices v1-v2
 template <class Graph>
-typename boost::graph_traits< Graph >::edge_descriptor add_edge(typename boost::graph_traits< Graph >::vertex_descriptor v1, 
-                                                       typename boost::graph_traits< Graph >::vertex_descriptor v2, 
-                                                       Graph& g) {
-    typename boost::graph_traits< Graph >::edge_descriptor e;
-    bool b;
-    boost::tie( e , b ) = boost::add_edge( v1, v2, g);
-    return e;
+typename Graph::Edge add_edge(typename Graph::Vertex v1, 
+                              typename Graph::Vertex v2, 
+                              Graph& g) {
+    return g.add_edge( v1, v2 );
 }
 
 /// make e1 the twin of e2 (and vice versa)
 template <class Graph>
-void twin_edges( typename boost::graph_traits< Graph >::edge_descriptor e1,
-                 typename boost::graph_traits< Graph >::edge_descriptor e2,
+void twin_edges( typename Graph::Edge e1,
+                 typename Graph::Edge e2,
                  Graph& g) {
     g[e1].twin = e2;
     g[e2].twin = e1;
 }
 
-        
-/*        
-        /// add an edge with given properties
-        HEEdge add_edge(HEVertex v1, HEVertex v2, EdgeProps prop) {
-            HEEdge e;
-            bool b;
-            boost::tie( e , b ) = boost::add_edge( v1, v2, prop, g);
-            return e;
-        }
-*/
-
 /// add a face with given properties
 template <class Graph, class FaceProperty>
 unsigned int add_face(FaceProperty f_prop, Graph& g) {
@@ -170,61 +354,54 @@ unsigned int add_face(FaceProperty f_prop, Graph& g) {
 
 /// return the target vertex of the given edge
 template <class Graph>
-typename boost::graph_traits< Graph >::vertex_descriptor target( typename boost::graph_traits< Graph >::edge_descriptor e,
-                                                                const Graph& g) { 
-    return boost::target( e, g);
+typename Graph::Vertex target( typename Graph::Edge e, const Graph& g) { 
+    return g.target( e );
 }
 
 /// return the source vertex of the given edge
 template <class Graph>
-typename boost::graph_traits< Graph >::vertex_descriptor source( typename boost::graph_traits< Graph >::edge_descriptor e,
-                                                        const Graph& g)  { 
-    return boost::source( e, g); 
+typename Graph::Vertex source( typename Graph::Edge e, const Graph& g)  { 
+    return g.source( e ); 
 }
 
 /// return all vertices in a vector of vertex descriptors
 template<class Graph>
-typename std::vector< typename boost::graph_traits<Graph>::vertex_descriptor > vertices(const Graph& g)  {
-    typedef typename boost::graph_traits< Graph >::vertex_descriptor  HEVertex;
-    typedef std::vector<HEVertex> VertexVector;
-    typedef typename boost::graph_traits< Graph >::vertex_iterator    HEVertexItr;
-    VertexVector vv;
-    HEVertexItr it_begin, it_end, itr;
-    boost::tie( it_begin, it_end ) = boost::vertices( g );
-    for ( itr=it_begin ; itr != it_end ; ++itr ) {
-        vv.push_back( *itr );
+typename std::vector< typename Graph::Vertex > vertices(const Graph& g)  {
+    typedef typename Graph::Vertex HEVertex;
+    std::vector<HEVertex> vv;
+    vv.reserve( g.num_vertices() );
+    for ( unsigned int n=0 ; n < g.vertex_slots() ; ++n ) {
+        if ( g.is_vertex( HEVertex(n) ) )
+            vv.push_back( HEVertex(n) );
     }
     return vv;
 }
 
 /// return all vertices adjecent to given vertex
 template <class Graph>
-typename std::vector< typename boost::graph_traits< Graph >::vertex_descriptor > 
-    adjacent_vertices(  typename boost::graph_traits< Graph >::vertex_descriptor v, Graph& g) {
-    typedef typename boost::graph_traits< Graph >::vertex_descriptor  HEVertex;
-    typedef typename boost::graph_traits< Graph >::edge_descriptor    HEEdge;
-    typedef std::vector<HEVertex> VertexVector;
-    VertexVector vv;
-    BOOST_FOREACH( HEEdge edge, out_edges( v , g) ) {
-        vv.push_back( target( edge , g) );
+typename std::vector< typename Graph::Vertex > adjacent_vertices( typename Graph::Vertex v, Graph& g) {
+    typedef typename Graph::Edge HEEdge;
+    std::vector< typename Graph::Vertex > vv;
+    for ( HEEdge e = g.first_out_edge(v) ; e != HEEdge() ; e = g.next_out_edge(e) ) {
+        vv.push_back( g.target(e) );
     }
     return vv;
 }
 
 /// return all vertices of given face
 template <class Graph>
-typename std::vector< typename boost::graph_traits< Graph >::vertex_descriptor > face_vertices(unsigned int face_idx, Graph& g) {
-    typedef typename boost::graph_traits< Graph >::vertex_descriptor  HEVertex;
-    typedef typename boost::graph_traits< Graph >::edge_descriptor    HEEdge;
+typename std::vector< typename Graph::Vertex > face_vertices(unsigned int face_idx, Graph& g) {
+    typedef typename Graph::Vertex HEVertex;
+    typedef typename Graph::Edge   HEEdge;
     typedef std::vector<HEVertex> VertexVector;
     
     VertexVector verts;
     HEEdge startedge = g[face_idx].edge; // the edge where we start
-    HEVertex start_target = boost::target( startedge, g); 
+    HEVertex start_target = g.target( startedge ); 
     verts.push_back(start_target);
     HEEdge current = g[startedge].next;
     do {
-        HEVertex current_target = boost::target( current, g); 
+        HEVertex current_target = g.target( current ); 
         assert( current_target != start_target );
         verts.push_back(current_target);
         current = g[current].next;
@@ -232,47 +409,44 @@ typename std::vector< typename boost::graph_traits< Graph >::vertex_descriptor >
     return verts;
 }
 
-
-
-/// return degree of given vertex
+/// return degree of given vertex, i.e. the number of out-edges and in-edges
 template <class Graph>
-unsigned int degree(typename boost::graph_traits< Graph >::vertex_descriptor v, const Graph& g)  { 
-    return boost::degree( v, g); 
+unsigned int degree(typename Graph::Vertex v, const Graph& g)  { 
+    typedef typename Graph::Edge HEEdge;
+    unsigned int d = 0;
+    for ( HEEdge e = g.first_out_edge(v) ; e != HEEdge() ; e = g.next_out_edge(e) )
+        ++d;
+    for ( HEEdge e = g.first_in_edge(v) ; e != HEEdge() ; e = g.next_in_edge(e) )
+        ++d;
+    return d; 
 }
 
 /// return number of vertices in graph
 template <class Graph>
 unsigned int num_vertices(const Graph& g) { 
-    return boost::num_vertices( g ); 
+    return g.num_vertices(); 
 }
 
 /// return out_edges of given vertex
 template <class Graph>
-typename std::vector< typename boost::graph_traits< Graph >::edge_descriptor > out_edges( 
-        typename boost::graph_traits< Graph >::vertex_descriptor v , const Graph& g)  {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor  HEEdge;
-    typedef std::vector<HEEdge> EdgeVector;  
-    typedef typename boost::graph_traits< Graph >::out_edge_iterator  HEOutEdgeItr;
-    EdgeVector ev;
-    HEOutEdgeItr it, it_end;
-    boost::tie( it, it_end ) = boost::out_edges( v, g );
-    for ( ; it != it_end ; ++it ) {
-        ev.push_back(*it);
+typename std::vector< typename Graph::Edge > out_edges( typename Graph::Vertex v , const Graph& g)  {
+    typedef typename Graph::Edge HEEdge;
+    std::vector<HEEdge> ev;
+    for ( HEEdge e = g.first_out_edge(v) ; e != HEEdge() ; e = g.next_out_edge(e) ) {
+        ev.push_back(e);
     }
     return ev;
 }
 
 /// return all edges
 template <class Graph>
-typename std::vector< typename boost::graph_traits< Graph >::edge_descriptor  >  edges(Graph& g) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor  HEEdge;
-    typedef typename std::vector< HEEdge > EdgeVector;
-    typedef typename boost::graph_traits< Graph >::edge_iterator      HEEdgeItr; 
-    EdgeVector ev;
-    HEEdgeItr it, it_end;
-    boost::tie( it, it_end ) = boost::edges( g );
-    for ( ; it != it_end ; ++it ) {
-        ev.push_back(*it);
+typename std::vector< typename Graph::Edge >  edges(Graph& g) {
+    typedef typename Graph::Edge HEEdge;
+    std::vector<HEEdge> ev;
+    ev.reserve( g.num_edges() );
+    for ( unsigned int n=0 ; n < g.edge_slots() ; ++n ) {
+        if ( g.is_edge( HEEdge(n) ) )
+            ev.push_back( HEEdge(n) );
     }
     return ev;
 }
@@ -280,12 +454,11 @@ typename std::vector< typename boost::graph_traits< Graph >::edge_descriptor  >
         
 /// return edges of face f
 template <class Graph>
-typename std::vector< typename boost::graph_traits< Graph >::edge_descriptor  > face_edges( unsigned int f, Graph& g) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor  HEEdge;
-    typedef typename std::vector< HEEdge > EdgeVector;
+typename std::vector< typename Graph::Edge > face_edges( unsigned int f, Graph& g) {
+    typedef typename Graph::Edge HEEdge;
     HEEdge start_edge = g[f].edge;
     HEEdge current_edge = start_edge;
-    EdgeVector out;
+    std::vector<HEEdge> out;
     do {
         out.push_back(current_edge);
         current_edge = g[current_edge].next;
@@ -295,9 +468,8 @@ typename std::vector< typename boost::graph_traits< Graph >::edge_descriptor  >
 
 /// return the previous edge. traverses all edges in face until previous found.
 template <class Graph>
-typename boost::graph_traits< Graph >::edge_descriptor previous_edge(
-                      typename boost::graph_traits< Graph >::edge_descriptor e, Graph& g) {
-    typename boost::graph_traits< Graph >::edge_descriptor previous = g[e].next;
+typename Graph::Edge previous_edge( typename Graph::Edge e, Graph& g) {
+    typename Graph::Edge previous = g[e].next;
     while ( g[previous].next != e ) {
         previous = g[previous].next;
     }
@@ -307,38 +479,29 @@ typename boost::graph_traits< Graph >::edge_descriptor previous_edge(
 
 /// return true if v1-v2 edge exists
 template <class Graph>
-bool has_edge( typename boost::graph_traits< Graph >::vertex_descriptor v1, 
-               typename boost::graph_traits< Graph >::vertex_descriptor v2, 
+bool has_edge( typename Graph::Vertex v1, 
+               typename Graph::Vertex v2, 
                Graph& g ) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor HEEdge;
-    typedef typename std::pair<HEEdge, bool> EdgeBool;
-    EdgeBool result = boost::edge(v1, v2, g );
-    return result.second;
+    return g.find_edge(v1, v2) != typename Graph::Edge();
 }
 
 /// return v1-v2 edge descriptor
 template <class Graph>
-typename boost::graph_traits< Graph >::edge_descriptor edge( 
-           typename boost::graph_traits< Graph >::vertex_descriptor v1, 
-           typename boost::graph_traits< Graph >::vertex_descriptor v2, 
-           Graph& g ) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor HEEdge;
-    typedef typename std::pair<HEEdge, bool> EdgeBool;
-    EdgeBool result = boost::edge(v1, v2, g );
-    return result.first;
+typename Graph::Edge edge( typename Graph::Vertex v1, 
+                           typename Graph::Vertex v2, 
+                           Graph& g ) {
+    return g.find_edge(v1, v2);
 }
 
 /// return adjacent faces to the given vertex
 template <class Graph>
-std::vector<unsigned int> adjacent_faces( typename boost::graph_traits< Graph >::vertex_descriptor q , Graph& g) {
-    typedef typename boost::graph_traits< Graph >::out_edge_iterator  HEOutEdgeItr;
+std::vector<unsigned int> adjacent_faces( typename Graph::Vertex q , Graph& g) {
+    typedef typename Graph::Edge HEEdge;
     typedef std::vector<unsigned int> FaceVector;
     
     std::set<unsigned int> face_set;
-    HEOutEdgeItr itr, itr_end;
-    boost::tie( itr, itr_end) = boost::out_edges(q, g);
-    for ( ; itr!=itr_end ; ++itr ) {
-        face_set.insert( g[*itr].face );
+    for ( HEEdge e = g.first_out_edge(q) ; e != HEEdge() ; e = g.next_out_edge(e) ) {
+        face_set.insert( g[e].face );
     }
     //assert( face_set.size() == 3); // degree of q is three, so has three faces
     FaceVector fv;
@@ -357,16 +520,31 @@ unsigned int num_faces(Graph& g) {
 /// return number of edges in graph
 template <class Graph>
 unsigned int num_edges(const Graph& g) { 
-    return boost::num_edges( g ); 
+    return g.num_edges(); 
+}
+
+/// remove the edge e
+template <class Graph>
+void remove_edge(typename Graph::Edge e, Graph& g) { 
+    g.remove_edge( e );
+}
+
+/// remove all v1-v2 edges
+template <class Graph>
+void remove_edge(typename Graph::Vertex v1, typename Graph::Vertex v2, Graph& g) { 
+    typename Graph::Edge e;
+    while ( (e = g.find_edge(v1, v2)) != typename Graph::Edge() )
+        g.remove_edge( e );
 }
 
+
 /// inserts given vertex into edge e, and into the twin edge e_twin
 template <class Graph>
-void insert_vertex_in_edge(typename boost::graph_traits< Graph >::vertex_descriptor  v, 
-                           typename boost::graph_traits< Graph >::edge_descriptor e, 
+void insert_vertex_in_edge(typename Graph::Vertex  v, 
+                           typename Graph::Edge e, 
                            Graph& g) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor    HEEdge;
-    typedef typename boost::graph_traits< Graph >::vertex_descriptor  HEVertex;
+    typedef typename Graph::Edge    HEEdge;
+    typedef typename Graph::Vertex  HEVertex;
     // the vertex v is in the middle of edge e
     //                    face
     //                    e1   e2
@@ -376,10 +554,10 @@ void insert_vertex_in_edge(typename boost::graph_traits< Graph >::vertex_descrip
     //                    twin_face
     
     HEEdge twin = g[e].twin;
-    HEVertex source = boost::source( e , g );
-    HEVertex target = boost::target( e , g);
-    HEVertex twin_source = boost::source( twin , g);
-    HEVertex twin_target = boost::target( twin , g );
+    HEVertex source = g.source( e );
+    HEVertex target = g.target( e );
+    HEVertex twin_source = g.source( twin );
+    HEVertex twin_target = g.target( twin );
     assert( source == twin_target );    
     assert( target == twin_source );
     
@@ -423,25 +601,25 @@ void insert_vertex_in_edge(typename boost::graph_traits< Graph >::vertex_descrip
     g.faces[twin_face].edge = te1;
     
     // finally, remove the old edge
-    boost::remove_edge( e   , g);
-    boost::remove_edge( twin, g);
+    g.remove_edge( e );
+    g.remove_edge( twin );
 }
 
 
 /// inserts given vertex into edge e
 template <class Graph>
-void insert_vertex_in_half_edge(typename boost::graph_traits< Graph >::vertex_descriptor  v, 
-                           typename boost::graph_traits< Graph >::edge_descriptor e, 
+void insert_vertex_in_half_edge(typename Graph::Vertex  v, 
+                           typename Graph::Edge e, 
                            Graph& g) {
-    typedef typename boost::graph_traits< Graph >::edge_descriptor    HEEdge;
-    typedef typename boost::graph_traits< Graph >::vertex_descriptor  HEVertex;
+    typedef typename Graph::Edge    HEEdge;
+    typedef typename Graph::Vertex  HEVertex;
     // the vertex v is in the middle of edge e
     //                    face
     //                    e1   e2
     // previous-> source  -> v -> target -> next
     
-    HEVertex source = boost::source( e , g );
-    HEVertex target = boost::target( e , g);
+    HEVertex source = g.source( e );
+    HEVertex target = g.target( e );
     unsigned int face = g[e].face;
     HEEdge previous = previous_edge(e, g);
     assert( g[previous].face == g[e].face );
@@ -457,7 +635,7 @@ void insert_vertex_in_half_edge(typename boost::graph_traits< Graph >::vertex_de
     // update the faces (required here?)
     g.faces[face].edge = e1;
     // finally, remove the old edge
-    boost::remove_edge( e   , g);
+    g.remove_edge( e );
     // NOTE: twinning is not done here, since the twin edge is not split...
 }
 
@@ -474,22 +652,22 @@ void insert_vertex_in_half_edge(typename boost::graph_traits< Graph >::vertex_de
             return true;
         }*/
 
-/// delete a vertex
-template <class Graph>
-void delete_vertex(typename boost::graph_traits< Graph >::vertex_descriptor  v, Graph& g) { 
-    clear_vertex(v, g);
-    remove_vertex(v, g); 
-}
-
 /// clear given vertex. this removes all edges connecting to the vertex.
 template <class Graph>
-void clear_vertex(typename boost::graph_traits< Graph >::vertex_descriptor v, Graph& g) { 
-    boost::clear_vertex( v, g ); 
+void clear_vertex(typename Graph::Vertex v, Graph& g) { 
+    g.clear_vertex( v ); 
 }
 /// remove given vertex
 template <class Graph>
-void remove_vertex(typename boost::graph_traits< Graph >::vertex_descriptor v, Graph& g) { 
-    boost::remove_vertex( v , g );
+void remove_vertex(typename Graph::Vertex v, Graph& g) { 
+    g.remove_vertex( v );
+}
+
+/// delete a vertex
+template <class Graph>
+void delete_vertex(typename Graph::Vertex  v, Graph& g) { 
+    clear_vertex(v, g);
+    remove_vertex(v, g); 
 }
 
 } // end hedi namespace
@@ -25,7 +25,6 @@
 #include <sstream>
 #include <string>
 
-#include <list>
 
 namespace ocl
 {
@@ -33,70 +32,37 @@ namespace ocl
 /// \brief K-D tree node. http://en.wikipedia.org/wiki/Kd-tree
 ///
 /// A k-d tree is used for searching for triangles overlapping with the cutter.
+/// The nodes of a KDTree are stored in one contiguous array in depth-first order.
+/// The lo child of an internal node at index n is at index n+1, the hi child
+/// is at index KDNode::hi.
 ///
-template < class BBObj > 
 class KDNode {
     public:
-        /// Create a node which partitions(cuts) along dimension d, at 
-        /// cut value cv, with child-nodes hi_c and lo_c.
-        /// If this is a bucket-node containing triangles, 
-        /// they are in the list tris
-        /// depth indicates the depth of the node in the tree
-        KDNode(int d, double cv,  KDNode<BBObj> *parentNode,                        // parent node
-                                  KDNode<BBObj> *hi_child,                        // hi-child
-                                  KDNode<BBObj> *lo_child,                        // lo-child
-                                  const std::list< BBObj >* tlist,     // list of tris, if bucket
-                                  int nodeDepth)                           // depth of node
-                                  {
-            dim = d;
-            cutval = cv;
-            parent = parentNode;
-            hi = hi_child;
-            lo = lo_child;
-            tris = new std::list<BBObj>();
-            depth = nodeDepth;
-            isLeaf = false;
-            if (tlist) {
-                isLeaf = true;
-                BOOST_FOREACH(BBObj bo, *tlist) {
-                    tris->push_back(bo);
-                }
-            }
-        }
-        virtual ~KDNode() {
-            // std::cout << " ~KDNode3()\n";
-            if (hi)
-                delete hi;
-            if (lo)
-                delete lo;
-            if (tris)
-                delete tris;
-        }
+        /// create an empty node
+        KDNode() : dim(0), cutval(0), maxz(0), hi(0), begin(0), end(0), isLeaf(false) {}
         /// string repr
         std::string str() const {
             std::ostringstream o;
-            o << "KDNode d:" << dim << " cv:" << cutval; 
+            o << "KDNode d:" << dim << " cv:" << cutval << " maxz:" << maxz; 
             return o.str();
         }
         
     // DATA
-        /// level of node in tree 
-        int depth;
         /// dimension of cut
         int dim;
         /// Cut value.
         /// Child node hi contains only triangles with a higher value than this.
         /// Child node lo contains triangles with lower values.
         double cutval;
-        /// parent-node
-        KDNode* parent; 
-        /// Child-node hi.
-        KDNode* hi; 
-        /// Child-node lo.
-        KDNode* lo; 
-        /// A list of triangles, if this is a bucket-node (NULL for internal nodes)
-        std::list< BBObj >* tris;
-        /// flag to indicate leaf in the tree. Leafs or bucket-nodes contain triangles in the list tris.
+        /// maximum z-coordinate of all objects in the sub-tree rooted at this node
+        double maxz;
+        /// index of the hi child-node (the lo child-node is the next node in the array)
+        unsigned int hi; 
+        /// index of the first object in this bucket-node (unused for internal nodes)
+        unsigned int begin;
+        /// index one past the last object in this bucket-node (unused for internal nodes)
+        unsigned int end;
+        /// flag to indicate leaf in the tree. Leafs or bucket-nodes contain the objects [begin, end).
         bool isLeaf;
 };
 
@@ -23,8 +23,12 @@
 
 #include <iostream>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <limits>
 
 #include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
 
 #include "kdnode.hpp"
 #include "bbox.hpp"
@@ -57,26 +61,41 @@ class Spread {
         double val;
         /// minimum or start value
         double start;
-        /// comparison of Spread objects. Used for finding the largest spread
-        /// along which the next partition/cut is made.
-        static bool spread_compare(Spread *x, Spread *y) {
-            if (x->val > y->val)
-                return true;
-            else
-                return false;
-        };
 };
 
 /// a kd-tree for storing triangles and fast searching for triangles
 /// that overlap the cutter
+///
+/// The objects are stored in one contiguous array, and the nodes in another
+/// contiguous array in depth-first order. Each bucket-node refers to
+/// a range of the object array. The tree is built by splitting an index-array in
+/// place at the median of the dimension with the largest spread. 
+/// Sub-trees are built in parallel with OpenMP tasks.
+/// Each node also stores the maximum z-coordinate of its sub-tree, which
+/// visit_cutter_drop() uses to skip sub-trees that cannot lift the cutter.
+/// The cuts on the way down from the root bound the XY-region of a node, which
+/// visit_cutter_footprint() tests against the circular footprint of the cutter, 
+/// rather than its square bounding-box.
 template <class BBObj>
 class KDTree {
     public:
-        KDTree() {};
-        virtual ~KDTree() {
-            // std::cout << " ~KDTree()\n";
-            delete root;
+        /// the largest number of CL-points in a packet, see visit_packet_drop()
+        static const unsigned int maxPacket = 64;
+        /// a set of the CL-points of a packet: bit k is CL-point k
+        typedef boost::uint64_t PacketMask;
+        /// the lowest CL-point of the non-empty set m
+        static unsigned int lowest(PacketMask m) {
+#ifdef __GNUC__
+            return __builtin_ctzll(m);
+#else
+            unsigned int k = 0;
+            while ( !((m >> k) & 1) )
+                ++k;
+            return k;
+#endif
         }
+        KDTree() : bucketSize(1) {};
+        virtual ~KDTree() {}
         /// set the bucket-size 
         void setBucketSize(int b){
             std::cout << "KDTree::setBucketSize = " << b << "\n"; 
@@ -112,187 +131,522 @@ class KDTree {
         /// build the kd-tree based on a list of input objects
         void build(const std::list<BBObj>& list){
             std::cout << "KDTree::build() list.size()= " << list.size() << " \n";
-            root = build_node( &list, 0, NULL ); 
+            assert( !dimensions.empty() );
+            if (bucketSize < 1)
+                bucketSize = 1;
+            objs.assign( list.begin(), list.end() );
+            nodes.clear();
+            order.clear();
+            if ( objs.empty() )
+                return;
+            unsigned int nobj = objs.size();
+            std::vector<unsigned int> idx( nobj );
+            for (unsigned int n=0; n<nobj; ++n)
+                idx[n] = n;
+            nodes.resize( subtree_size(nobj) );
+            #pragma omp parallel shared(idx)
+            {
+                #pragma omp single
+                build_node( idx, 0, nobj, 0 );
+            } // all tasks are complete at the end of the parallel region
+            // re-order objects so that each bucket-node refers to a contiguous range
+            std::vector<BBObj> sorted;
+            sorted.reserve( nobj );
+            for (unsigned int n=0; n<nobj; ++n)
+                sorted.push_back( objs[ idx[n] ] );
+            objs.swap( sorted );
+            order.swap( idx );
         }
+        /// restore a tree that was built earlier, instead of calling build().
+        /// input holds the objects in the order they were given to build(), and 
+        /// dims, bucket, n and ord are the getDimensions(), getBucketSize(), getNodes() and
+        /// getOrder() of the built tree.
+        void restore(   const std::vector<BBObj>& input, const std::vector<int>& dims, unsigned int bucket, 
+                        const std::vector<KDNode>& n, const std::vector<unsigned int>& ord ) {
+            dimensions = dims;
+            bucketSize = bucket;
+            nodes = n;
+            order = ord;
+            objs.clear();
+            objs.reserve( order.size() );
+            BOOST_FOREACH( unsigned int m, order ) {
+                objs.push_back( input[m] );
+            }
+        }
+        /// return the bucket-size
+        unsigned int getBucketSize() const {return bucketSize;}
+        /// return the search dimensions
+        const std::vector<int>& getDimensions() const {return dimensions;}
+        /// return the nodes in depth-first order
+        const std::vector<KDNode>& getNodes() const {return nodes;}
+        /// return the build order. get(n) is object getOrder()[n] of the input to build()
+        const std::vector<unsigned int>& getOrder() const {return order;}
+        /// return the number of objects stored in the tree
+        unsigned int size() const {return objs.size();}
+        /// return the number of nodes in the tree
+        unsigned int nodeCount() const {return nodes.size();}
+        /// return the object with index n. Indices are those returned by the 
+        /// buffer-filling search() and search_cutter_overlap() below.
+        const BBObj& get(unsigned int n) const {return objs[n];}
         /// search for overlap with input Bbox bb, return found objects
-        std::list<BBObj>* search( const Bbox& bb ){
-            assert( !dimensions.empty() );
+        std::list<BBObj>* search( const Bbox& bb ) const {
+            std::vector<unsigned int> idx;
+            this->search( bb, idx );
             std::list<BBObj>* tris = new std::list<BBObj>();
-            this->search_node( tris, bb, root );
+            BOOST_FOREACH( unsigned int n, idx ) {
+                tris->push_back( objs[n] );
+            }
             return tris;
         }
+        /// search for overlap with input Bbox bb. The indices of found objects 
+        /// are placed in the caller-owned buffer idx, which is cleared first.
+        /// A buffer re-used between calls makes the search allocation-free.
+        void search( const Bbox& bb, std::vector<unsigned int>& idx ) const {
+            idx.clear();
+            IndexCollector collector( idx );
+            this->visit( bb, collector );
+        }
+        /// call visitor v(n) for the index n of each object in a bucket-node overlapping bb
+        template <class Visitor>
+        void visit( const Bbox& bb, Visitor& v ) const {
+            assert( !dimensions.empty() );
+            if ( !nodes.empty() )
+                this->search_node( v, bb, 0 );
+        }
         /// search for overlap with a MillingCutter c positioned at cl, return found objects
-        std::list<BBObj>* search_cutter_overlap(const MillingCutter* c, CLPoint* cl ){
-            double r = c->getRadius();
-            // build a bounding-box at the current CL
-            Bbox bb( cl->x-r, cl->x+r, cl->y-r, cl->y+r, cl->z, cl->z+c->getLength() );    
-            return this->search( bb );
+        std::list<BBObj>* search_cutter_overlap(const MillingCutter* c, CLPoint* cl ) const {
+            return this->search( cutter_bbox(c, cl) );
+        }
+        /// search for overlap with a MillingCutter c positioned at cl. 
+        /// Indices of found objects are placed in idx, see search()
+        void search_cutter_overlap(const MillingCutter* c, const CLPoint* cl, std::vector<unsigned int>& idx ) const {
+            this->search( cutter_bbox(c, cl), idx );
+        }
+        /// call visitor v(n) for each object overlapping with a MillingCutter c positioned at cl
+        template <class Visitor>
+        void visit_cutter_overlap(const MillingCutter* c, const CLPoint* cl, Visitor& v ) const {
+            this->visit( cutter_bbox(c, cl), v );
+        }
+        /// search for objects whose bounding-box overlaps the footprint of MillingCutter c positioned at cl,
+        /// the circle of radius c->getRadius() in the XY-plane, rather than the square of search_cutter_overlap().
+        /// The tree must have XY dimensions. Indices of found objects are placed in idx, see search()
+        void search_cutter_footprint(const MillingCutter* c, const CLPoint* cl, std::vector<unsigned int>& idx ) const {
+            idx.clear();
+            IndexCollector collector( idx );
+            this->visit_cutter_footprint( c, cl, collector );
+        }
+        /// call visitor v(n) for each object whose bounding-box overlaps the footprint of MillingCutter c 
+        /// positioned at cl, see search_cutter_footprint()
+        template <class Visitor>
+        void visit_cutter_footprint(const MillingCutter* c, const CLPoint* cl, Visitor& v ) const {
+            assert( !dimensions.empty() );
+            if ( !nodes.empty() )
+                this->footprint_node( v, cutter_bbox(c, cl), cl, c->getRadius(), 0, 
+                                      -std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), 
+                                      -std::numeric_limits<double>::max(), std::numeric_limits<double>::max() );
+        }
+        /// drop-cutter search with branch-and-bound on the maximum z-coordinate of the nodes.
+        /// Calls visitor v(n) for each object overlapping with MillingCutter c positioned at cl,
+        /// where v(n) is expected to lift cl. Overlapping sub-trees are visited in order of 
+        /// descending maximum z, and a sub-tree is skipped when it lies entirely below cl->z.
+        template <class Visitor>
+        void visit_cutter_drop(const MillingCutter* c, const CLPoint* cl, Visitor& v ) const {
+            assert( !dimensions.empty() );
+            if ( !nodes.empty() )
+                this->drop_node( v, cutter_bbox(c, cl), cl, 0 );
+        }
+        /// drop-cutter search for a packet of n <= maxPacket CL-points cls[0] ... cls[n-1], 
+        /// with one traversal of the tree for the whole packet. The tree must have XY dimensions.
+        /// A sub-tree is visited when the union of the cutter bounding-boxes overlaps it, and skipped
+        /// when it lies entirely below all the CL-points. At each bucket-node, calls visitor v(n, mask)
+        /// for each object n, with the mask of the CL-points whose cutter overlaps the object in XY and
+        /// which are below its maximum z. v(n, mask) is expected to lift those CL-points.
+        /// The CL-points should be close together in XY, e.g. a tile of a path or a raster.
+        template <class Visitor>
+        void visit_packet_drop(const MillingCutter* c, CLPoint* const* cls, unsigned int n, Visitor& v ) const {
+            assert( !dimensions.empty() );
+            assert( n <= maxPacket );
+            if ( nodes.empty() || n == 0 )
+                return;
+            Packet pk(c, cls, n);
+            this->drop_packet_node( v, pk, pk.all(), 0 );
         }
         /// string repr
         std::string str() const;
         
     protected:
-        /// build and return a KDNode containing list *tris at depth dep.
-        KDNode<BBObj>* build_node(     const std::list<BBObj> *tris,  // triangles 
-                                        int dep,                       // depth of node
-                                        KDNode<BBObj> *par)   {       // parent node
-            //std::cout << "KDNode::build_node list.size()=" << tris->size() << "\n";
-            
-            if (tris->size() == 0 ) { //this is a fatal error.
-                std::cout << "ERROR: KDTree::build_node() called with tris->size()==0 ! \n";
-                assert(0);
-                return 0;
+        /// visitor which appends found indices to a vector
+        class IndexCollector {
+            public:
+                /// collect into the vector v
+                IndexCollector(std::vector<unsigned int>& v) : out(v) {}
+                /// add index n
+                void operator()(unsigned int n) {out.push_back(n);}
+            private:
+                /// output vector
+                std::vector<unsigned int>& out;
+        };
+        /// the CL-points of visit_packet_drop(), and the XY bounding-box of the cutter at each of them
+        class Packet {
+            public:
+                /// the cutter c positioned at the n CL-points cls[0] ... cls[n-1]
+                Packet(const MillingCutter* c, CLPoint* const* p, unsigned int np) : cls(p), n(np) {
+                    const double r = c->getRadius();
+                    for (unsigned int k=0; k<n; ++k) {
+                        box[0][k] = cls[k]->x - r;
+                        box[1][k] = cls[k]->x + r;
+                        box[2][k] = cls[k]->y - r;
+                        box[3][k] = cls[k]->y + r;
+                    }
+                }
+                /// the mask of all CL-points
+                PacketMask all() const {
+                    return (n == maxPacket) ? ~PacketMask(0) : ( (PacketMask(1) << n) - 1 );
+                }
+                /// the CL-points of m which are below z
+                PacketMask below(double z, PacketMask m) const {
+                    PacketMask out = m;
+                    for (PacketMask r = m; r; r &= r-1) {
+                        const unsigned int k = lowest(r);
+                        if ( !(cls[k]->z < z) )
+                            out &= ~(PacketMask(1) << k);
+                    }
+                    return out;
+                }
+                /// the CL-points of m whose bounding-box reaches above (hi=true) or below (hi=false) 
+                /// the value cv along dimension d. As overlapping_children(), for one CL-point at a time.
+                PacketMask reaching(unsigned int d, double cv, bool hi, PacketMask m) const {
+                    PacketMask out = m;
+                    const double* b = box[ hi ? (d | 1) : (d & ~1u) ];
+                    for (PacketMask r = m; r; r &= r-1) {
+                        const unsigned int k = lowest(r);
+                        if ( hi ? (cv > b[k]) : (cv < b[k]) )
+                            out &= ~(PacketMask(1) << k);
+                    }
+                    return out;
+                }
+                /// the CL-points of m which overlap object o in XY, and are below it
+                PacketMask overlaps(const BBObj& o, PacketMask m) const {
+                    PacketMask out = m;
+                    for (PacketMask r = m; r; r &= r-1) {
+                        const unsigned int k = lowest(r);
+                        if ( (o.bb.maxpt.x < box[0][k]) || (o.bb.minpt.x > box[1][k]) || 
+                             (o.bb.maxpt.y < box[2][k]) || (o.bb.minpt.y > box[3][k]) || 
+                             (cls[k]->z >= o.bb.maxpt.z) )
+                            out &= ~(PacketMask(1) << k);
+                    }
+                    return out;
+                }
+                /// the CL-points
+                CLPoint* const* cls;
+                /// number of CL-points
+                unsigned int n;
+                /// box[d][k] is Bbox[d] of the cutter at CL-point k, for the dimensions d = 0, 1, 2, 3 (XY)
+                double box[4][maxPacket];
+        };
+        /// true if the box [x0, x1] x [y0, y1] lies entirely outside the circle of radius r centred at (x, y)
+        static bool outside_circle(double x0, double x1, double y0, double y1, double x, double y, double r) {
+            const double dx = std::max( std::max( x0-x, x-x1 ), 0.0 );
+            const double dy = std::max( std::max( y0-y, y-y1 ), 0.0 );
+            return dx*dx + dy*dy > r*r;
+        }
+        /// orders object indices by one coordinate of the object bounding-box
+        class IndexCompare {
+            public:
+                /// compare objects in o along dimension d
+                IndexCompare(const std::vector<BBObj>& o, int d) : objects(o), dim(d) {}
+                /// true if object a is below object b
+                bool operator()(unsigned int a, unsigned int b) const {
+                    return objects[a].bb[dim] < objects[b].bb[dim];
+                }
+            private:
+                /// the objects
+                const std::vector<BBObj>& objects;
+                /// dimension to compare
+                int dim;
+        };
+        /// return a bounding-box of the MillingCutter c positioned at cl
+        Bbox cutter_bbox(const MillingCutter* c, const CLPoint* cl) const {
+            double r = c->getRadius();
+            // build a bounding-box at the current CL
+            return Bbox( cl->x-r, cl->x+r, cl->y-r, cl->y+r, cl->z, cl->z+c->getLength() );    
+        }
+        /// return the number of nodes in a tree of n objects
+        unsigned int subtree_size(unsigned int n) const {
+            unsigned int cn, cn1;
+            subtree_sizes(n, cn, cn1);
+            return cn;
+        }
+        /// number of nodes in trees of n and n+1 objects.
+        /// A node with more than bucketSize objects is split into floor(n/2) and ceil(n/2) objects,
+        /// so both sizes only depend on the sizes for n/2 and n/2+1 objects.
+        void subtree_sizes(unsigned int n, unsigned int& cn, unsigned int& cn1) const {
+            if ( n+1 <= bucketSize ) {
+                cn = 1;
+                cn1 = 1;
+                return;
             }
-            Spread* spr = calc_spread(tris); // calculate spread in order to know how to cut
-            double cutvalue = spr->start + spr->val/2; // cut in the middle
-            //std::cout << " cutvalue= " << cutvalue << "\n";
-            if ( (tris->size() <= bucketSize) ||  isZero_tol( spr->val ) ) {  // then return a bucket/leaf node
-                //std::cout << "KDNode::build_node BUCKET list.size()=" << tris->size() << "\n";
-                KDNode<BBObj> *bucket;   //  dim   cutv   parent   hi    lo   triangles depth
-                bucket = new KDNode<BBObj>(spr->d, cutvalue , par , NULL, NULL, tris, dep);
-                assert( bucket->isLeaf );
-                delete spr;
-                return bucket; // this is the leaf/end of the recursion-tree
+            unsigned int cm, cm1;
+            subtree_sizes( n/2, cm, cm1 );
+            if ( n%2 == 0 ) { // n=2m splits into (m,m), n+1=2m+1 into (m,m+1)
+                cn  = (n <= bucketSize) ? 1 : 1 + 2*cm;
+                cn1 = 1 + cm + cm1;
+            } else {          // n=2m+1 splits into (m,m+1), n+1=2m+2 into (m+1,m+1)
+                cn  = (n <= bucketSize) ? 1 : 1 + cm + cm1;
+                cn1 = 1 + 2*cm1;
             }
-            // build lists of triangles for hi and lo child nodes
-            std::list<BBObj>* lolist = new std::list<BBObj>();
-            std::list<BBObj>* hilist = new std::list<BBObj>();
-            BOOST_FOREACH(BBObj t, *tris) { // loop through each triangle and put it in either lolist or hilist
-                if (t.bb[spr->d] > cutvalue) 
-                    hilist->push_back(t);
-                else
-                    lolist->push_back(t);
-            } 
-            
-            /*
-            if (hilist->empty() || lolist->empty()) {// an error ??
-                std::cout << "kdtree: hilist.size()==0! or lolist.size()==0! \n";
-                std::cout << "kdtree: tris->size()= " << tris->size()<< "\n";
-                std::cout << "kdtree: hilist.size()= " << hilist->size()<< "\n";
-                std::cout << "kdtree: lolist.size()= " << lolist->size()<< "\n";
-                BOOST_FOREACH(BBObj t, *tris) {
-                    std::cout << t << "\n";
-                    std::cout << t.bb << "\n";
-                }
-                std::cout << "kdtree: spr->d= " << spr->d << "\n";
-                std::cout << "kdtree: cutvalue= " << cutvalue << "\n";
-                assert(0);
-            }*/
-            
-            
-            // create the current node  dim     value    parent  hi   lo   trilist  depth
-            KDNode<BBObj> *node = new KDNode<BBObj>(spr->d, cutvalue, par, NULL,NULL,NULL, dep);
-            // create the child-nodes through recursion
-            //                    list    depth   parent
-            if (!hilist->empty())
-                node->hi = build_node(hilist, dep+1, node); 
-            //else
-                //std::cout << "hilist empty!\n";
-                
-            if (!lolist->empty()) {
-                node->lo = build_node(lolist, dep+1, node); 
-            } else {
-                //std::cout << "lolist empty!\n";
+        }
+        /// build the sub-tree rooted at nodes[node] containing the objects idx[first, last).
+        /// idx[first, last) is partitioned in place.
+        void build_node(    std::vector<unsigned int>& idx, // object indices
+                            unsigned int first,             // first index
+                            unsigned int last,              // one past last index
+                            unsigned int node) {            // position of node
+            assert( last > first );
+            KDNode& nd = nodes[node];
+            if ( (last-first) <= bucketSize ) {  // then this is a bucket/leaf node
+                nd.begin = first;
+                nd.end = last;
+                nd.isLeaf = true;
+                nd.maxz = objs[ idx[first] ].bb.maxpt.z;
+                for (unsigned int n=first+1; n<last; ++n)
+                    nd.maxz = std::max( nd.maxz, objs[ idx[n] ].bb.maxpt.z );
+                return; // this is the leaf/end of the recursion-tree
             }
-             
-            lolist->clear();
-            hilist->clear();
-            delete spr;
-            delete lolist;
-            delete hilist;
-            
-            return node; // return a new node
+            Spread spr = calc_spread(idx, first, last); // calculate spread in order to know how to cut
+            // split at the median along the dimension of largest spread
+            unsigned int mid = first + (last-first)/2;
+            std::nth_element( idx.begin()+first, idx.begin()+mid, idx.begin()+last, IndexCompare(objs, spr.d) );
+            nd.dim = spr.d;
+            nd.cutval = objs[ idx[mid] ].bb[ spr.d ];
+            // lo child-node follows this node, hi child-node follows the lo sub-tree
+            unsigned int lo = node+1;
+            nd.hi = lo + subtree_size( mid-first );
+            unsigned int hi = nd.hi;
+            // sub-trees write to disjoint parts of idx and nodes, so they can be built in parallel
+            #pragma omp task shared(idx) if ( (last-first) > taskSize )
+            build_node( idx, first, mid, lo );
+            #pragma omp task shared(idx) if ( (last-first) > taskSize )
+            build_node( idx, mid, last, hi );
+            #pragma omp taskwait
+            nd.maxz = std::max( nodes[lo].maxz, nodes[hi].maxz );
         };
         
-        /// calculate the spread of list *tris                        
-        Spread* calc_spread(const std::list<BBObj> *tris) {
+        /// calculate the spread of the objects idx[begin, end)
+        Spread calc_spread(const std::vector<unsigned int>& idx, unsigned int begin, unsigned int end) const {
             std::vector<double> maxval( 6 );
             std::vector<double> minval( 6 );
-            if ( tris->empty() ) {
-                std::cout << " ERROR, KDTree::calc_spread() called with tris->size()==0 ! \n";
-                assert( 0 );
-                return NULL;
-            } else {
-                // find out the maximum spread
-                //std::cout << "calc_spread()...\n";
-                bool first=true;
-                BOOST_FOREACH(BBObj t, *tris) { // check each triangle
-                    for (unsigned int m=0;m<dimensions.size();++m) {
-                        // dimensions[m] is the dimensions we want to update
-                        // t.bb[ dimensions[m] ]   is the update value
-                        if (first) {
-                            maxval[ dimensions[m] ] = t.bb[ dimensions[m] ];
-                            minval[ dimensions[m] ] = t.bb[ dimensions[m] ];
-                            if (m==(dimensions.size()-1) )
-                                first=false;
-                        } else {
-                            if (maxval[ dimensions[m] ] < t.bb[ dimensions[m] ] )
-                                maxval[ dimensions[m] ] = t.bb[ dimensions[m] ];
-                            if (minval[ dimensions[m] ] > t.bb[ dimensions[m] ])
-                                minval[ dimensions[m] ] = t.bb[ dimensions[m] ];
-                        }
-                    }
-                } 
-                std::vector<Spread*> spreads;// calculate the spread along each dimension
-                for (unsigned int m=0;m<dimensions.size();++m) {   // dim,  spread, start
-                    spreads.push_back( new Spread(dimensions[m] , 
-                                       maxval[dimensions[m]]-minval[dimensions[m]], 
-                                       minval[dimensions[m]] ) );  
-                }// priority-queue could also be used ??  
-                assert( !spreads.empty() );
-                //std::cout << " spreads.size()=" << spreads.size() << "\n";
-                std::sort(spreads.begin(), spreads.end(), Spread::spread_compare); // sort the list
-                Spread* s= new Spread(*spreads[0]); // this is the one we want to return
-                while(!spreads.empty()) delete spreads.back(), spreads.pop_back(); // delete the others
-                //std::cout << "calc_spread() done\n";
-                return s; // select the biggest spread and return
-            } // end tris->size != 0
+            assert( end > begin );
+            for (unsigned int m=0;m<dimensions.size();++m) {
+                maxval[ dimensions[m] ] = objs[ idx[begin] ].bb[ dimensions[m] ];
+                minval[ dimensions[m] ] = maxval[ dimensions[m] ];
+            }
+            for (unsigned int n=begin+1; n<end; ++n) { // check each triangle
+                const BBObj& t = objs[ idx[n] ];
+                for (unsigned int m=0;m<dimensions.size();++m) {
+                    // dimensions[m] is the dimensions we want to update
+                    // t.bb[ dimensions[m] ]   is the update value
+                    double v = t.bb[ dimensions[m] ];
+                    if (maxval[ dimensions[m] ] < v )
+                        maxval[ dimensions[m] ] = v;
+                    if (minval[ dimensions[m] ] > v )
+                        minval[ dimensions[m] ] = v;
+                }
+            } 
+            // select the biggest spread and return
+            Spread s( dimensions[0], maxval[dimensions[0]]-minval[dimensions[0]], minval[dimensions[0]] );
+            for (unsigned int m=1;m<dimensions.size();++m) {
+                double val = maxval[dimensions[m]]-minval[dimensions[m]];
+                if ( val > s.val )
+                    s = Spread( dimensions[m], val, minval[dimensions[m]] );
+            }
+            return s;
         } // end spread();
         
         
-        /// search kd-tree starting at *node, looking for overlap with bb, and placing
-        /// found objects in *tris
-        void search_node( std::list<BBObj> *tris, const Bbox& bb, KDNode<BBObj> *node) {
-            if (node->isLeaf ) { // we found a bucket node, so add all triangles and return.
-            
-                BOOST_FOREACH( BBObj t, *(node->tris) ) {
-                        tris->push_back(t); 
-                } 
-                //std::cout << " search_node Leaf bucket tris-size() = " << tris->size() << "\n";
-                return; // end recursion
-            } else if ( (node->dim % 2) == 0) { // cutting along a min-direction: 0, 2, 4
-                // not a bucket node, so recursevily seach hi/lo branches of KDNode
-                unsigned int maxdim = node->dim+1;
-                if ( node->cutval > bb[maxdim] ) { // search only lo
-                    search_node(tris, bb, node->lo );
-                } else { // need to search both child nodes
-                    if (node->hi)
-                        search_node(tris, bb, node->hi );
-                    if (node->lo)
-                        search_node(tris, bb, node->lo );
-                }
+        /// find out which child-nodes of the internal node nd may contain objects overlapping bb
+        void overlapping_children(const KDNode& nd, const Bbox& bb, bool& lo, bool& hi) const {
+            lo = true;
+            hi = true;
+            if ( (nd.dim % 2) == 0) { // cutting along a min-direction: 0, 2, 4
+                unsigned int maxdim = nd.dim+1;
+                if ( nd.cutval > bb[maxdim] ) // search only lo
+                    hi = false;
             } else { // cutting along a max-dimension: 1,3,5
-                unsigned int mindim = node->dim-1;
-                if ( node->cutval < bb[mindim] ) { // search only hi
-                    search_node(tris, bb, node->hi);
-                } else { // need to search both child nodes
-                    if (node->hi)
-                        search_node(tris, bb, node->hi);
-                    if (node->lo)
-                        search_node(tris, bb, node->lo);
-                }
+                unsigned int mindim = nd.dim-1;
+                if ( nd.cutval < bb[mindim] ) // search only hi
+                    lo = false;
             }
+        }
+        
+        /// search kd-tree starting at nodes[node], looking for overlap with bb, and calling
+        /// the visitor v(n) for the index n of each found object
+        template <class Visitor>
+        void search_node( Visitor& v, const Bbox& bb, unsigned int node) const {
+            const KDNode& nd = nodes[node];
+            if ( nd.isLeaf ) { // we found a bucket node, so add all triangles and return.
+                for (unsigned int n=nd.begin; n<nd.end; ++n)
+                    v(n);
+                return; // end recursion
+            } 
+            // not a bucket node, so recursevily seach hi/lo branches of KDNode
+            bool lo, hi;
+            overlapping_children(nd, bb, lo, hi);
+            if (hi)
+                search_node(v, bb, nd.hi );
+            if (lo)
+                search_node(v, bb, node+1 );
             return; // Done. We get here after all the recursive calls above.
         } // end search_kdtree();
+        
+        /// as search_node(), but skip sub-trees whose XY-region [x0, x1] x [y0, y1] lies outside the circle 
+        /// of radius r at cl, and objects whose bounding-box does. All objects of the hi child-node of a cut 
+        /// along a min-dimension (0 or 2) lie above the cut, and those of the lo child-node of a cut along
+        /// a max-dimension (1 or 3) below it, so these child-nodes have a smaller region than the node.
+        /// Only these smaller regions are tested.
+        template <class Visitor>
+        void footprint_node( Visitor& v, const Bbox& bb, const CLPoint* cl, double r, unsigned int node, 
+                             double x0, double x1, double y0, double y1) const {
+            const KDNode& nd = nodes[node];
+            if ( nd.isLeaf ) {
+                for (unsigned int n=nd.begin; n<nd.end; ++n) {
+                    const Bbox& ob = objs[n].bb;
+                    if ( !outside_circle( ob.minpt.x, ob.maxpt.x, ob.minpt.y, ob.maxpt.y, cl->x, cl->y, r ) )
+                        v(n);
+                }
+                return;
+            }
+            bool lo, hi;
+            overlapping_children(nd, bb, lo, hi);
+            double hx0 = x0, hy0 = y0; // region of the hi child-node
+            double lx1 = x1, ly1 = y1; // region of the lo child-node
+            if ( hi && (nd.dim == 0 || nd.dim == 2) ) {
+                if ( nd.dim == 0 )
+                    hx0 = std::max( x0, nd.cutval );
+                else
+                    hy0 = std::max( y0, nd.cutval );
+                hi = !outside_circle( hx0, x1, hy0, y1, cl->x, cl->y, r );
+            } else if ( lo && (nd.dim == 1 || nd.dim == 3) ) {
+                if ( nd.dim == 1 )
+                    lx1 = std::min( x1, nd.cutval );
+                else
+                    ly1 = std::min( y1, nd.cutval );
+                lo = !outside_circle( x0, lx1, y0, ly1, cl->x, cl->y, r );
+            }
+            if (hi)
+                footprint_node(v, bb, cl, r, nd.hi, hx0, x1, hy0, y1 );
+            if (lo)
+                footprint_node(v, bb, cl, r, node+1, x0, lx1, y0, ly1 );
+        }
+        
+        /// as search_node(), but skip sub-trees below cl->z and visit the higher child-node first
+        template <class Visitor>
+        void drop_node( Visitor& v, const Bbox& bb, const CLPoint* cl, unsigned int node) const {
+            const KDNode& nd = nodes[node];
+            if ( !(cl->z < nd.maxz) ) // the whole sub-tree is below the cutter
+                return;
+            if ( nd.isLeaf ) {
+                for (unsigned int n=nd.begin; n<nd.end; ++n)
+                    v(n);
+                return;
+            } 
+            bool lo, hi;
+            overlapping_children(nd, bb, lo, hi);
+            if ( lo && hi ) { 
+                // the higher sub-tree first, it is likely to lift cl so that the lower one can be skipped
+                if ( nodes[node+1].maxz > nodes[nd.hi].maxz ) {
+                    drop_node(v, bb, cl, node+1);
+                    drop_node(v, bb, cl, nd.hi);
+                } else {
+                    drop_node(v, bb, cl, nd.hi);
+                    drop_node(v, bb, cl, node+1);
+                }
+            } else if (hi) {
+                drop_node(v, bb, cl, nd.hi);
+            } else if (lo) {
+                drop_node(v, bb, cl, node+1);
+            }
+        }
+        
+        /// as drop_node(), for the CL-points m of packet pk. A child-node is visited with those
+        /// CL-points of m that overlap it, and the CL-points below nd.maxz.
+        template <class Visitor>
+        void drop_packet_node( Visitor& v, const Packet& pk, PacketMask m, unsigned int node) const {
+            const KDNode& nd = nodes[node];
+            m = pk.below( nd.maxz, m );
+            if ( m == 0 ) // the whole sub-tree is below all the CL-points
+                return;
+            if ( nd.isLeaf ) {
+                for (unsigned int n=nd.begin; n<nd.end; ++n) {
+                    // objects earlier in the bucket may have lifted some CL-points
+                    const PacketMask om = pk.overlaps( objs[n], m );
+                    if ( om )
+                        v(n, om);
+                }
+                return;
+            }
+            PacketMask lo = m, hi = m;
+            if ( (nd.dim % 2) == 0 ) // cutting along a min-direction, as overlapping_children()
+                hi = pk.reaching( nd.dim, nd.cutval, true, m );
+            else
+                lo = pk.reaching( nd.dim, nd.cutval, false, m );
+            // the higher sub-tree first, as in drop_node()
+            if ( nodes[node+1].maxz > nodes[nd.hi].maxz ) {
+                if (lo) drop_packet_node(v, pk, lo, node+1);
+                if (hi) drop_packet_node(v, pk, hi, nd.hi);
+            } else {
+                if (hi) drop_packet_node(v, pk, hi, nd.hi);
+                if (lo) drop_packet_node(v, pk, lo, node+1);
+            }
+        }
     // DATA
         /// bucket size of tree
         unsigned int bucketSize;
-        /// pointer to root KDNode
-        KDNode<BBObj>* root;
+        /// sub-trees with more objects than this are built as separate OpenMP tasks
+        static const unsigned int taskSize = 4096;
+        /// the nodes of the tree in depth-first order. nodes[0] is the root.
+        std::vector<KDNode> nodes;
+        /// contiguous array of objects. Each bucket-node refers to a range in this array.
+        std::vector<BBObj> objs;
+        /// objs[n] is object order[n] of the input to build()
+        std::vector<unsigned int> order;
         /// the dimensions in this kd-tree
         std::vector<int> dimensions;
 };
 
+// definition of the in-class constant, for when it is passed by reference (e.g. to std::min)
+template <class BBObj>
+const unsigned int KDTree<BBObj>::maxPacket;
+
+/// visitor for KDTree::visit_cutter_drop(). Drops the cutter at cl against each
+/// found object that overlaps the cutter and is not below cl.
+template <class BBObj>
+class CutterDropVisitor {
+    public:
+        /// drop cutter c at cl against objects of tree t
+        CutterDropVisitor(const KDTree<BBObj>* t, const MillingCutter* c, CLPoint& p) 
+            : calls(0), tree(t), cutter(c), cl(p) {}
+        /// drop against object n
+        void operator()(unsigned int n) {
+            const BBObj& t = tree->get(n);
+            if ( cutter->overlaps(cl,t) ) { // cutter overlap triangle? check
+                if ( cl.below(t) ) {
+                    cutter->dropCutter(cl,t);
+                    ++calls;
+                }
+            }
+        }
+        /// number of dropCutter() calls made
+        int calls;
+    private:
+        /// the kd-tree
+        const KDTree<BBObj>* tree;
+        /// the cutter
+        const MillingCutter* cutter;
+        /// the cl-point which is lifted
+        CLPoint& cl;
+};
+
 } // end namespace
 #endif
 // end file kdtree3.h
@@ -0,0 +1,110 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace ocl
+{
+
+/// \brief read-only view of the contents of a whole file
+///
+/// On POSIX systems the file is memory-mapped, so pages are read by the OS on
+/// demand and can be read from several threads without copying. Elsewhere 
+/// the file is read into memory.
+class MappedFile {
+    public:
+        /// open and map the file path. Check isOpen() for success.
+        MappedFile(const std::string& path) : ptr(NULL), len(0), mapped(false), ok(false) {
+#ifndef WIN32
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+            struct stat st;
+            if ( ::fstat(fd, &st) == 0 ) {
+                len = st.st_size;
+                ok = true;
+                if (len > 0) {
+                    void* p = ::mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p == MAP_FAILED) {
+                        len = 0;
+                        ok = false;
+                    } else {
+                        ptr = static_cast<const char*>(p);
+                        mapped = true;
+                    }
+                }
+            }
+            ::close(fd); // the mapping stays valid after close
+#else
+            std::ifstream ifs(path.c_str(), std::ios::binary);
+            if (!ifs)
+                return;
+            ifs.seekg(0, std::ios::end);
+            len = ifs.tellg();
+            ifs.seekg(0, std::ios::beg);
+            buffer.resize(len);
+            if (len > 0)
+                ifs.read(&buffer[0], len);
+            ok = !ifs.fail();
+            ptr = len ? &buffer[0] : NULL;
+#endif
+        }
+        virtual ~MappedFile() {
+#ifndef WIN32
+            if (mapped)
+                ::munmap( const_cast<char*>(ptr), len );
+#endif
+        }
+        /// true if the file was opened
+        bool isOpen() const {return ok;}
+        /// pointer to the first byte of the file
+        const char* data() const {return ptr;}
+        /// size of the file in bytes
+        std::size_t size() const {return len;}
+    private:
+        MappedFile(const MappedFile&); // non-copyable
+        MappedFile& operator=(const MappedFile&);
+        /// file contents
+        const char* ptr;
+        /// file size
+        std::size_t len;
+        /// true if ptr is an mmap() mapping
+        bool mapped;
+        /// true if the file was opened
+        bool ok;
+        /// file contents, when not memory-mapped
+        std::vector<char> buffer;
+};
+
+} // end namespace
+#endif
+// end file mappedfile.hpp
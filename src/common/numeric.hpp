@@ -20,6 +20,7 @@
 #ifndef NUMERIC_H
 #define NUMERIC_H
 
+#include <cmath>
 #include <string>
 
 
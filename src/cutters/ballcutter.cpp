@@ -17,6 +17,7 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -21,6 +21,7 @@
 #ifndef BALL_CUTTER_H
 #define BALL_CUTTER_H
 
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -34,6 +35,7 @@ namespace ocl
 /// \brief Ball or Spherical MillingCutter (ball-nose endmill)
 ///
 class BallCutter : public MillingCutter {
+    template <class CutterT> friend class MeshDropEngine; // calls height() and singleEdgeDropCanonical()
     public:
         BallCutter();
         /// create a BallCutter with diameter d (radius d/2) and length l
@@ -36,6 +36,7 @@ namespace ocl
 /// defined by the cutter diameter and by the corner radius
 ///
 class BullCutter : public MillingCutter {
+    template <class CutterT> friend class MeshDropEngine; // calls height() and singleEdgeDropCanonical()
     public:
         BullCutter();
         /// Create bull-cutter with diamter d, corner radius r, and length l.
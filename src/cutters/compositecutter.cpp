@@ -17,6 +17,7 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -90,9 +91,9 @@ unsigned int CompositeCutter::radius_to_index(double r) const {
 }
 
 bool CompositeCutter::ccValidRadius(unsigned int n, CLPoint& cl) const {
-    if (cl.cc->type == NONE)
+    if (cl.cc.type == NONE)
         return false;
-    double d = cl.xyDistance(*cl.cc);
+    double d = cl.xyDistance(cl.cc);
     double lolimit;
     double hilimit;
     if (n==0)
@@ -152,18 +153,12 @@ bool CompositeCutter::facetDrop(CLPoint &cl, const Triangle &t) const {
     bool result = false;
     for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
         CLPoint cl_tmp = cl + CLPoint(0,0,zoffset[n]);
-        CCPoint* cc_tmp;
         if ( cutter[n]->facetDrop(cl_tmp, t) ) {
-            assert( cl_tmp.cc != 0);
             if ( ccValidRadius(n,cl_tmp) ) { // cc-point is valid
-                cc_tmp = new CCPoint(*cl_tmp.cc);
-                if (cl.liftZ( cl_tmp.z - zoffset[n] )) { // we need to lift the cutter
-                    cc_tmp->type = FACET;
-                    cl.cc = cc_tmp;
+                CCPoint cc_tmp = cl_tmp.cc;
+                cc_tmp.type = FACET;
+                if ( cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp ) ) // we need to lift the cutter
                     result = true;
-                } else {
-                    delete cc_tmp;
-                }
             }
         }
     }
@@ -175,17 +170,60 @@ bool CompositeCutter::edgeDrop(CLPoint &cl, const Triangle &t) const {
     bool result = false;
     for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
         CLPoint cl_tmp = cl + Point(0,0,zoffset[n]);
-        CCPoint* cc_tmp;
         if ( cutter[n]->edgeDrop(cl_tmp,t) ) { // drop sub-cutter against edge
             if ( ccValidRadius(n,cl_tmp) ) { // check if cc-point is valid
-                cc_tmp = new CCPoint(*cl_tmp.cc);
-                if (cl.liftZ( cl_tmp.z - zoffset[n] ) ) { // we need to lift the cutter
-                    cc_tmp->type = EDGE;
-                    cl.cc = cc_tmp;
+                CCPoint cc_tmp = cl_tmp.cc;
+                cc_tmp.type = EDGE;
+                if ( cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp ) ) // we need to lift the cutter
+                    result = true;
+            }
+        }
+    }
+    return result;
+}
+
+bool CompositeCutter::singleEdgeDrop(CLPoint &cl, const Point& p1, const Point& p2) const {
+    bool result = false;
+    for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
+        CLPoint cl_tmp = cl + Point(0,0,zoffset[n]);
+        if ( cutter[n]->singleEdgeDrop(cl_tmp,p1,p2) ) { // drop sub-cutter against edge
+            if ( ccValidRadius(n,cl_tmp) ) { // check if cc-point is valid
+                CCPoint cc_tmp = cl_tmp.cc;
+                cc_tmp.type = EDGE;
+                if ( cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp ) ) // we need to lift the cutter
+                    result = true;
+            }
+        }
+    }
+    return result;
+}
+
+bool CompositeCutter::meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const {
+    bool result = false;
+    for (unsigned int c=0; c<cutter.size(); ++c) { // loop through cutters
+        CLPoint cl_tmp = cl + CLPoint(0,0,zoffset[c]);
+        if ( cutter[c]->meshFacetDrop(cl_tmp, m, n) ) {
+            if ( ccValidRadius(c,cl_tmp) ) { // cc-point is valid
+                CCPoint cc_tmp = cl_tmp.cc;
+                cc_tmp.type = FACET;
+                if ( cl.liftZ( cl_tmp.z - zoffset[c], cc_tmp ) ) // we need to lift the cutter
+                    result = true;
+            }
+        }
+    }
+    return result;
+}
+
+bool CompositeCutter::meshEdgeDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const {
+    bool result = false;
+    for (unsigned int c=0; c<cutter.size(); ++c) { // loop through cutters
+        CLPoint cl_tmp = cl + Point(0,0,zoffset[c]);
+        if ( cutter[c]->meshEdgeDrop(cl_tmp,m,n) ) { // drop sub-cutter against edge
+            if ( ccValidRadius(c,cl_tmp) ) { // check if cc-point is valid
+                CCPoint cc_tmp = cl_tmp.cc;
+                cc_tmp.type = EDGE;
+                if ( cl.liftZ( cl_tmp.z - zoffset[c], cc_tmp ) ) // we need to lift the cutter
                     result = true;
-                } else {
-                    delete cc_tmp;
-                }
             }
         }
     }
@@ -215,6 +253,29 @@ bool CompositeCutter::vertexPush(const Fiber& f, Interval& i, const Triangle& t)
     return result;
 }
 
+bool CompositeCutter::singleVertexPush(const Fiber& f, Interval& i, const Point& p) const {
+    bool result = false;
+    std::vector< std::pair<double, CCPoint> > contacts;
+    for (unsigned int n=0; n<cutter.size(); ++n) {
+        Interval ci;
+        Fiber cf(f);
+        cf.p1.z = f.p1.z + zoffset[n];
+        cf.p2.z = f.p2.z + zoffset[n]; // raised/lowered fiber to push along
+        if ( cutter[n]->singleVertexPush(cf,ci,p) ) {
+            if ( ccValidHeight( n, ci.upper_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.upper, ci.upper_cc) );
+            if ( ccValidHeight( n, ci.lower_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.lower, ci.lower_cc) );
+        }
+    }
+    
+    for( unsigned int n=0; n<contacts.size(); ++n ) {
+        i.update( contacts[n].first, contacts[n].second );
+        result = true;
+    }
+    return result;
+}
+
 // push each cutter against facet
 //  if the cc-point is valid (at correct height), store interval data
 // push all interval data into the original interval
@@ -242,7 +303,53 @@ bool CompositeCutter::facetPush(const Fiber& f, Interval& i, const Triangle& t)
     return result;
 }
 
+bool CompositeCutter::meshFacetPush(const Fiber& f, Interval& i, const IndexedMesh& m, unsigned int n) const {
+    bool result = false;
+    std::vector< std::pair<double, CCPoint> > contacts;
+    for (unsigned int c=0; c<cutter.size(); ++c) {
+        Interval ci;
+        Fiber cf(f);
+        cf.p1.z = f.p1.z + zoffset[c];
+        cf.p2.z = f.p2.z + zoffset[c]; // raised/lowered fiber to push along
+        if ( cutter[c]->meshFacetPush(cf,ci,m,n) ) {
+            if ( ccValidHeight( c, ci.upper_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.upper, ci.upper_cc) );
+            if ( ccValidHeight( c, ci.lower_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.lower, ci.lower_cc) );
+        }
+    }
+    
+    for( unsigned int k=0; k<contacts.size(); ++k ) {
+        i.update( contacts[k].first, contacts[k].second );
+        result = true;
+    }
+    return result;
+}
+
+
 
+bool CompositeCutter::singleEdgePush(const Fiber& f, Interval& i, const Point& p1, const Point& p2) const {
+    bool result = false;
+    std::vector< std::pair<double, CCPoint> > contacts;
+    for (unsigned int n=0; n<cutter.size(); ++n) {
+        Interval ci; // interval for this cutter
+        Fiber cf(f); // fiber for this cutter
+        cf.p1.z = f.p1.z + zoffset[n];
+        cf.p2.z = f.p2.z + zoffset[n]; // raised/lowered fiber to push along
+        if ( cutter[n]->singleEdgePush(cf,ci,p1,p2) ) {
+            if ( ccValidHeight( n, ci.upper_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.upper, ci.upper_cc) );
+            if ( ccValidHeight( n, ci.lower_cc, f ) )
+                contacts.push_back( std::pair<double,CCPoint>(ci.lower, ci.lower_cc) );
+        }
+    }
+    
+    for( unsigned int n=0; n<contacts.size(); ++n ) {
+        i.update( contacts[n].first, contacts[n].second );
+        result = true;
+    }
+    return result;
+}
 
 bool CompositeCutter::edgePush(const Fiber& f, Interval& i, const Triangle& t) const {
     bool result = false;
@@ -53,6 +53,18 @@ class CompositeCutter : public MillingCutter {
         bool facetDrop(CLPoint &cl, const Triangle &t) const;
         /// call edgeDrop on each cutter and pick the correct (highest valid CL-point) result
         bool edgeDrop(CLPoint &cl, const Triangle &t) const;
+        /// call singleEdgeDrop on each cutter and pick the correct (highest valid CL-point) result
+        bool singleEdgeDrop(CLPoint &cl, const Point& p1, const Point& p2) const;
+        /// call meshFacetDrop on each cutter and pick a valid cc-point
+        bool meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const;
+        /// call meshEdgeDrop on each cutter and pick a valid cc-point
+        bool meshEdgeDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const;
+        /// call meshFacetPush on each cutter and keep the contacts at a valid height
+        bool meshFacetPush(const Fiber& f, Interval& i, const IndexedMesh& m, unsigned int n) const;
+        /// call singleVertexPush on each cutter and keep the contacts at a valid height
+        bool singleVertexPush(const Fiber& f, Interval& i, const Point& p) const;
+        /// call singleEdgePush on each cutter and keep the contacts at a valid height
+        bool singleEdgePush(const Fiber& f, Interval& i, const Point& p1, const Point& p2) const;
         
         std::string str() const;
     protected:   
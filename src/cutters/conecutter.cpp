@@ -17,6 +17,7 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -25,6 +26,7 @@
 
 #include "conecutter.hpp"
 #include "compositecutter.hpp" // for offsetCutter()
+#include "indexedmesh.hpp"
 #include "numeric.hpp"
 
 namespace ocl
@@ -102,6 +104,35 @@ bool ConeCutter::facetDrop(CLPoint &cl, const Triangle &t) const {
     }
 }
 
+// facetDrop() with the precomputed normal, plane and inside-test of the face
+bool ConeCutter::meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const {
+    const MeshFaceData& fd = m.faceData();
+    if ( fd.flags[n] & MeshFaceData::VERTICAL )
+        return false;  //can't drop against vertical surface
+    if ( fd.flags[n] & MeshFaceData::HORIZONTAL ) {  // horizontal plane special case
+        CCPoint cc_tmp( cl.x, cl.y, fd.z[0][n], FACET_TIP );
+        return fd.isInside(n, cc_tmp) && cl.liftZ(cc_tmp.z, cc_tmp);
+    } 
+    const double a = fd.nx[n];
+    const double b = fd.ny[n];
+    const double c = fd.nz[n];
+    const double d = fd.d[n];
+    const Point xyNormal( fd.xynx[n], fd.xyny[n], 0.0 );
+    // cylindrical contact point case
+    CCPoint cyl_cc_tmp =  cl - radius*xyNormal;
+    cyl_cc_tmp.z = (1.0/c)*(-d-a*cyl_cc_tmp.x-b*cyl_cc_tmp.y);
+    double cyl_cl_z = cyl_cc_tmp.z - length; // tip positioned here
+    cyl_cc_tmp.type = FACET_CYL;
+    // tip contact with facet
+    CCPoint tip_cc_tmp(cl.x,cl.y,0.0);
+    tip_cc_tmp.z = (1.0/c)*(-d-a*tip_cc_tmp.x-b*tip_cc_tmp.y);
+    double tip_cl_z = tip_cc_tmp.z;
+    tip_cc_tmp.type = FACET_TIP;
+    if ( fd.isInside(n, tip_cc_tmp) && cl.liftZ(tip_cl_z, tip_cc_tmp) )
+        return true;
+    return fd.isInside(n, cyl_cc_tmp) && cl.liftZ(cyl_cl_z, cyl_cc_tmp);
+}
+
 // cone sliced with vertical plane results in a hyperbola as the intersection curve
 // find point where hyperbola and line slopes match
 CC_CLZ_Pair ConeCutter::singleEdgeDropCanonical( const Point& u1, const Point& u2) const {
@@ -144,6 +175,19 @@ bool ConeCutter::facetPush(const Fiber& fib, Interval& i,  const Triangle& t) co
     return result;
 }
 
+bool ConeCutter::meshFacetPush(const Fiber& fib, Interval& i, const IndexedMesh& m, unsigned int n) const {
+    Point p[3];
+    Point normal, xy_normal;
+    if ( !meshFacetPushData(m, n, p, normal, xy_normal) )
+        return false;
+    bool result = false;
+    if ( generalFacetPush( 0, 0, 0, fib, i, p, normal, xy_normal) ) // TIP
+        result = true;
+    if ( generalFacetPush( 0, this->center_height, this->xy_normal_length, fib, i, p, normal, xy_normal) ) // BASE
+        result = true;
+    return result;
+}
+
 // cone is pushed along Fiber f into contact with edge p1-p2
 bool ConeCutter::generalEdgePush(const Fiber& f, Interval& i,  const Point& p1, const Point& p2) const {
     bool result = false;
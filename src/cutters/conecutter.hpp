@@ -34,6 +34,7 @@ namespace ocl
 /// cone defined by diameter and the cone half-angle(in radians). sharp tip. 
 /// 60 degrees or 90 degrees are common
 class ConeCutter : public MillingCutter {
+    template <class CutterT> friend class MeshDropEngine; // calls height() and singleEdgeDropCanonical()
     public:
         ConeCutter();
         /// create a ConeCutter with specified maximum diameter and cone-angle
@@ -43,6 +44,10 @@ class ConeCutter : public MillingCutter {
         MillingCutter* offsetCutter(double d) const;
         /// Cone facet-drop is special, since we can make contact with either the tip or the circular rim
         bool facetDrop(CLPoint &cl, const Triangle &t) const; 
+        /// facetDrop() with the precomputed data of face n of m
+        bool meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const;
+        /// facetPush() with the precomputed data of face n of m
+        bool meshFacetPush(const Fiber& f, Interval& i, const IndexedMesh& m, unsigned int n) const;
         /// string repr
         friend std::ostream& operator<<(std::ostream &stream, ConeCutter c);
         std::string str() const;
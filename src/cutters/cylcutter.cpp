@@ -18,6 +18,7 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -69,24 +70,22 @@ CC_CLZ_Pair CylCutter::singleEdgeDropCanonical(const Point& u1, const Point& u2)
     return CC_CLZ_Pair( cc_u, cl_z);
 }
 
-// general purpose vertexPush, delegates to this->width(h) 
-bool CylCutter::vertexPush(const Fiber& f, Interval& i, const Triangle& t) const {
-    bool result = false;
-    BOOST_FOREACH( const Point& p, t.p) {
-        if (this->singleVertexPush(f,i,p, VERTEX) )
+// the flat bottom of the cutter sits at f.p1.z, so in addition to the vertices
+// we must push against the point where the edge crosses that z-height.
+// Done per edge (rather than per triangle with Triangle::zslice_verts) so that
+// an edge shared by many triangles is only sliced once.
+bool CylCutter::singleEdgePush(const Fiber& f, Interval& i,  const Point& p1, const Point& p2) const {
+    bool result = MillingCutter::singleEdgePush(f,i,p1,p2);
+    const double zcut = f.p1.z;
+    if ( (p1.z > zcut) != (p2.z > zcut) ) { // one end above, one end at or below zcut
+        const Point& above = ( p1.z > zcut ) ? p1 : p2;
+        const Point& below = ( p1.z > zcut ) ? p2 : p1;
+        double t = (zcut - above.z) / (below.z - above.z);
+        Point p = above + t*(below - above);
+        p.z = zcut; // z-coord should be very close to zcut, but set it exactly anyway.
+        if ( this->singleVertexPush(f,i,p, VERTEX_CYL) )
             result = true;
     }
-
-    Point p1, p2;
-    if ( t.zslice_verts(p1, p2, f.p1.z) ) {
-        p1.z = f.p1.z; // z-coord should be very close to f.p1.z, but set it exactly anyway.
-        p2.z = f.p1.z;
-        if ( this->singleVertexPush(f,i,p1, VERTEX_CYL) )
-            result = true;
-        if (this->singleVertexPush(f,i,p2, VERTEX_CYL))
-            result = true;
-    }
-    
     return result;
 }
 
@@ -36,6 +36,7 @@ namespace ocl
 ///
 /// defined by one parameter, the cutter diameter
 class CylCutter : public MillingCutter {
+    template <class CutterT> friend class MeshDropEngine; // calls height() and singleEdgeDropCanonical()
     public:
         CylCutter();
         /// create CylCutter with diameter d and length l
@@ -45,8 +46,9 @@ class CylCutter : public MillingCutter {
         /// string repr
         friend std::ostream& operator<<(std::ostream &stream, CylCutter c);        
         std::string str() const;
+        /// edge-push, and a push against the point where the edge crosses the fiber z-height
+        bool singleEdgePush(const Fiber& f, Interval& i,  const Point& p1, const Point& p2) const;
     protected:
-        bool vertexPush(const Fiber& f, Interval& i, const Triangle& t) const;
         CC_CLZ_Pair singleEdgeDropCanonical(const Point& u1, const Point& u2) const;
         double height(double r) const {return ( r <= radius ) ? 0.0 : -1.0;}
         double width(double h) const {return radius;} 
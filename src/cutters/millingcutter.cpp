@@ -18,9 +18,12 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
+
 #include <boost/foreach.hpp>
 
 #include "millingcutter.hpp"
+#include "indexedmesh.hpp"
 #include "numeric.hpp"
 
 namespace ocl
@@ -35,16 +38,21 @@ MillingCutter* MillingCutter::offsetCutter(double d) const {
 bool MillingCutter::vertexDrop(CLPoint &cl, const Triangle &t) const {
     bool result = false;
     BOOST_FOREACH( const Point& p, t.p) {           // test each vertex of triangle
-        double q = cl.xyDistance(p);                // distance in XY-plane from cl to p
-        if ( q <= radius ) {                        // p is inside the cutter
-            CCPoint cc_tmp(p, VERTEX);
-            if ( cl.liftZ( p.z - this->height(q), cc_tmp ) )
-                result = true;
-        } 
+        if ( this->singleVertexDrop(cl, p) )
+            result = true;
     }
     return result;
 }
 
+bool MillingCutter::singleVertexDrop(CLPoint &cl, const Point& p) const {
+    double q = cl.xyDistance(p);                    // distance in XY-plane from cl to p
+    if ( q <= radius ) {                            // p is inside the cutter
+        CCPoint cc_tmp(p, VERTEX);
+        return cl.liftZ( p.z - this->height(q), cc_tmp );
+    } 
+    return false;
+}
+
 // general purpose facet-drop which calls xy_normal_length(), normal_length(), 
 // and center_height() on the subclass
 bool MillingCutter::facetDrop(CLPoint &cl, const Triangle &t) const { // Drop cutter at (cl.x, cl.y) against facet of Triangle t
@@ -73,6 +81,25 @@ bool MillingCutter::facetDrop(CLPoint &cl, const Triangle &t) const { // Drop cu
     }
 }
 
+// facetDrop() with the precomputed normal, plane and inside-test of the face
+bool MillingCutter::meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const {
+    const MeshFaceData& fd = m.faceData();
+    if ( fd.flags[n] & MeshFaceData::VERTICAL ) 
+        return false;  //can't drop against vertical surface
+    if ( fd.flags[n] & MeshFaceData::HORIZONTAL ) { // horizontal plane special case
+        CCPoint cc_tmp( cl.x, cl.y, fd.z[0][n], FACET);
+        return fd.isInside(n, cc_tmp) && cl.liftZ(cc_tmp.z, cc_tmp);
+    } 
+    const Point normal( fd.nx[n], fd.ny[n], fd.nz[n] );
+    const Point xyNormal( fd.xynx[n], fd.xyny[n], 0.0 );
+    Point radiusvector = this->xy_normal_length*xyNormal + this->normal_length*normal;
+    CCPoint cc_tmp = cl - radiusvector; 
+    cc_tmp.z = (1.0/normal.z)*(-fd.d[n]-normal.x*cc_tmp.x-normal.y*cc_tmp.y); // cc-point lies in the plane.
+    cc_tmp.type = FACET;
+    double tip_z = cc_tmp.z + radiusvector.z - this->center_height;
+    return fd.isInside(n, cc_tmp) && cl.liftZ(tip_z, cc_tmp);
+}
+
 // edge-drop function which calls the sub-class MillingCutter::singleEdgeDrop on each 
 // edge of the input Triangle t.
 bool MillingCutter::edgeDrop(CLPoint &cl, const Triangle &t) const {
@@ -80,18 +107,21 @@ bool MillingCutter::edgeDrop(CLPoint &cl, const Triangle &t) const {
     for (int n=0;n<3;n++) { // loop through all three edges
         int start=n;      // index of the start-point of the edge
         int end=(n+1)%3;  // index of the end-point of the edge
-        const Point p1 = t.p[start];
-        const Point p2 = t.p[end];
-        if ( !isZero_tol( p1.x - p2.x) || !isZero_tol( p1.y - p2.y) ) {
-            const double d = cl.xyDistanceToLine(p1,p2);
-            if (d<=radius)  // potential contact with edge
-                if ( this->singleEdgeDrop(cl,p1,p2,d) )
-                    result=true;
-        }
+        if ( this->singleEdgeDrop(cl, t.p[start], t.p[end]) )
+            result=true;
     }
     return result;
 }
 
+bool MillingCutter::singleEdgeDrop(CLPoint &cl, const Point& p1, const Point& p2) const {
+    if ( !isZero_tol( p1.x - p2.x) || !isZero_tol( p1.y - p2.y) ) { // vertical edges are handled by vertexDrop
+        const double d = cl.xyDistanceToLine(p1,p2);
+        if (d<=radius)  // potential contact with edge
+            return this->singleEdgeDrop(cl,p1,p2,d);
+    }
+    return false;
+}
+
 // "dual" edge-drop problems
 // cylinder: zero diam edge/ellipse, r-radius cylinder, find r-offset == cl  (ITO surface XY-slice is a circle)
 // sphere: zero diam cylinder. ellipse around edge, find offset == cl (ITO surface slice is ellipse) (?)
@@ -113,6 +143,48 @@ bool MillingCutter::singleEdgeDrop(CLPoint& cl, const Point& p1, const Point& p2
     return cl.liftZ_if_InsidePoints( contact.second , cc_tmp , p1, p2);
 }
 
+// singleEdgeDrop() with the precomputed xy-direction and length of the edge.
+// the closest point on the edge, and the canonical coordinates, follow from one dot- and one cross-product.
+bool MillingCutter::meshEdgeDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const {
+    Point up1, up2;
+    double s;
+    if ( !meshEdgeCanonical(cl, m, n, up1, up2, s) )
+        return false;
+    CC_CLZ_Pair contact = this->singleEdgeDropCanonical( up1, up2 ); // the subclass handles this
+    return meshEdgeLift(cl, m, n, s, contact);
+}
+
+bool MillingCutter::meshEdgeCanonical(const CLPoint& cl, const IndexedMesh& m, unsigned int n, 
+                                      Point& up1, Point& up2, double& s) const {
+    const MeshEdgeData& ed = m.edgeData();
+    const double len = ed.len[n];
+    if ( len == 0.0 ) // vertical edges are handled by vertexDrop
+        return false;
+    const Point& p1 = m.vertex( m.edge(n).v[0] );
+    const Point& p2 = m.vertex( m.edge(n).v[1] );
+    const double rx = cl.x - p1.x;
+    const double ry = cl.y - p1.y;
+    s = rx*ed.ux[n] + ry*ed.uy[n];                      // distance along the edge from p1 to the point closest to cl
+    const double d = fabs( ed.ux[n]*ry - ed.uy[n]*rx ); // distance from cl to the line
+    if ( d > radius ) 
+        return false;
+    // edge endpoints in the canonical position, with cl at the origin and the edge along the x-axis
+    up1 = Point( -s, d, p1.z );
+    up2 = Point( len-s, d, p2.z );
+    return true;
+}
+
+bool MillingCutter::meshEdgeLift(CLPoint& cl, const IndexedMesh& m, unsigned int n, double s, 
+                                 const CC_CLZ_Pair& contact) {
+    const Point& p1 = m.vertex( m.edge(n).v[0] );
+    const Point& p2 = m.vertex( m.edge(n).v[1] );
+    const double u = (s + contact.first) / m.edgeData().len[n]; // cc-point is p1 + u*(p2-p1)
+    if ( (u < 0.0) || (u > 1.0) ) // cc-point is outside the edge
+        return false;
+    CCPoint cc_tmp( p1.x + u*(p2.x-p1.x), p1.y + u*(p2.y-p1.y), p1.z + u*(p2.z-p1.z), EDGE );
+    return cl.liftZ( contact.second, cc_tmp );
+}
+
 // general purpose vertexPush, delegates to this->width(h) 
 bool MillingCutter::vertexPush(const Fiber& f, Interval& i, const Triangle& t) const {
     bool result = false;
@@ -123,6 +195,10 @@ bool MillingCutter::vertexPush(const Fiber& f, Interval& i, const Triangle& t) c
     return result;
 }
 
+bool MillingCutter::singleVertexPush(const Fiber& f, Interval& i, const Point& p) const {
+    return this->singleVertexPush(f,i,p, VERTEX);
+}
+
 bool MillingCutter::singleVertexPush(const Fiber& f, Interval& i, const Point& p, CCType cctyp) const {
     bool result = false;
     if ( ( p.z >= f.p1.z ) && ( p.z <= (f.p1.z+ this->getLength()) ) ) { // p.z is within cutter
@@ -150,8 +226,29 @@ bool MillingCutter::facetPush(const Fiber& fib, Interval& i,  const Triangle& t)
                             this->xy_normal_length,
                             fib,i,t);
 }
-    
-// general purpose facetPush
+
+bool MillingCutter::meshFacetPush(const Fiber& fib, Interval& i, const IndexedMesh& m, unsigned int n) const {
+    Point p[3];
+    Point normal, xy_normal;
+    if ( !meshFacetPushData(m, n, p, normal, xy_normal) )
+        return false;
+    return generalFacetPush(this->normal_length,
+                            this->center_height,
+                            this->xy_normal_length,
+                            fib, i, p, normal, xy_normal);
+}
+
+bool MillingCutter::meshFacetPushData(const IndexedMesh& m, unsigned int n, Point* p, Point& normal, Point& xy_normal) {
+    const MeshFaceData& fd = m.faceData();
+    if ( fd.flags[n] & MeshFaceData::Z_NORMAL ) 
+        return false; //can't push against horizontal plane
+    for (int k=0; k<3; ++k)
+        p[k] = fd.corner(n,k);
+    normal = Point( fd.nx[n], fd.ny[n], fd.nz[n] );
+    xy_normal = Point( fd.xynx[n], fd.xyny[n], 0.0 );
+    return true;
+}
+
 bool MillingCutter::generalFacetPush(double normal_length,
                                      double center_height,
                                      double xy_normal_length,
@@ -159,15 +256,27 @@ bool MillingCutter::generalFacetPush(double normal_length,
                                      Interval& i,  
                                      const Triangle& t) 
                                      const {
-    bool result = false;
     Point normal = t.upNormal(); // facet surface normal, pointing up 
     if ( normal.zParallel() ) // normal points in z-dir   
-        return result; //can't push against horizontal plane, stop here.
+        return false; //can't push against horizontal plane, stop here.
     normal.normalize();
     Point xy_normal = normal;
     xy_normal.z = 0;
     xy_normal.xyNormalize();
-    
+    return generalFacetPush(normal_length, center_height, xy_normal_length, fib, i, t.p, normal, xy_normal);
+}
+
+// general purpose facetPush
+bool MillingCutter::generalFacetPush(double normal_length,
+                                     double center_height,
+                                     double xy_normal_length,
+                                     const Fiber& fib, 
+                                     Interval& i,  
+                                     const Point* p,
+                                     const Point& normal,
+                                     const Point& xy_normal) 
+                                     const {
+    bool result = false;
     //   find a point on the plane from which radius2*normal+radius1*xy_normal lands on the fiber+radius2*Point(0,0,1) 
     //   (u,v) locates a point on the triangle facet    v0+ u*(v1-v0)+v*(v2-v0)    u,v in [0,1]
     //   t locates a point along the fiber:             p1 + t*(p2-p1)             t in [0,1]
@@ -192,52 +301,52 @@ bool MillingCutter::generalFacetPush(double normal_length,
     
     double a;
     double b;
-    double c = t.p[1].z - t.p[0].z;
-    double d = t.p[2].z - t.p[0].z;
+    double c = p[1].z - p[0].z;
+    double d = p[2].z - p[0].z;
     double e;
-    double f = -t.p[0].z - normal_length*normal.z + fib.p1.z + center_height; 
+    double f = -p[0].z - normal_length*normal.z + fib.p1.z + center_height; 
     // note: the xy_normal does not have a z-component, so omitted here.
     
     double u, v; // u and v are coordinates of the cc-point within the triangle facet
     // a,b,e depend on the fiber:
     if ( fib.p1.y == fib.p2.y ) { // XFIBER
-        a = t.p[1].y - t.p[0].y;
-        b = t.p[2].y - t.p[0].y;
-        e = -t.p[0].y - normal_length*normal.y - xy_normal_length*xy_normal.y + fib.p1.y;
+        a = p[1].y - p[0].y;
+        b = p[2].y - p[0].y;
+        e = -p[0].y - normal_length*normal.y - xy_normal_length*xy_normal.y + fib.p1.y;
         if (!two_by_two_solver(a,b,c,d,e,f,u,v))
             return result;
-        CCPoint cc = t.p[0] + u*(t.p[1]-t.p[0]) + v*(t.p[2]-t.p[0]);
+        CCPoint cc = p[0] + u*(p[1]-p[0]) + v*(p[2]-p[0]);
         cc.type = FACET;
-        if ( ! cc.isInside( t ) ) 
+        if ( ! cc.isInside( p[0], p[1], p[2] ) ) 
             return result;
         // v0x + u*(v1x-v0x) + v*(v2x-v0x) + r2*nx + r1*xy_n.x = p1x + t*(p2x-p1x) 
         // =>
         // t = 1/(p2x-p1x) * ( v0x + r2*nx + r1*xy_n.x - p1x +  u*(v1x-v0x) + v*(v2x-v0x)       )
         assert( !isZero_tol( fib.p2.x - fib.p1.x )  ); // guard against division by zero
-        double tval = (1.0/( fib.p2.x - fib.p1.x )) * ( t.p[0].x + normal_length*normal.x + xy_normal_length*xy_normal.x - fib.p1.x 
-                                                        + u*(t.p[1].x-t.p[0].x)+v*(t.p[2].x-t.p[0].x) );
+        double tval = (1.0/( fib.p2.x - fib.p1.x )) * ( p[0].x + normal_length*normal.x + xy_normal_length*xy_normal.x - fib.p1.x 
+                                                        + u*(p[1].x-p[0].x)+v*(p[2].x-p[0].x) );
         if ( tval < 0.0 || tval > 1.0  ) {
             std::cout << "MillingCutter::facetPush() tval= " << tval << " error!?\n";
             //std::cout << " cutter: " << *this << "\n";
-            std::cout << " triangle: " << t << "\n";
+            std::cout << " triangle: " << p[0] << " " << p[1] << " " << p[2] << "\n";
             std::cout << " fiber: " << fib << "\n";
         } 
         assert( tval > 0.0 && tval < 1.0 );
         i.update( tval, cc );
         result = true;
     } else if (fib.p1.x == fib.p2.x) { // YFIBER
-        a = t.p[1].x - t.p[0].x;
-        b = t.p[2].x - t.p[0].x;
-        e = -t.p[0].x - normal_length*normal.x - xy_normal_length*xy_normal.x + fib.p1.x;
+        a = p[1].x - p[0].x;
+        b = p[2].x - p[0].x;
+        e = -p[0].x - normal_length*normal.x - xy_normal_length*xy_normal.x + fib.p1.x;
         if (!two_by_two_solver(a,b,c,d,e,f,u,v))
             return result;
-        CCPoint cc = t.p[0] + u*(t.p[1]-t.p[0]) + v*(t.p[2]-t.p[0]);
+        CCPoint cc = p[0] + u*(p[1]-p[0]) + v*(p[2]-p[0]);
         cc.type = FACET;
-        if ( ! cc.isInside( t ) ) 
+        if ( ! cc.isInside( p[0], p[1], p[2] ) ) 
             return result;
         assert( !isZero_tol( fib.p2.y - fib.p1.y )  );
-        double tval = (1.0/( fib.p2.y - fib.p1.y )) * ( t.p[0].y + normal_length*normal.y + xy_normal_length*xy_normal.y - fib.p1.y 
-                                                        + u*(t.p[1].y-t.p[0].y)+v*(t.p[2].y-t.p[0].y) );
+        double tval = (1.0/( fib.p2.y - fib.p1.y )) * ( p[0].y + normal_length*normal.y + xy_normal_length*xy_normal.y - fib.p1.y 
+                                                        + u*(p[1].y-p[0].y)+v*(p[2].y-p[0].y) );
         if ( tval < 0.0 || tval > 1.0  ) {
             std::cout << "MillingCutter::facetPush() tval= " << tval << " error!?\n";
             std::cout << " (most probably a user error, the fiber is too short compared to the STL model?)\n";
@@ -36,6 +36,7 @@ namespace ocl
 
 class Triangle;
 class STLSurf;
+class IndexedMesh;
 
 typedef std::pair< double, double > CC_CLZ_Pair;
 typedef std::pair< double, double > DoublePair;
@@ -45,6 +46,9 @@ typedef std::pair< double, double > DoublePair;
 ///
 class MillingCutter {
     friend class CompositeCutter;
+    friend class DropKernel;
+    friend class HeightMapDropCutter; // dilates by height()
+    template <class CutterT> friend class MeshDropEngine;
 
     public:
         /// default constructor
@@ -68,16 +72,31 @@ class MillingCutter {
         /// \brief drop cutter at (cl.x, cl.y) against the three vertices of Triangle t.
         /// calls this->height(r) on the subclass of MillingCutter we are using.
         bool vertexDrop(CLPoint &cl, const Triangle &t) const;
+        /// \brief drop cutter at (cl.x, cl.y) against the single vertex p.
+        /// Used by vertexDrop(), and by MeshQuery which tests each vertex of an IndexedMesh once.
+        bool singleVertexDrop(CLPoint &cl, const Point& p) const;
         /// \brief drop cutter at (cl.x, cl.y) against facet of Triangle t
         /// calls xy_normal_length(), normal_length(), and center_height() on the subclass
         virtual bool facetDrop(CLPoint &cl, const Triangle &t) const;
         /// \brief drop cutter at (cl.x, cl.y) against the three edges of input Triangle t.
         /// calls the sub-class MillingCutter::singleEdgeDrop on each edge
         virtual bool edgeDrop(CLPoint& cl, const Triangle &t) const;
+        /// \brief drop cutter at (cl.x, cl.y) against the single edge p1-p2.
+        /// Used by edgeDrop(), and by MeshQuery which tests each edge of an IndexedMesh once.
+        virtual bool singleEdgeDrop(CLPoint& cl, const Point& p1, const Point& p2) const;
         /// \brief drop the MillingCutter at Point cl down along the z-axis until it makes contact with Triangle t.
         /// This function calls vertexDrop, facetDrop, and edgeDrop to do its job.
         /// Follows the template-method, or "self-delegation" design pattern.
         bool dropCutter(CLPoint &cl, const Triangle &t) const;
+        
+        /// \brief drop cutter at (cl.x, cl.y) against face n of IndexedMesh m.
+        /// The same as facetDrop() with the Triangle of face n, but reads the
+        /// precomputed normal and plane of the face from m.faceData().
+        virtual bool meshFacetDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const;
+        /// \brief drop cutter at (cl.x, cl.y) against edge n of IndexedMesh m.
+        /// The same as singleEdgeDrop() with the end-points of edge n, but reads the
+        /// precomputed xy-direction and length of the edge from m.edgeData().
+        virtual bool meshEdgeDrop(CLPoint &cl, const IndexedMesh& m, unsigned int n) const;
 
         /// \brief call dropCutter on all Triangle's in STLSurf 
         /// drops the MillingCutter at Point cl down along the z-axis
@@ -93,6 +112,18 @@ class MillingCutter {
         /// Return true if contact was made with the Triangle
         bool pushCutter(const Fiber& f, Interval& i, const Triangle& t) const;
         
+        /// push cutter along Fiber f into contact with facet of Triangle t, and update Interval i
+        /// calls generalFacetPush()
+        virtual bool facetPush(const Fiber& f, Interval& i, const Triangle& t) const;
+        /// push cutter along Fiber f against the single vertex p, and update Interval i
+        virtual bool singleVertexPush(const Fiber& f, Interval& i, const Point& p) const;
+        /// push cutter along fiber against a single edge p1-p2
+        /// calls horizEdgePush(), shaftEdgePush(), and generalEdgePush()
+        virtual bool singleEdgePush(const Fiber& f, Interval& i,  const Point& p1, const Point& p2) const;
+        /// push cutter along Fiber f against face n of IndexedMesh m, and update Interval i.
+        /// The same as facetPush() with the Triangle of face n, but reads the precomputed normal from m.faceData().
+        virtual bool meshFacetPush(const Fiber& f, Interval& i, const IndexedMesh& m, unsigned int n) const;
+        
         /// return a string representation of the MillingCutter
         virtual std::string str() const {return "MillingCutter (all derived classes should override this)";}
         
@@ -107,10 +138,6 @@ class MillingCutter {
         /// push cutter against a single vertex p
         bool singleVertexPush(const Fiber& f, Interval& i, const Point& p, CCType cctyp) const;
         
-        /// push cutter along Fiber f into contact with facet of Triangle t, and update Interval i
-        /// calls generalFacetPush()
-        virtual bool facetPush(const Fiber& f, Interval& i, const Triangle& t) const;
-        
         /// push cutter with given normal/center/xy_length into contact with Triangle facet
         bool generalFacetPush(       double normal_length,
                                      double center_height,
@@ -119,16 +146,26 @@ class MillingCutter {
                                      Interval& i,  
                                      const Triangle& t) 
                                      const;
+        /// push cutter with given normal/center/xy_length into contact with the facet with corners p[0], p[1], p[2],
+        /// unit up-normal normal, and xy-normalized xy_normal
+        bool generalFacetPush(       double normal_length,
+                                     double center_height,
+                                     double xy_normal_length,
+                                     const Fiber& fib, 
+                                     Interval& i,  
+                                     const Point* p,
+                                     const Point& normal,
+                                     const Point& xy_normal) 
+                                     const;
+        /// read the corners, unit up-normal and xy_normal of face n of m for generalFacetPush().
+        /// returns false if the face is horizontal and can't be pushed against.
+        static bool meshFacetPushData(const IndexedMesh& m, unsigned int n, Point* p, Point& normal, Point& xy_normal);
 
         /// push cutter along Fiber f into contact with edges of Triangle t, update Interval i.
         /// calls singleEdgePush() on all three edges of Triangle t.
         /// return true if a contact with an edge was found
         virtual bool edgePush(const Fiber& f, Interval& i, const Triangle& t) const;
 
-        /// push cutter along fiber against a single edge p1-p2
-        /// calls horizEdgePush(), shaftEdgePush(), and generalEdgePush()
-        bool singleEdgePush(const Fiber& f, Interval& i,  const Point& p1, const Point& p2) const;
-        
         /// push-cutter horizontal edge case
         /// horizontal are much simpler than the general case.
         /// we can consider the cutter circular with an effective radius of this->width(h)
@@ -147,6 +184,16 @@ class MillingCutter {
             return false;
         }
         
+        /// first part of meshEdgeDrop(): the end-points of edge n of m in the canonical position 
+        /// of singleEdgeDropCanonical(), and the distance s along the edge from v[0] to the point closest to cl.
+        /// returns false if the edge is vertical or further than radius from cl.
+        bool meshEdgeCanonical(const CLPoint& cl, const IndexedMesh& m, unsigned int n, 
+                               Point& up1, Point& up2, double& s) const;
+        /// last part of meshEdgeDrop(): lift cl to the contact found by singleEdgeDropCanonical(), if the
+        /// cc-point is within edge n of m
+        static bool meshEdgeLift(CLPoint& cl, const IndexedMesh& m, unsigned int n, double s, 
+                                 const CC_CLZ_Pair& contact);
+        
         /// CCPoint calculation and interval update
         bool calcCCandUpdateInterval( double t, double ccv, const Point& q, const Point& p1, const Point& p2, 
                                       const Fiber& f, Interval& i, double height, CCType cctyp) const;
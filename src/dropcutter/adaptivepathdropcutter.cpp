@@ -18,11 +18,13 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 
 #include "millingcutter.hpp"
 #include "clpoint.hpp"
-#include "pointdropcutter.hpp"
+#include "batchdropcutter.hpp"
 #include "adaptivepathdropcutter.hpp"
 
 namespace ocl
@@ -36,7 +38,7 @@ AdaptivePathDropCutter::AdaptivePathDropCutter() {
     path = NULL;
     minimumZ = 0.0;
     subOp.clear();
-    subOp.push_back( new PointDropCutter() ); // we delegate to PointDropCutter, who does the heavy lifting
+    subOp.push_back( new BatchDropCutter() ); // we delegate to BatchDropCutter, who does the heavy lifting
     sampling = 0.1;
     min_sampling = 0.01;
     cosLimit = 0.999;
@@ -53,33 +55,67 @@ void AdaptivePathDropCutter::run() {
 
 void AdaptivePathDropCutter::adaptive_sampling_run() {
     std::cout << " apdc::adaptive_sampling_run()... ";
-    
     clpoints.clear();
-    BOOST_FOREACH( const Span* span, path->span_list ) {  // this loop could run in parallel, since spans don't depend on eachother
-        CLPoint start = span->getPoint(0.0);
-        CLPoint stop = span->getPoint(1.0);
-        subOp[0]->run(start);
-        subOp[0]->run(stop);
-        clpoints.push_back(start);
-        adaptive_sample( span, 0.0, 1.0, start, stop);
+    nCalls = 0;
+    nPruned = 0;
+    // spans don't depend on eachother, so the end-points of all spans are dropped together
+    std::vector<const Span*> spans( path->span_list.begin(), path->span_list.end() );
+    std::vector<CLPoint> ends;
+    BOOST_FOREACH( const Span* span, spans ) {
+        ends.push_back( span->getPoint(0.0) );
+        ends.push_back( span->getPoint(1.0) );
+    }
+    drop( ends );
+    std::vector<SpanInterval> pending; // intervals of the current level
+    std::vector<SpanInterval> done;    // intervals which are not subdivided further
+    for (unsigned int n=0; n<spans.size(); ++n) {
+        done.push_back( SpanInterval(n, 0.0, 0.0, ends[2*n], ends[2*n]) ); // the start-point of the span
+        pending.push_back( SpanInterval(n, 0.0, 1.0, ends[2*n], ends[2*n+1]) );
+    }
+    // breadth-first subdivision, one batch of mid-points per level
+    while ( !pending.empty() ) {
+        std::vector<CLPoint> mids;
+        BOOST_FOREACH( const SpanInterval& i, pending ) {
+            assert( i.mid_t() > i.start_t );  assert( i.mid_t() < i.stop_t );
+            mids.push_back( spans[i.span]->getPoint( i.mid_t() ) );
+        }
+        drop( mids );
+        std::vector<SpanInterval> next;
+        for (unsigned int n=0; n<pending.size(); ++n) {
+            SpanInterval& i = pending[n];
+            if ( subdivide( i.start_cl, mids[n], i.stop_cl ) ) {
+                next.push_back( SpanInterval(i.span, i.start_t, i.mid_t(), i.start_cl, mids[n]) );
+                next.push_back( SpanInterval(i.span, i.mid_t(), i.stop_t, mids[n], i.stop_cl) );
+            } else {
+                done.push_back( i );
+            }
+        }
+        pending.swap( next );
+    }
+    std::sort( done.begin(), done.end() ); // path order
+    BOOST_FOREACH( const SpanInterval& i, done ) {
+        clpoints.push_back( i.stop_cl );
     }
     std::cout << " DONE clpoints.size()=" << clpoints.size() << "\n";
 }
 
-void AdaptivePathDropCutter::adaptive_sample(const Span* span, double start_t, double stop_t, CLPoint start_cl, CLPoint stop_cl) {
-    const double mid_t = start_t + (stop_t-start_t)/2.0; // mid point sample
-    assert( mid_t > start_t );  assert( mid_t < stop_t );
-    CLPoint mid_cl = span->getPoint(mid_t);
-    //std::cout << " apdc sampling at " << mid_t << "\n";
-    subOp[0]->run( mid_cl );
-    double fw_step = (stop_cl-start_cl).xyNorm();
-    if ( (fw_step > sampling) || // above minimum step-forward, need to sample more
-          ( (!flat(start_cl,mid_cl,stop_cl)) && (fw_step > min_sampling) ) ) { // OR not flat, and not max sampling
-        adaptive_sample( span, start_t, mid_t , start_cl, mid_cl  );
-        adaptive_sample( span, mid_t  , stop_t, mid_cl  , stop_cl );
-    } else {
-        clpoints.push_back(stop_cl); 
+void AdaptivePathDropCutter::drop(std::vector<CLPoint>& pts) {
+    if ( pts.empty() )
+        return;
+    subOp[0]->clearCLPoints();
+    BOOST_FOREACH( CLPoint& p, pts ) {
+        subOp[0]->appendPoint( p );
     }
+    subOp[0]->run();
+    pts = subOp[0]->getCLPoints();
+    nCalls += subOp[0]->getCalls();
+    nPruned += subOp[0]->getPruned();
+}
+
+bool AdaptivePathDropCutter::subdivide(CLPoint& start_cl, CLPoint& mid_cl, CLPoint& stop_cl) {
+    double fw_step = (stop_cl-start_cl).xyNorm();
+    return ( (fw_step > sampling) || // above minimum step-forward, need to sample more
+             ( (!flat(start_cl,mid_cl,stop_cl)) && (fw_step > min_sampling) ) ); // OR not flat, and not max sampling
 }
 
 bool AdaptivePathDropCutter::flat(CLPoint& start_cl, CLPoint& mid_cl, CLPoint& stop_cl)  {
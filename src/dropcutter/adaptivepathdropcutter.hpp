@@ -24,11 +24,11 @@
 #include <iostream>
 #include <string>
 #include <list>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
 #include "pathdropcutter.hpp"
-#include "pointdropcutter.hpp"
 #include "path.hpp"
 #include "clpoint.hpp"
 
@@ -42,6 +42,13 @@ class Triangle;
 
 ///
 /// \brief path drop cutter finish Path generation
+///
+/// Each Span of the Path is sampled at its end-points, and then subdivided at
+/// the mid-point of an interval until the interval is shorter than the sampling, 
+/// and either flat() or shorter than the minimum sampling.
+/// The subdivision is breadth-first: all intervals of one level, on all spans, 
+/// are dropped as one batch by a BatchDropCutter, which runs in parallel.
+/// The CL-points are returned in path order, independent of the number of threads.
 class AdaptivePathDropCutter : public Operation {
     public:
         /// construct an empty PathDropCutter object
@@ -70,10 +77,34 @@ class AdaptivePathDropCutter : public Operation {
             subOp[0]->clearCLPoints();
         }
     protected:
-        /// run adaptive sample on the given Span between t-values of start_t and stop_t
-        void adaptive_sample(const Span* span, double start_t, double stop_t, CLPoint start_cl, CLPoint stop_cl);
+        /// an interval [start_t, stop_t] of a Span, with the CL-points at its ends
+        class SpanInterval {
+            public:
+                SpanInterval(unsigned int s, double t0, double t1, const CLPoint& cl0, const CLPoint& cl1) 
+                    : span(s), start_t(t0), stop_t(t1), start_cl(cl0), stop_cl(cl1) {}
+                /// the t-value of the mid-point
+                double mid_t() const {return start_t + (stop_t-start_t)/2.0;}
+                /// path order of the stop-points
+                bool operator<(const SpanInterval& o) const {
+                    return (span < o.span) || ( (span == o.span) && (stop_t < o.stop_t) );
+                }
+                /// index of the Span
+                unsigned int span;
+                /// t-value at the start
+                double start_t;
+                /// t-value at the stop
+                double stop_t;
+                /// CL-point at start_t
+                CLPoint start_cl;
+                /// CL-point at stop_t
+                CLPoint stop_cl;
+        };
+        /// true if the interval from start_cl through mid_cl to stop_cl must be subdivided further
+        bool subdivide(CLPoint& start_cl, CLPoint& mid_cl, CLPoint& stop_cl);
         /// flatness predicate for adaptive sampling
         bool flat(CLPoint& start_cl, CLPoint& mid_cl, CLPoint& stop_cl);
+        /// run drop-cutter on pts as one batch, with the BatchDropCutter sub-operation
+        void drop(std::vector<CLPoint>& pts);
         /// run adaptive sampling
         void adaptive_sampling_run();
     // DATA
@@ -18,6 +18,9 @@
  *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <utility>
+
 #include <boost/foreach.hpp>
 #include <boost/progress.hpp>
 
@@ -28,6 +31,13 @@
 #include "point.hpp"
 #include "triangle.hpp"
 #include "batchdropcutter.hpp"
+#include "meshquery.hpp"
+#include "dropkernel.hpp"
+#include "meshdropengine.hpp"
+#include "cylcutter.hpp"
+#include "ballcutter.hpp"
+#include "bullcutter.hpp"
+#include "conecutter.hpp"
 
 namespace ocl
 {
@@ -42,22 +52,21 @@ BatchDropCutter::BatchDropCutter() {
 #endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
+    morton = false;
+    packetSize = 0;
+    warm = false;
 }
 
 BatchDropCutter::~BatchDropCutter() { 
     clpoints->clear();
     delete clpoints;
-    delete root;
 }
  
-void BatchDropCutter::setSTL(const STLSurf &s) {
-    std::cout << "bdc::setSTL()\n";
-    surf = &s;
-    root->setXYDimensions(); // we search for triangles in the XY plane, don't care about Z-coordinate
-    root->setBucketSize( bucketSize );
-    root->build(s.tris);
-    std::cout << "bdc::setSTL() done.\n";
+void BatchDropCutter::setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx) {
+    std::cout << "bdc::setSurfaceIndex()\n";
+    Operation::setSurfaceIndex(idx);
+    root = index->xyTree(); // we search for triangles in the XY plane, don't care about Z-coordinate
+    std::cout << "bdc::setSurfaceIndex() done.\n";
 }
 
 
@@ -66,6 +75,10 @@ void BatchDropCutter::appendPoint(CLPoint& p) {
     clpoints->push_back(p);
 }
 
+void BatchDropCutter::setPacketSize(unsigned int p) {
+    packetSize = std::min( p, KDTree<Triangle>::maxPacket );
+}
+
 // drop cutter against all triangles in surface
 void BatchDropCutter::dropCutter1() {
     std::cout << "dropCutterSTL1 " << clpoints->size() << 
@@ -88,14 +101,13 @@ void BatchDropCutter::dropCutter2() {
             " cl-points and " << surf->tris.size() << " triangles.\n";
     std::cout.flush();
     nCalls = 0;
-    std::list<Triangle> *triangles_under_cutter;
+    std::vector<unsigned int> tri_idx; // re-used between CL-points
     BOOST_FOREACH(CLPoint &cl, *clpoints) { //loop through each CL-point
-        triangles_under_cutter = root->search_cutter_overlap( cutter , &cl);
-        BOOST_FOREACH( const Triangle& t, *triangles_under_cutter) {
-            cutter->dropCutter(cl,t);
+        root->search_cutter_overlap( cutter , &cl, tri_idx);
+        BOOST_FOREACH( unsigned int n, tri_idx) {
+            cutter->dropCutter(cl, root->get(n) );
             ++nCalls;
         }
-        delete triangles_under_cutter;
     }
     
     std::cout << "done. " << nCalls << " dropCutter() calls.\n";
@@ -109,10 +121,11 @@ void BatchDropCutter::dropCutter3() {
             " cl-points and " << surf->tris.size() << " triangles.\n";
     nCalls = 0;
     boost::progress_display show_progress( clpoints->size() );
-    std::list<Triangle> *triangles_under_cutter;
+    std::vector<unsigned int> tri_idx; // re-used between CL-points
     BOOST_FOREACH(CLPoint &cl, *clpoints) { //loop through each CL-point
-        triangles_under_cutter = root->search_cutter_overlap( cutter , &cl);
-        BOOST_FOREACH( const Triangle& t, *triangles_under_cutter) {
+        root->search_cutter_overlap( cutter , &cl, tri_idx);
+        BOOST_FOREACH( unsigned int n, tri_idx) {
+            const Triangle& t = root->get(n);
             if (cutter->overlaps(cl,t)) {
                 if ( cl.below(t) ) {
                     cutter->dropCutter(cl,t);
@@ -121,7 +134,6 @@ void BatchDropCutter::dropCutter3() {
             }
         }
         ++show_progress;
-        delete triangles_under_cutter;
     }
     
     std::cout << "done. " << nCalls << " dropCutter() calls.\n";
@@ -136,7 +148,6 @@ void BatchDropCutter::dropCutter4() {
     nCalls = 0;
     int calls=0;
     long int ntris = 0;
-    std::list<Triangle>* tris;
     unsigned int n;
     unsigned int Nmax = clpoints->size();
     std::vector<CLPoint>& clref = *clpoints; 
@@ -146,8 +157,10 @@ void BatchDropCutter::dropCutter4() {
     omp_set_num_threads(nthreads); // the constructor sets number of threads right
                                    // or the user can explicitly specify something else
 #endif
-    std::list<Triangle>::iterator it;
-    #pragma omp parallel for shared( nloop, ntris, calls, clref) private(n,tris,it)
+    #pragma omp parallel shared( nloop, ntris, calls, clref) private(n)
+    {
+    std::vector<unsigned int> tri_idx; // per-thread buffer, re-used between CL-points
+    #pragma omp for
         for (n=0;n< Nmax ;n++) { // PARALLEL OpenMP loop!
 #ifdef _OPENMP
             if ( n== 0 ) { // first iteration
@@ -156,32 +169,35 @@ void BatchDropCutter::dropCutter4() {
             }
 #endif
             nloop++;
-            tris = root->search_cutter_overlap( cutter, &clref[n] );
-            assert( tris->size() <= ntriangles ); // can't possibly find more triangles than in the STLSurf 
-            for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-                if ( cutter->overlaps(clref[n],*it) ) { // cutter overlap triangle? check
-                    if (clref[n].below(*it)) {
-                        cutter->vertexDrop( clref[n],*it);
+            root->search_cutter_overlap( cutter, &clref[n], tri_idx );
+            assert( tri_idx.size() <= ntriangles ); // can't possibly find more triangles than in the STLSurf 
+            BOOST_FOREACH( unsigned int m, tri_idx ) { // loop over found triangles  
+                const Triangle& t = root->get(m);
+                if ( cutter->overlaps(clref[n],t) ) { // cutter overlap triangle? check
+                    if (clref[n].below(t)) {
+                        cutter->vertexDrop( clref[n],t);
                         ++calls;
                     }
                 }
             }
-            for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-                if ( cutter->overlaps(clref[n],*it) ) { // cutter overlap triangle? check
-                    if (clref[n].below(*it))
-                        cutter->facetDrop( clref[n],*it);
+            BOOST_FOREACH( unsigned int m, tri_idx ) { // loop over found triangles  
+                const Triangle& t = root->get(m);
+                if ( cutter->overlaps(clref[n],t) ) { // cutter overlap triangle? check
+                    if (clref[n].below(t))
+                        cutter->facetDrop( clref[n],t);
                 }
             }
-            for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-                if ( cutter->overlaps(clref[n],*it) ) { // cutter overlap triangle? check
-                    if (clref[n].below(*it))
-                        cutter->edgeDrop( clref[n],*it);
+            BOOST_FOREACH( unsigned int m, tri_idx ) { // loop over found triangles  
+                const Triangle& t = root->get(m);
+                if ( cutter->overlaps(clref[n],t) ) { // cutter overlap triangle? check
+                    if (clref[n].below(t))
+                        cutter->edgeDrop( clref[n],t);
                 }
             }
-            ntris += tris->size();
-            delete( tris );
+            ntris += tri_idx.size();
             ++show_progress;
         } // end OpenMP PARALLEL for
+    } // end OpenMP PARALLEL region
     nCalls = calls;
     std::cout << " " << nCalls << " dropCutter() calls.\n";
     return;
@@ -195,7 +211,6 @@ void BatchDropCutter::dropCutter5() {
     nCalls = 0;
     int calls=0;
     long int ntris = 0;
-    std::list<Triangle>* tris;
     unsigned int n;
     unsigned int Nmax = clpoints->size();
     std::vector<CLPoint>& clref = *clpoints; 
@@ -205,8 +220,10 @@ void BatchDropCutter::dropCutter5() {
     omp_set_num_threads(nthreads); // the constructor sets number of threads right
                                    // or the user can explicitly specify something else
 #endif
-    std::list<Triangle>::iterator it;
-    #pragma omp parallel for schedule(dynamic) shared( nloop, ntris, calls, clref ) private(n,tris,it) 
+    #pragma omp parallel shared( nloop, ntris, calls, clref ) private(n)
+    {
+    std::vector<unsigned int> tri_idx; // per-thread buffer, re-used between CL-points
+    #pragma omp for schedule(dynamic)
         for (n=0;n<Nmax;++n) { // PARALLEL OpenMP loop!
 #ifdef _OPENMP
             if ( n== 0 ) { // first iteration
@@ -215,19 +232,52 @@ void BatchDropCutter::dropCutter5() {
             }
 #endif
             nloop++;
-            tris = root->search_cutter_overlap( cutter, &clref[n] );
-            assert( tris );
-            assert( tris->size() <= ntriangles ); // can't possibly find more triangles than in the STLSurf 
-            for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-                if ( cutter->overlaps(clref[n],*it) ) { // cutter overlap triangle? check
-                    if (clref[n].below(*it)) {
-                        cutter->dropCutter( clref[n],*it);
+            root->search_cutter_overlap( cutter, &clref[n], tri_idx );
+            assert( tri_idx.size() <= ntriangles ); // can't possibly find more triangles than in the STLSurf 
+            BOOST_FOREACH( unsigned int m, tri_idx ) { // loop over found triangles  
+                const Triangle& t = root->get(m);
+                if ( cutter->overlaps(clref[n],t) ) { // cutter overlap triangle? check
+                    if (clref[n].below(t)) {
+                        cutter->dropCutter( clref[n],t);
                         ++calls;
                     }
                 }
             }
-            ntris += tris->size();
-            delete( tris );
+            ntris += tri_idx.size();
+            ++show_progress;
+        } // end OpenMP PARALLEL for
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    std::cout << "\n " << nCalls << " dropCutter() calls.\n";
+    return;
+}
+
+// as dropCutter5, but the kd-tree visits the highest triangles first 
+// and skips the parts of the tree that are below the current cl.z
+void BatchDropCutter::dropCutter6() {
+    std::cout << "dropCutterSTL6 " << clpoints->size() << 
+            " cl-points and " << surf->tris.size() << " triangles.\n";
+    boost::progress_display show_progress( clpoints->size() );
+    nCalls = 0;
+    int calls=0;
+    unsigned int n;
+    unsigned int Nmax = clpoints->size();
+    std::vector<CLPoint>& clref = *clpoints; 
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads); // the constructor sets number of threads right
+                                   // or the user can explicitly specify something else
+#endif
+    #pragma omp parallel for schedule(dynamic) shared( clref ) private(n) reduction(+:calls)
+        for (n=0;n<Nmax;++n) { // PARALLEL OpenMP loop!
+#ifdef _OPENMP
+            if ( n== 0 ) { // first iteration
+                if (omp_get_thread_num() == 0 ) 
+                    std::cout << "Number of OpenMP threads = "<< omp_get_num_threads() << "\n";
+            }
+#endif
+            CutterDropVisitor<Triangle> drop( root, cutter, clref[n] );
+            root->visit_cutter_drop( cutter, &clref[n], drop );
+            calls += drop.calls;
             ++show_progress;
         } // end OpenMP PARALLEL for
     nCalls = calls;
@@ -235,5 +285,249 @@ void BatchDropCutter::dropCutter5() {
     return;
 }
 
+// as dropCutter6, but each vertex and edge shared by the found triangles 
+// is tested only once, using the IndexedMesh of the SurfaceIndex
+void BatchDropCutter::dropCutter7() {
+    std::cout << "dropCutterSTL7 " << clpoints->size() << 
+            " cl-points and " << surf->tris.size() << " triangles.\n";
+    const IndexedMesh* mesh = index->mesh();
+    boost::progress_display show_progress( clpoints->size() );
+    nCalls = 0;
+    nPruned = 0;
+    int calls=0, pruned=0;
+    unsigned int n;
+    unsigned int Nmax = clpoints->size();
+    std::vector<CLPoint>& clref = *clpoints; 
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads); // the constructor sets number of threads right
+                                   // or the user can explicitly specify something else
+#endif
+    #pragma omp parallel shared( clref ) private(n) reduction(+:calls,pruned)
+    {
+    MeshQuery query( mesh ); // per-thread vertex and edge stamps
+    #pragma omp for schedule(dynamic)
+        for (n=0;n<Nmax;++n) { // PARALLEL OpenMP loop!
+#ifdef _OPENMP
+            if ( n== 0 ) { // first iteration
+                if (omp_get_thread_num() == 0 ) 
+                    std::cout << "Number of OpenMP threads = "<< omp_get_num_threads() << "\n";
+            }
+#endif
+            calls += query.dropCutter( root, cutter, clref[n] );
+            ++show_progress;
+        } // end OpenMP PARALLEL for
+    pruned += query.getPruned();
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    nPruned = pruned;
+    std::cout << "\n " << nCalls << " dropCutter() calls, " << nPruned << " triangles outside the cutter footprint.\n";
+    return;
+}
+
+// as dropCutter7, but the facets and vertices of the found triangles are dropped
+// against in batches with a DropKernel, using AVX2 when the CPU supports it.
+// cutters without a DropKernel use the dropCutter7 query.
+void BatchDropCutter::dropCutter8() {
+    const IndexedMesh* mesh = index->mesh();
+    const DropKernel kernel( cutter );
+    std::cout << "dropCutterSTL8 " << clpoints->size() << 
+            " cl-points and " << surf->tris.size() << " triangles";
+    if ( kernel.usesSIMD() )
+        std::cout << " (AVX2)";
+    std::cout << ".\n";
+    boost::progress_display show_progress( clpoints->size() );
+    nCalls = 0;
+    nPruned = 0;
+    int calls=0, pruned=0;
+    unsigned int n;
+    unsigned int Nmax = clpoints->size();
+    std::vector<CLPoint>& clref = *clpoints; 
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads); // the constructor sets number of threads right
+                                   // or the user can explicitly specify something else
+#endif
+    #pragma omp parallel shared( clref ) private(n) reduction(+:calls,pruned)
+    {
+    MeshQuery query( mesh ); // per-thread vertex and edge stamps
+    #pragma omp for schedule(dynamic)
+        for (n=0;n<Nmax;++n) { // PARALLEL OpenMP loop!
+#ifdef _OPENMP
+            if ( n== 0 ) { // first iteration
+                if (omp_get_thread_num() == 0 ) 
+                    std::cout << "Number of OpenMP threads = "<< omp_get_num_threads() << "\n";
+            }
+#endif
+            if ( kernel.supported() )
+                calls += query.dropCutter( root, kernel, clref[n] );
+            else
+                calls += query.dropCutter( root, cutter, clref[n] );
+            ++show_progress;
+        } // end OpenMP PARALLEL for
+    pruned += query.getPruned();
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    nPruned = pruned;
+    std::cout << "\n " << nCalls << " dropCutter() calls, " << nPruned << " triangles outside the cutter footprint.\n";
+    return;
+}
+
+// as dropCutter8, but the cutter type is found once here, and the query is made with the
+// MeshDropEngine of that type, which calls meshFacetDrop(), height(), and singleEdgeDropCanonical()
+// of the cutter without virtual calls. other cutters use the virtual calls of dropCutter8.
+void BatchDropCutter::dropCutter9() {
+    if ( const CylCutter* c = dynamic_cast<const CylCutter*>(cutter) )
+        dropCutterEngine( MeshDropEngine<CylCutter>(c) );
+    else if ( const BallCutter* c = dynamic_cast<const BallCutter*>(cutter) )
+        dropCutterEngine( MeshDropEngine<BallCutter>(c) );
+    else if ( const BullCutter* c = dynamic_cast<const BullCutter*>(cutter) )
+        dropCutterEngine( MeshDropEngine<BullCutter>(c) );
+    else if ( const ConeCutter* c = dynamic_cast<const ConeCutter*>(cutter) )
+        dropCutterEngine( MeshDropEngine<ConeCutter>(c) );
+    else
+        dropCutterEngine( MeshDropEngine<MillingCutter>(cutter) );
+}
+
+/// spread the low 16 bits of x to the even bits of the result
+static unsigned int spreadBits(unsigned int x) {
+    x &= 0x0000FFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+// the XY bounding-box of the CL-points is divided into a 65536x65536 grid, and the
+// Morton code of a CL-point interleaves the bits of its grid x and y.
+// CL-points close along the curve are close in XY, so they overlap the same kd-tree nodes and triangles.
+void BatchDropCutter::mortonOrder(std::vector<unsigned int>& order) const {
+    const unsigned int N = clpoints->size();
+    order.resize(N);
+    if ( N == 0 )
+        return;
+    double minx = (*clpoints)[0].x, maxx = minx;
+    double miny = (*clpoints)[0].y, maxy = miny;
+    BOOST_FOREACH( const CLPoint& cl, *clpoints ) {
+        minx = std::min( minx, cl.x );
+        maxx = std::max( maxx, cl.x );
+        miny = std::min( miny, cl.y );
+        maxy = std::max( maxy, cl.y );
+    }
+    const double sx = (maxx > minx) ? 65535.0 / (maxx - minx) : 0.0;
+    const double sy = (maxy > miny) ? 65535.0 / (maxy - miny) : 0.0;
+    std::vector< std::pair<unsigned int, unsigned int> > keys(N); // (Morton code, index)
+    for (unsigned int n=0; n<N; ++n) {
+        const CLPoint& cl = (*clpoints)[n];
+        const unsigned int gx = (unsigned int)( (cl.x - minx)*sx );
+        const unsigned int gy = (unsigned int)( (cl.y - miny)*sy );
+        keys[n] = std::make_pair( spreadBits(gx) | (spreadBits(gy) << 1), n );
+    }
+    std::sort( keys.begin(), keys.end() );
+    for (unsigned int n=0; n<N; ++n)
+        order[n] = keys[n].second;
+}
+
+template <class CutterT>
+void BatchDropCutter::dropCutterEngine(const MeshDropEngine<CutterT>& engine) {
+    const IndexedMesh* mesh = index->mesh();
+    const DropKernel kernel( cutter );
+    std::cout << "dropCutterSTL9 " << clpoints->size() << 
+            " cl-points and " << surf->tris.size() << " triangles";
+    if ( kernel.usesSIMD() )
+        std::cout << " (AVX2)";
+    if ( packetSize > 1 )
+        std::cout << " in packets of " << packetSize;
+    else if ( warm )
+        std::cout << " with warm start";
+    std::cout << ".\n";
+    if ( packetSize > 1 ) {
+        dropCutterPackets( engine, kernel );
+        return;
+    }
+    boost::progress_display show_progress( clpoints->size() );
+    nCalls = 0;
+    nPruned = 0;
+    int calls=0, pruned=0;
+    unsigned int n;
+    unsigned int Nmax = clpoints->size();
+    std::vector<CLPoint>& clref = *clpoints; 
+    // with morton, the threads take tiles of 64 CL-points along the Morton curve.
+    // each CL-point is written in place, so the results stay in the appended order.
+    std::vector<unsigned int> order;
+    if ( morton ) 
+        mortonOrder( order );
+    const int tile = morton ? 64 : 1;
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads); // the constructor sets number of threads right
+                                   // or the user can explicitly specify something else
+#endif
+    #pragma omp parallel shared( clref ) private(n) reduction(+:calls,pruned)
+    {
+    MeshQuery query( mesh ); // per-thread vertex and edge stamps
+    query.setWarmStart( warm ); // and previous contact
+    #pragma omp for schedule(dynamic, tile)
+        for (n=0;n<Nmax;++n) { // PARALLEL OpenMP loop!
+#ifdef _OPENMP
+            if ( n== 0 ) { // first iteration
+                if (omp_get_thread_num() == 0 ) 
+                    std::cout << "Number of OpenMP threads = "<< omp_get_num_threads() << "\n";
+            }
+#endif
+            CLPoint& cl = clref[ morton ? order[n] : n ];
+            if ( kernel.supported() )
+                calls += query.dropCutter( root, kernel, engine, cl );
+            else
+                calls += query.dropCutter( root, engine, cl );
+            ++show_progress;
+        } // end OpenMP PARALLEL for
+    pruned += query.getPruned();
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    nPruned = pruned;
+    std::cout << "\n " << nCalls << " dropCutter() calls, " << nPruned << " triangles outside the cutter footprint.\n";
+    return;
+}
+
+// as the loop of dropCutterEngine(), over packets of packetSize consecutive CL-points
+template <class CutterT>
+void BatchDropCutter::dropCutterPackets(const MeshDropEngine<CutterT>& engine, const DropKernel& kernel) {
+    const IndexedMesh* mesh = index->mesh();
+    nCalls = 0;
+    nPruned = 0;
+    int calls=0, pruned=0;
+    unsigned int Nmax = clpoints->size();
+    std::vector<CLPoint>& clref = *clpoints; 
+    std::vector<unsigned int> order;
+    if ( morton ) 
+        mortonOrder( order );
+    const int npackets = (Nmax + packetSize - 1) / packetSize;
+    boost::progress_display show_progress( npackets );
+    int p;
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    #pragma omp parallel shared( clref ) private(p) reduction(+:calls,pruned)
+    {
+    MeshQuery query( mesh );
+    CLPoint* cls[ KDTree<Triangle>::maxPacket ];
+    #pragma omp for schedule(dynamic)
+        for (p=0;p<npackets;++p) { // PARALLEL OpenMP loop!
+            const unsigned int first = p*packetSize;
+            const unsigned int n = std::min( packetSize, Nmax-first );
+            for (unsigned int k=0; k<n; ++k)
+                cls[k] = &clref[ morton ? order[first+k] : first+k ];
+            if ( kernel.supported() )
+                calls += query.dropCutter( root, kernel, engine, cls, n );
+            else
+                calls += query.dropCutter( root, engine, cls, n );
+            ++show_progress;
+        } // end OpenMP PARALLEL for
+    pruned += query.getPruned();
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    nPruned = pruned;
+    std::cout << "\n " << nCalls << " dropCutter() calls, " << nPruned << " triangles outside the cutter footprint.\n";
+}
+
 }// end namespace
 // end file batchdropcutter.cpp
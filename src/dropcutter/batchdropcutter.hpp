@@ -35,7 +35,8 @@ namespace ocl
 
 class STLSurf;
 class Triangle;
-
+template <class CutterT> class MeshDropEngine;
+class DropKernel;
 
 ///
 /// BatchDropCutter takes a MillingCutter, an STLSurf, and a list of CLPoint's
@@ -48,17 +49,29 @@ class BatchDropCutter : public Operation {
     public:
         BatchDropCutter();
         virtual ~BatchDropCutter();
-        /// set the STL-surface and build kd-tree to enable optimized algorithm
-        void setSTL(const STLSurf &s);
+        /// use the XY kd-tree of idx to enable optimized algorithm
+        void setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx);
         /// append to list of CL-points to evaluate
         void appendPoint(CLPoint& p);
         /// run drop-cutter on all clpoints
-        void run() {this->dropCutter5();};
+        void run() {this->dropCutter9();};
     // getters and setters
         /// return a vector of CLPoints, the result of this operation
         std::vector<CLPoint> getCLPoints() {return *clpoints;}
 		/// clears the vector of CLPoints
 		void clearCLPoints() {clpoints->clear();}
+        /// if true, run() hands the CL-points to the threads in tiles along a Z-order (Morton) 
+        /// curve in XY, rather than in the order they were appended. Default false.
+        void setMortonOrder(bool m) {morton = m;}
+        /// with a packet-size p > 1, run() drops the cutter at packets of p consecutive CL-points 
+        /// (in Morton order, if setMortonOrder(true)) with one kd-tree traversal per packet, 
+        /// see KDTree::visit_packet_drop(). p is at most KDTree::maxPacket (64). 
+        /// The default 0 drops at one CL-point at a time.
+        void setPacketSize(unsigned int p);
+        /// if true, the drop at each CL-point starts by testing the triangles at the contact of the 
+        /// previous CL-point of the same thread, see MeshQuery::setWarmStart(). This pays off when 
+        /// consecutive CL-points are close together, as along a path. Not used with packets. Default false.
+        void setWarmStart(bool w) {warm = w;}
         
     protected:
         /// unoptimized drop-cutter,  tests against all triangles of surface
@@ -71,9 +84,32 @@ class BatchDropCutter : public Operation {
         void dropCutter4();
         /// version 5 of the algorithm
         void dropCutter5();
+        /// kd-tree branch-and-bound on triangle max-z, with OpenMP
+        void dropCutter6();
+        /// as dropCutter6, but tests each vertex and edge of the IndexedMesh only once per CL-point
+        void dropCutter7();
+        /// as dropCutter7, with batched (SIMD) facet- and vertex-drops for Cyl, Ball, and Bull cutters
+        void dropCutter8();
+        /// as dropCutter8, with the drops resolved at compile time for Cyl, Ball, Bull, and Cone cutters,
+        /// and the CL-points in Morton order if setMortonOrder(true), in packets if setPacketSize()
+        void dropCutter9();
+        /// the parallel loop of dropCutter9, with the MeshDropEngine e of the cutter type
+        template <class CutterT>
+        void dropCutterEngine(const MeshDropEngine<CutterT>& e);
+        /// the packet loop of dropCutterEngine()
+        template <class CutterT>
+        void dropCutterPackets(const MeshDropEngine<CutterT>& e, const DropKernel& k);
+        /// sort the indices of the CL-points along a Z-order (Morton) curve in XY
+        void mortonOrder(std::vector<unsigned int>& order) const;
     // DATA
         /// pointer to list of CL-points on which to run drop-cutter.
         std::vector<CLPoint>* clpoints;
+        /// run the CL-points in Morton order
+        bool morton;
+        /// the number of CL-points in a packet, or 0
+        unsigned int packetSize;
+        /// start each drop at the previous contact
+        bool warm;
 
 };
 
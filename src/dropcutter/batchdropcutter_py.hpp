@@ -21,18 +21,173 @@
 #ifndef BDC_PY_H
 #define BDC_PY_H
 
+#include <cstring>
+
 #include <boost/python.hpp> 
 #include <boost/foreach.hpp> 
+#include <boost/static_assert.hpp>
 
 #include "batchdropcutter.hpp"
 
 namespace ocl
 {
 
+// the arrays of BatchDropCutter_py read the CLPoints and CCPoints in place
+BOOST_STATIC_ASSERT( sizeof(Point) == 3*sizeof(double) );
+BOOST_STATIC_ASSERT( sizeof(CCType) == sizeof(int) );
+
+/// \brief Python object that exports a strided array in the CL-points of a BatchDropCutter_py
+///
+/// The array is exported through the buffer protocol of Python 2.6 and later, so that 
+/// a memoryview or numpy array of it shares the memory of the CL-points. The CLArray holds a 
+/// reference to the Python object that owns the CL-points, and counts itself in its exports,
+/// so that the CL-points are neither freed nor moved while the CArray exists. The array is read-only.
+struct CLArray {
+    PyObject_HEAD
+    /// the Python BatchDropCutter
+    PyObject* owner;
+    /// the export count of the owner
+    int* exports;
+    /// the first item
+    char* buf;
+    /// format of the items, as in the struct module
+    const char* format;
+    /// size of an item
+    Py_ssize_t itemsize;
+    /// 1 or 2
+    int ndim;
+    /// rows, and columns if ndim == 2
+    Py_ssize_t shape[2];
+    /// bytes from one row, and one column, to the next
+    Py_ssize_t strides[2];
+    
+    /// a memoryview of a new CLArray
+    static boost::python::object view(PyObject* owner, int* exports, const void* buf, const char* format, 
+                                      Py_ssize_t itemsize, Py_ssize_t rows, int cols, Py_ssize_t rowstride) {
+        CLArray* a = PyObject_New(CLArray, type());
+        if ( !a )
+            boost::python::throw_error_already_set();
+        Py_INCREF(owner);
+        a->owner = owner;
+        a->exports = exports;
+        ++(*exports);
+        a->buf = (char*) buf;
+        a->format = format;
+        a->itemsize = itemsize;
+        a->ndim = (cols > 0) ? 2 : 1;
+        a->shape[0] = rows;
+        a->shape[1] = cols;
+        a->strides[0] = rowstride;
+        a->strides[1] = itemsize;
+        boost::python::object arr( boost::python::handle<>( (PyObject*) a ) );
+        return boost::python::object( boost::python::handle<>( PyMemoryView_FromObject( arr.ptr() ) ) );
+    }
+    /// the Python type of CLArray
+    static PyTypeObject* type() {
+        static PyTypeObject t = { PyVarObject_HEAD_INIT(NULL, 0) };
+        static PyBufferProcs procs;
+        if ( !t.tp_name ) {
+            procs.bf_getbuffer = getbuffer;
+            t.tp_name = "ocl.CLArray";
+            t.tp_basicsize = sizeof(CLArray);
+            t.tp_dealloc = dealloc;
+            t.tp_as_buffer = &procs;
+            t.tp_flags = Py_TPFLAGS_DEFAULT;
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+            t.tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER; // Python 2
+#endif
+            t.tp_doc = "read-only array in the CL-points of a BatchDropCutter";
+            if ( PyType_Ready( &t ) != 0 )
+                boost::python::throw_error_already_set();
+        }
+        return &t;
+    }
+    static void dealloc(PyObject* o) {
+        CLArray* a = (CLArray*) o;
+        --(*a->exports);
+        Py_DECREF(a->owner);
+        PyObject_Del(o);
+    }
+    static int getbuffer(PyObject* o, Py_buffer* view, int flags) {
+        CLArray* a = (CLArray*) o;
+        view->obj = NULL;
+        if ( (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE ) {
+            PyErr_SetString( PyExc_BufferError, "the CL-point arrays are read-only" );
+            return -1;
+        }
+        if ( (flags & PyBUF_STRIDES) != PyBUF_STRIDES ) {
+            PyErr_SetString( PyExc_BufferError, "the CL-point arrays are strided, not contiguous" );
+            return -1;
+        }
+        static double empty; // buf is never NULL, even with no CL-points
+        view->buf = a->shape[0] ? a->buf : (char*) &empty;
+        Py_INCREF(o);
+        view->obj = o;
+        view->len = a->shape[0] * ( (a->ndim == 2) ? a->shape[1] : 1 ) * a->itemsize;
+        view->readonly = 1;
+        view->itemsize = a->itemsize;
+        view->format = (flags & PyBUF_FORMAT) ? (char*) a->format : NULL;
+        view->ndim = a->ndim;
+        view->shape = a->shape;
+        view->strides = a->strides;
+        view->suboffsets = NULL;
+        view->internal = NULL;
+        return 0;
+    }
+};
+
 /// Python wrapper for BatchDropCutter
+///
+/// Besides the CLPoint objects of appendPoint() and getCLPoints(), the CL-points can be given
+/// and returned as arrays, through the Python buffer protocol (e.g. numpy arrays):
+/// appendPoints() reads an N x 2 or N x 3 C-contiguous float64 buffer directly, and
+/// getCLArray(), getCCArray() and getCCTypes() return read-only memoryviews of the x, y, z 
+/// and cc fields of the CL-points themselves, without a copy or a Python object per point. 
+/// numpy.asarray() wraps them without a copy. A view shows the results of later run() calls. 
+/// While a view (or an array made from it) exists, appendPoint(), appendPoints() and clearCLPoints()
+/// raise BufferError, as they may move or remove the CL-points.
 class BatchDropCutter_py : public BatchDropCutter {
     public:
-        BatchDropCutter_py() : BatchDropCutter() {};
+        BatchDropCutter_py() : BatchDropCutter(), exports(0) {};
+        /// append a CL-point
+        void appendPoint(CLPoint& p) {
+            checkExports();
+            BatchDropCutter::appendPoint(p);
+        }
+        /// remove all CL-points
+        void clearCLPoints() {
+            checkExports();
+            BatchDropCutter::clearCLPoints();
+        }
+        /// append the N x 3 CL-points (x, y, z) of a C-contiguous float64 buffer
+        void appendPoints(boost::python::object pts) {
+            appendBuffer( pts, 3, 0.0 );
+        }
+        /// append the N x 2 CL-points (x, y) of a C-contiguous float64 buffer, all at height z
+        void appendPointsXY(boost::python::object pts, double z) {
+            appendBuffer( pts, 2, z );
+        }
+        /// return the CL-points of the BatchDropCutter self as an N x 3 float64 memoryview (x, y, z)
+        static boost::python::object getCLArray(boost::python::object self) {
+            BatchDropCutter_py& b = boost::python::extract<BatchDropCutter_py&>(self);
+            const CLPoint* p = b.clpoints->empty() ? NULL : &(*b.clpoints)[0];
+            return CLArray::view( self.ptr(), &b.exports, p ? &p->x : NULL, "d", sizeof(double), 
+                                  b.clpoints->size(), 3, sizeof(CLPoint) );
+        }
+        /// return the CC-points of the BatchDropCutter self as an N x 3 float64 memoryview (x, y, z)
+        static boost::python::object getCCArray(boost::python::object self) {
+            BatchDropCutter_py& b = boost::python::extract<BatchDropCutter_py&>(self);
+            const CLPoint* p = b.clpoints->empty() ? NULL : &(*b.clpoints)[0];
+            return CLArray::view( self.ptr(), &b.exports, p ? &p->cc.x : NULL, "d", sizeof(double), 
+                                  b.clpoints->size(), 3, sizeof(CLPoint) );
+        }
+        /// return the CCType of the CC-points of the BatchDropCutter self as an int32 memoryview of length N
+        static boost::python::object getCCTypes(boost::python::object self) {
+            BatchDropCutter_py& b = boost::python::extract<BatchDropCutter_py&>(self);
+            const CLPoint* p = b.clpoints->empty() ? NULL : &(*b.clpoints)[0];
+            return CLArray::view( self.ptr(), &b.exports, p ? &p->cc.type : NULL, "i", sizeof(int), 
+                                  b.clpoints->size(), 0, sizeof(CLPoint) );
+        }
         /// return CL-points to Python
         boost::python::list getCLPoints_py() {
             boost::python::list plist;
@@ -53,6 +208,39 @@ class BatchDropCutter_py : public BatchDropCutter {
             delete triangles_under_cutter;
             return trilist;
         };
+    protected:
+        /// append the rows of buffer pts, which must be N x cols C-contiguous float64. 
+        /// With cols == 2 the CL-points get height z.
+        void appendBuffer(boost::python::object pts, int cols, double z) {
+            checkExports();
+            Py_buffer view;
+            if ( PyObject_GetBuffer( pts.ptr(), &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT ) != 0 )
+                boost::python::throw_error_already_set();
+            const bool ok = (view.ndim == 2) && (view.shape[1] == cols) && (view.itemsize == sizeof(double)) &&
+                            ( (view.format == NULL) || (std::strcmp(view.format, "d") == 0) || 
+                              (std::strcmp(view.format, "=d") == 0) || (std::strcmp(view.format, "<d") == 0) );
+            if ( !ok ) {
+                PyBuffer_Release( &view );
+                PyErr_SetString( PyExc_ValueError, (cols == 3) ? "expected an N x 3 contiguous float64 array" 
+                                                               : "expected an N x 2 contiguous float64 array" );
+                boost::python::throw_error_already_set();
+            }
+            const double* a = static_cast<const double*>( view.buf );
+            const Py_ssize_t n = view.shape[0];
+            clpoints->reserve( clpoints->size() + n );
+            for (Py_ssize_t m=0; m<n; ++m, a+=cols)
+                clpoints->push_back( CLPoint( a[0], a[1], (cols == 3) ? a[2] : z ) );
+            PyBuffer_Release( &view );
+        }
+        /// raise BufferError if the CL-points are exported by getCLArray(), getCCArray() or getCCTypes()
+        void checkExports() const {
+            if ( exports > 0 ) {
+                PyErr_SetString( PyExc_BufferError, "the CL-points can't be appended to or cleared while they are exported as arrays" );
+                boost::python::throw_error_already_set();
+            }
+        }
+        /// the number of CLArray objects of the CL-points
+        int exports;
 };
 
 } // end namespace
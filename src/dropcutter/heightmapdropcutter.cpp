@@ -0,0 +1,347 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+#include <cassert>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _OPENMP  
+    #include <omp.h>
+#endif
+
+#include "heightmapdropcutter.hpp"
+#include "millingcutter.hpp"
+#include "indexedmesh.hpp"
+#include "meshquery.hpp"
+#include "dropkernel.hpp"
+
+// as in dropkernel.cpp, the AVX2 version is compiled with a target attribute
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OCL_HEIGHTMAP_AVX2
+#include <immintrin.h>
+#endif
+
+namespace ocl
+{
+
+/// the heightmap value of a cell not covered by the surface
+static const double EMPTY = -std::numeric_limits<double>::max();
+
+/// out[i] = max( out[i], in[i] - g ), for i = 0 ... n-1
+static void dilateRow(double* out, const double* in, double g, int n) {
+    for (int i=0; i<n; ++i)
+        out[i] = std::max( out[i], in[i] - g );
+}
+
+#ifdef OCL_HEIGHTMAP_AVX2
+/// dilateRow(), four cells at a time
+__attribute__((target("avx2")))
+static void dilateRowAVX2(double* out, const double* in, double g, int n) {
+    const __m256d vg = _mm256_set1_pd( g );
+    int i = 0;
+    for ( ; i+4<=n; i+=4) {
+        const __m256d v = _mm256_sub_pd( _mm256_loadu_pd(in+i), vg );
+        _mm256_storeu_pd( out+i, _mm256_max_pd( _mm256_loadu_pd(out+i), v ) );
+    }
+    for ( ; i<n; ++i)
+        out[i] = std::max( out[i], in[i] - g );
+}
+#endif
+
+/// out[i] = max( in[i] ... in[i+k-1] ), for i = 0 ... n-k. With the van Herk/Gil-Werman
+/// algorithm: the maximum from the start of each block of k to i in pre, and from i to 
+/// the end of the block in suf. Window i spans at most two blocks, so it is the max of 
+/// suf[i] and pre[i+k-1]: three comparisons per cell, whatever the width k.
+static void slidingMax(const double* in, int n, int k, double* out, double* pre, double* suf) {
+    for (int i=0; i<n; ++i)
+        pre[i] = (i % k == 0) ? in[i] : std::max( pre[i-1], in[i] );
+    for (int i=n-1; i>=0; --i)
+        suf[i] = ( (i == n-1) || ((i+1) % k == 0) ) ? in[i] : std::max( suf[i+1], in[i] );
+    for (int i=0; i+k<=n; ++i)
+        out[i] = std::max( suf[i], pre[i+k-1] );
+}
+
+/// clip the polygon p[0] ... p[n-1] to the half-plane where x (k == 0) or y (k == 1) is
+/// at least v (sign 1) or at most v (sign -1). The clipped polygon is q[0] ... q[m-1].
+/// Returns m, at most n+1.
+static int clip(const Point* p, int n, int k, double v, double sign, Point* q) {
+    int m = 0;
+    for (int i=0; i<n; ++i) {
+        const Point& a = p[i];
+        const Point& b = p[(i+1) % n];
+        const double da = sign*( (k == 0 ? a.x : a.y) - v );
+        const double db = sign*( (k == 0 ? b.x : b.y) - v );
+        if ( da >= 0.0 )
+            q[m++] = a;
+        if ( (da >= 0.0) != (db >= 0.0) ) // the edge crosses the line
+            q[m++] = a + ( da / (da - db) ) * (b - a);
+    }
+    return m;
+}
+
+HeightMapDropCutter::HeightMapDropCutter() : minx(0.0), miny(0.0), cellsize(1.0), nx(0), ny(0), minimumZ(0.0), 
+                                             tolerance(0.0), nexact(0), margin(0), hx(0), hy(0) {
+    subOp.clear();
+}
+
+HeightMapDropCutter::~HeightMapDropCutter() {}
+
+void HeightMapDropCutter::setGrid(double x, double y, double size, int n, int m) {
+    if ( n <= 0 || m <= 0 || !(size > 0.0) ) {
+        std::cout << "HeightMapDropCutter::setGrid() ERROR: the grid needs nx > 0, ny > 0 and cellsize > 0, the grid is not changed\n";
+        return;
+    }
+    minx = x;
+    miny = y;
+    cellsize = size;
+    nx = n;
+    ny = m;
+    z.clear();
+}
+
+void HeightMapDropCutter::run() {
+    assert( cutter );
+    assert( index );
+    assert( cellsize > 0.0 );
+    if ( nx <= 0 || ny <= 0 ) { // setGrid() has not been called
+        std::cout << "HeightMapDropCutter::run() ERROR: no grid, call setGrid() first\n";
+        z.clear();
+        return;
+    }
+    margin = (int)floor( cutter->getRadius() / cellsize + 0.5 ); // cells within radius of the centre cell
+    hx = nx + 2*margin;
+    hy = ny + 2*margin;
+    std::cout << "HeightMapDropCutter " << nx << "x" << ny << " cl-points, " << hx << "x" << hy 
+              << " heightmap of " << surf->tris.size() << " triangles.\n";
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    rasterize();
+    dilate();
+    refine();
+    nCalls = nexact;
+}
+
+// heightmap cell (c,r) is the square of side cellsize centred at (x0 + c*cellsize, y0 + r*cellsize), 
+// and CL-point (i,j) is at the centre of cell (i+margin, j+margin). Each row of cells is 
+// scan-converted on its own, so the rows are filled in parallel: each face overlapping the row
+// is clipped to the row, and then to each cell of the row. The face is planar, so its max z 
+// in the cell is at a corner of the clipped polygon.
+void HeightMapDropCutter::rasterize() {
+    const IndexedMesh* mesh = index->mesh();
+    const MeshFaceData& fd = mesh->faceData();
+    const double x0 = minx - margin*cellsize;
+    const double y0 = miny - margin*cellsize;
+    hmap.assign( hx*hy, EMPTY );
+    // the faces of row r are rowfaces[first[r]] ... rowfaces[first[r+1]-1]
+    const unsigned int nf = mesh->numFaces();
+    std::vector<unsigned int> first( hy+1, 0 );
+    std::vector<int> rmin(nf), rmax(nf);
+    for (unsigned int f=0; f<nf; ++f) {
+        const double r0 = std::max( 0.0, ceil( (fd.miny[f] - y0) / cellsize - 0.5 ) );
+        const double r1 = std::min( hy - 1.0, floor( (fd.maxy[f] - y0) / cellsize + 0.5 ) );
+        rmin[f] = 0;
+        rmax[f] = -1;
+        if ( r1 < r0 ) // outside the heightmap
+            continue;
+        rmin[f] = (int)r0;
+        rmax[f] = (int)r1;
+        for (int r=rmin[f]; r<=rmax[f]; ++r)
+            ++first[r+1];
+    }
+    for (int r=0; r<hy; ++r)
+        first[r+1] += first[r];
+    std::vector<unsigned int> rowfaces( first[hy] );
+    std::vector<unsigned int> pos( first.begin(), first.end()-1 );
+    for (unsigned int f=0; f<nf; ++f) {
+        for (int r=rmin[f]; r<=rmax[f]; ++r)
+            rowfaces[ pos[r]++ ] = f;
+    }
+    int r;
+    #pragma omp parallel for schedule(dynamic) private(r)
+    for (r=0; r<hy; ++r) {
+        double* row = &hmap[r*hx];
+        const double ylo = y0 + (r - 0.5)*cellsize;
+        const double yhi = ylo + cellsize;
+        Point tri[3], tmp[8], band[8], cell[8]; // a triangle clipped by four lines has at most 7 corners
+        for (unsigned int n=first[r]; n<first[r+1]; ++n) {
+            const unsigned int f = rowfaces[n];
+            for (int m=0; m<3; ++m)
+                tri[m] = Point( fd.x[m][f], fd.y[m][f], fd.z[m][f] );
+            const int nt = clip( tri, 3, 1, ylo, 1.0, tmp );
+            const int nb = clip( tmp, nt, 1, yhi, -1.0, band );
+            if ( nb == 0 )
+                continue;
+            double xlo = band[0].x, xhi = band[0].x;
+            for (int m=1; m<nb; ++m) {
+                xlo = std::min( xlo, band[m].x );
+                xhi = std::max( xhi, band[m].x );
+            }
+            const double c0 = std::max( 0.0, ceil( (xlo - x0) / cellsize - 0.5 ) );
+            const double c1 = std::min( hx - 1.0, floor( (xhi - x0) / cellsize + 0.5 ) );
+            if ( c1 < c0 ) // outside the heightmap
+                continue;
+            for (int c=(int)c0; c<=(int)c1; ++c) {
+                const double xl = x0 + (c - 0.5)*cellsize;
+                const int nc = clip( band, nb, 0, xl, 1.0, tmp );
+                const int nn = clip( tmp, nc, 0, xl + cellsize, -1.0, cell );
+                for (int m=0; m<nn; ++m)
+                    row[c] = std::max( row[c], cell[m].z );
+            }
+        }
+    }
+}
+
+// the structuring element is the cells (dx,dy) within the cutter radius, where the cutter is
+// height(d) above its tip, d the distance to the nearest point of the cell. height(r) grows with r, 
+// so in each row dy of the element the cells with height zero are -flat[dy] ... flat[dy]. Those are 
+// dilated with one slidingMax() per row dy, and the other cells one at a time with dilateRow().
+void HeightMapDropCutter::dilate() {
+    const double radius = cutter->getRadius();
+    std::vector<int> width( 2*margin+1, -1 );  // cells -width[dy] ... width[dy] are under the cutter
+    std::vector<int> flat( 2*margin+1, -1 );   // cells -flat[dy] ... flat[dy] are at height zero
+    std::vector< std::vector<double> > profile( 2*margin+1 ); // profile[dy][dx], 0 <= dx <= width[dy]
+    for (int dy=-margin; dy<=margin; ++dy) {
+        std::vector<double>& prof = profile[dy+margin];
+        const double ey = std::max( 0.0, (dy < 0 ? -dy : dy) - 0.5 );
+        for (int dx=0; dx<=margin; ++dx) {
+            const double ex = std::max( 0.0, dx - 0.5 );
+            const double r = cellsize * sqrt( ex*ex + ey*ey );
+            if ( r > radius )
+                break;
+            prof.push_back( cutter->height(r) );
+            width[dy+margin] = dx;
+            if ( prof.back() == 0.0 )
+                flat[dy+margin] = dx;
+        }
+    }
+    void (*dilate_row)(double*, const double*, double, int) = dilateRow;
+#ifdef OCL_HEIGHTMAP_AVX2
+    if ( DropKernel::hasAVX2() )
+        dilate_row = dilateRowAVX2;
+#endif
+    z.resize( nx*ny );
+    int j;
+    #pragma omp parallel private(j)
+    {
+    std::vector<double> out(nx), tmp(nx), pre(hx), suf(hx); // per-thread rows
+    #pragma omp for schedule(dynamic)
+    for (j=0; j<ny; ++j) {
+        std::fill( out.begin(), out.end(), EMPTY );
+        for (int dy=-margin; dy<=margin; ++dy) {
+            const int w = width[dy+margin];
+            const int wf = flat[dy+margin];
+            // row[i] is the heightmap cell (dx,dy) = (0,0) from CL-point (i,j)
+            const double* row = &hmap[ (j+margin+dy)*hx + margin ];
+            if ( wf >= 0 ) {
+                slidingMax( row - wf, nx + 2*wf, 2*wf+1, &tmp[0], &pre[0], &suf[0] );
+                dilate_row( &out[0], &tmp[0], 0.0, nx );
+            }
+            for (int dx=wf+1; dx<=w; ++dx) {
+                const double g = profile[dy+margin][dx];
+                dilate_row( &out[0], row + dx, g, nx );
+                dilate_row( &out[0], row - dx, g, nx );
+            }
+        }
+        for (int i=0; i<nx; ++i)
+            z[j*nx+i] = std::max( minimumZ, out[i] );
+    }
+    } // end OpenMP PARALLEL region
+}
+
+// the heightmap CL-points are too high where the surface changes within a cell. near steep walls
+// the CL-surface changes quickly from one CL-point to the next, so those CL-points are found 
+// again with MeshQuery, as in BatchDropCutter. where an exact CL-point is lower than the heightmap 
+// one by more than the tolerance, its neighbours are tested again against it, until no more 
+// CL-points change.
+void HeightMapDropCutter::refine() {
+    nexact = 0;
+    if ( tolerance <= 0.0 )
+        return;
+    std::vector<unsigned char> done( nx*ny, 0 ); // CL-point by exact drop-cutter, or queued for it
+    std::vector<int> steep;
+    for (int j=0; j<ny; ++j) {
+        for (int i=0; i<nx; ++i) {
+            const int k = j*nx+i;
+            if ( ( (i > 0)    && (fabs( z[k-1] - z[k] ) > tolerance) ) ||
+                 ( (i < nx-1) && (fabs( z[k+1] - z[k] ) > tolerance) ) ||
+                 ( (j > 0)    && (fabs( z[k-nx] - z[k] ) > tolerance) ) ||
+                 ( (j < ny-1) && (fabs( z[k+nx] - z[k] ) > tolerance) ) ) {
+                steep.push_back( k );
+                done[k] = 1;
+            }
+        }
+    }
+    const KDTree<Triangle>* tree = index->xyTree();
+    const DropKernel kernel( cutter );
+    std::vector<double> zmap;
+    while ( !steep.empty() ) {
+        const int nsteep = steep.size();
+        zmap.resize( nsteep );
+        int n;
+        #pragma omp parallel private(n)
+        {
+        MeshQuery query( index->mesh() ); // per-thread vertex and edge stamps
+        #pragma omp for schedule(dynamic)
+        for (n=0; n<nsteep; ++n) {
+            const int k = steep[n];
+            CLPoint cl( minx + (k % nx)*cellsize, miny + (k / nx)*cellsize, minimumZ );
+            if ( kernel.supported() )
+                query.dropCutter( tree, kernel, cl );
+            else
+                query.dropCutter( tree, cutter, cl );
+            zmap[n] = z[k];
+            z[k] = cl.z;
+        }
+        } // end OpenMP PARALLEL region
+        nexact += nsteep;
+        std::vector<int> next;
+        for (n=0; n<nsteep; ++n) {
+            const int k = steep[n];
+            if ( zmap[n] - z[k] <= tolerance )
+                continue;
+            const int i = k % nx;
+            const int j = k / nx;
+            const int nbr[4] = { (i > 0) ? k-1 : -1, (i < nx-1) ? k+1 : -1, (j > 0) ? k-nx : -1, (j < ny-1) ? k+nx : -1 };
+            for (int m=0; m<4; ++m) {
+                if ( (nbr[m] >= 0) && !done[ nbr[m] ] && (fabs( z[ nbr[m] ] - z[k] ) > tolerance) ) {
+                    next.push_back( nbr[m] );
+                    done[ nbr[m] ] = 1;
+                }
+            }
+        }
+        steep.swap( next );
+    }
+    std::cout << " " << nexact << " cl-points by exact drop-cutter.\n";
+}
+
+std::vector<CLPoint> HeightMapDropCutter::getCLPoints() {
+    std::vector<CLPoint> clpoints;
+    clpoints.reserve( z.size() );
+    for (unsigned int k=0; k<z.size(); ++k)
+        clpoints.push_back( CLPoint( minx + (k % nx)*cellsize, miny + (k / nx)*cellsize, z[k] ) );
+    return clpoints;
+}
+
+} // end namespace
+// end file heightmapdropcutter.cpp
@@ -0,0 +1,119 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEIGHTMAPDROPCUTTER_H
+#define HEIGHTMAPDROPCUTTER_H
+
+#include <vector>
+
+#include "clpoint.hpp"
+#include "operation.hpp"
+
+namespace ocl
+{
+
+class MillingCutter;
+
+///
+/// \brief drop-cutter on a dense XY-grid, by dilation of a heightmap of the surface
+///
+/// For a grid of millions of CL-points a kd-tree query per point is too slow.
+/// HeightMapDropCutter instead scan-converts the surface into a heightmap, with one
+/// cell centred at each CL-point, and finds the CL-surface as the grayscale dilation of 
+/// the heightmap by the cutter profile MillingCutter::height(r):
+/// the CL-point of cell p is at max( heightmap(q) - height(d(p,q)) ) over the cells q under 
+/// the cutter.
+///
+/// The heightmap is the max z of the surface over the whole cell, and d(p,q) is the 
+/// distance from p to the nearest point of cell q, so the CL-points are never below 
+/// the exact ones. They are too high where the surface or the cutter profile changes 
+/// within a cell. With setTolerance() the CL-points where the CL-surface changes by more 
+/// than the tolerance to a neighbouring CL-point, e.g. near steep walls, are found by 
+/// an exact drop-cutter.
+///
+/// The part of the profile where height(r) == 0 (all of a CylCutter, the flat bottom 
+/// of a BullCutter) is a flat structuring element, which is decomposed into one 
+/// running maximum along the rows per row-offset. The rest of the profile is dilated 
+/// one offset at a time, with AVX2 when the CPU supports it.
+/// The rows are processed in parallel with OpenMP.
+class HeightMapDropCutter : public Operation {
+    public:
+        HeightMapDropCutter();
+        virtual ~HeightMapDropCutter();
+        /// set the grid: nx times ny CL-points cellsize apart, the first one at (minx, miny)
+        /// a grid with nx or ny below 1, or cellsize not above 0, is rejected with an error, and the grid is not changed.
+        void setGrid(double minx, double miny, double cellsize, int nx, int ny);
+        /// set the minimum z-value, or "floor" for drop-cutter
+        void setZ(const double z) {minimumZ = z;}
+        /// return Z
+        double getZ() const {return minimumZ;}
+        /// drop exactly where the CL-surface changes by more than tol to a neighbouring CL-point.
+        /// with tol <= 0 (default) all CL-points are from the heightmap.
+        void setTolerance(double tol) {tolerance = tol;}
+        /// run drop-cutter on the grid
+        void run();
+        /// return the CL-points, row after row
+        std::vector<CLPoint> getCLPoints();
+        /// return the height of the CL-points: CL-point (i,j) is at height z[j*nx+i]
+        const std::vector<double>& getHeights() const {return z;}
+        /// return the height of CL-point (i,j)
+        double getHeight(int i, int j) const {return z[j*nx+i];}
+        /// return the number of CL-points found by exact drop-cutter
+        int getExactDrops() const {return nexact;}
+    protected:
+        /// scan-convert the surface into the heightmap
+        void rasterize();
+        /// dilate the heightmap by the cutter profile into z
+        void dilate();
+        /// exact drop-cutter where the CL-surface is steeper than the tolerance
+        void refine();
+    // DATA
+        /// x of the first CL-point
+        double minx;
+        /// y of the first CL-point
+        double miny;
+        /// distance between the CL-points
+        double cellsize;
+        /// number of CL-points along x
+        int nx;
+        /// number of CL-points along y
+        int ny;
+        /// the lowest z height, used when no triangles are touched
+        double minimumZ;
+        /// the tolerance of refine()
+        double tolerance;
+        /// number of CL-points from refine()
+        int nexact;
+        /// the heightmap extends margin cells beyond the grid on each side, the cells under the cutter
+        int margin;
+        /// number of heightmap cells along x, nx + 2*margin
+        int hx;
+        /// number of heightmap cells along y, ny + 2*margin
+        int hy;
+        /// the heightmap, row after row
+        std::vector<double> hmap;
+        /// the height of the CL-points, row after row
+        std::vector<double> z;
+};
+
+} // end namespace
+#endif
+// end file heightmapdropcutter.hpp
@@ -0,0 +1,57 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEIGHTMAPDROPCUTTER_PY_H
+#define HEIGHTMAPDROPCUTTER_PY_H
+
+#include <boost/python.hpp> 
+#include <boost/foreach.hpp> 
+
+#include "heightmapdropcutter.hpp"
+
+namespace ocl
+{
+
+/// Python wrapper for HeightMapDropCutter
+class HeightMapDropCutter_py : public HeightMapDropCutter {
+    public:
+        HeightMapDropCutter_py() : HeightMapDropCutter() {};
+        /// return a list of CL-points to python
+        boost::python::list getCLPoints_py() {
+            boost::python::list plist;
+            BOOST_FOREACH(CLPoint p, getCLPoints()) {
+                plist.append(p);
+            }
+            return plist;
+        };
+        /// return a list of the CL-point heights to python, row after row
+        boost::python::list getHeights_py() {
+            boost::python::list zlist;
+            BOOST_FOREACH(double h, z) {
+                zlist.append(h);
+            }
+            return zlist;
+        };
+};
+
+} // end namespace
+#endif
+// end file heightmapdropcutter_py.hpp
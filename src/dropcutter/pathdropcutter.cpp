@@ -36,6 +36,7 @@ PathDropCutter::PathDropCutter() {
     minimumZ = 0.0;
     subOp.clear();
     subOp.push_back( new BatchDropCutter() );  // we delegate to BatchDropCutter, who does the heavy lifting
+    setWarmStart(true); // consecutive points along the path are close together
     sampling = 0.1;
 }
 
@@ -54,6 +54,11 @@ class PathDropCutter : public Operation {
         double getZ() const {
             return minimumZ;
         }
+        /// if true, the drop at each sampled point starts with the triangles at the contact of the
+        /// previous point, see BatchDropCutter::setWarmStart(). Default true.
+        void setWarmStart(bool w) {
+            static_cast<BatchDropCutter*>( subOp[0] )->setWarmStart(w);
+        }
         /// run drop-cutter on the whole Path
         virtual void run();
         
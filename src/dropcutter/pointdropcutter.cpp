@@ -42,15 +42,12 @@ PointDropCutter::PointDropCutter() {
 #endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
 }
 
-void PointDropCutter::setSTL(const STLSurf &s) {
-    std::cout << "PointDropCutter::setSTL()\n";
-    surf = &s;
-    root->setXYDimensions(); // we search for triangles in the XY plane, don't care about Z-coordinate
-    root->setBucketSize( bucketSize );
-    root->build(s.tris);
+void PointDropCutter::setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx) {
+    std::cout << "PointDropCutter::setSurfaceIndex()\n";
+    Operation::setSurfaceIndex(idx);
+    root = index->xyTree(); // we search for triangles in the XY plane, don't care about Z-coordinate
 }
 
 void PointDropCutter::run(CLPoint& clp) {
@@ -62,21 +59,9 @@ void PointDropCutter::run(CLPoint& clp) {
 // use OpenMP to share work between threads
 void PointDropCutter::pointDropCutter1(CLPoint& clp) {
     nCalls = 0;
-    int calls=0;
-    std::list<Triangle>* tris;
-    //tris=new std::list<Triangle>();
-    tris = root->search_cutter_overlap( cutter, &clp );
-    std::list<Triangle>::iterator it;
-    for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-        if ( cutter->overlaps(clp,*it) ) { // cutter overlap triangle? check
-            if (clp.below(*it)) {
-                cutter->dropCutter(clp,*it);
-                ++calls;
-            }
-        }
-    }
-    delete( tris );
-    nCalls = calls;
+    CutterDropVisitor<Triangle> drop( root, cutter, clp );
+    root->visit_cutter_drop( cutter, &clp, drop ); // highest triangles first, skip triangles below clp
+    nCalls = drop.calls;
     return;
 }
 
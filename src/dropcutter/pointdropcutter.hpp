@@ -42,9 +42,9 @@ class PointDropCutter : public Operation {
         PointDropCutter();
         virtual ~PointDropCutter() {
             std::cout << " ~PointDropCutter() \n";
-            delete root;
         }
-        void setSTL(const STLSurf &s);
+        /// use the XY kd-tree of idx
+        void setSurfaceIndex(boost::shared_ptr<SurfaceIndex> idx);
         void run(CLPoint& cl);
         void run() {
             std::cout << "ERROR: can't call run() on PointDropCutter()\n";
@@ -0,0 +1,217 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _OPENMP  
+    #include <omp.h>
+#endif
+
+#include "rasterdropcutter.hpp"
+#include "millingcutter.hpp"
+#include "cylcutter.hpp"
+#include "ballcutter.hpp"
+#include "bullcutter.hpp"
+#include "conecutter.hpp"
+#include "indexedmesh.hpp"
+#include "meshquery.hpp"
+#include "meshdropengine.hpp"
+#include "dropkernel.hpp"
+#include "numeric.hpp"
+
+namespace ocl
+{
+
+/// orders faces by decreasing MeshFaceData::maxz
+class MaxzGreater {
+    public:
+        MaxzGreater(const std::vector<double>& z) : maxz(z) {}
+        bool operator()(unsigned int a, unsigned int b) const {return maxz[a] > maxz[b];}
+    private:
+        const std::vector<double>& maxz;
+};
+
+/// orders faces by increasing smin
+class SminLess {
+    public:
+        SminLess(const std::vector<double>& s) : smin(s) {}
+        bool operator()(unsigned int a, unsigned int b) const {return smin[a] < smin[b];}
+    private:
+        const std::vector<double>& smin;
+};
+
+RasterDropCutter::RasterDropCutter() : origin(0,0,0), dir(1,0,0), normal(0,1,0), length(0.0), stepover(1.0),
+                                       nlines(0), npoints(0), minimumZ(0.0), zigzag(true) {
+    subOp.clear();
+}
+
+RasterDropCutter::~RasterDropCutter() {}
+
+void RasterDropCutter::setRaster(const Point& o, const Point& d, double len, double step, int n) {
+    if ( isZero_tol( Point(d.x, d.y, 0).xyNorm() ) ) {
+        std::cout << "RasterDropCutter::setRaster() ERROR: dir has no XY-component, the raster is not changed\n";
+        return;
+    }
+    origin = o;
+    dir = Point(d.x, d.y, 0);
+    dir.xyNormalize();
+    normal = Point(-dir.y, dir.x, 0);
+    length = len;
+    stepover = step;
+    nlines = n;
+    clpoints.clear();
+}
+
+void RasterDropCutter::run() {
+    assert( cutter );
+    assert( index );
+    assert( sampling > 0.0 );
+    assert( stepover > 0.0 );
+    unsigned int num_steps = (unsigned int)(length / sampling + 1); // as PathDropCutter::sample_span()
+    npoints = num_steps + 1;
+    clpoints.resize( nlines*npoints );
+    std::cout << "RasterDropCutter " << nlines << " lines of " << npoints << " cl-points and " 
+              << surf->tris.size() << " triangles.\n";
+    bucketFaces();
+    if ( const CylCutter* c = dynamic_cast<const CylCutter*>(cutter) )
+        sweep( MeshDropEngine<CylCutter>(c) );
+    else if ( const BallCutter* c = dynamic_cast<const BallCutter*>(cutter) )
+        sweep( MeshDropEngine<BallCutter>(c) );
+    else if ( const BullCutter* c = dynamic_cast<const BullCutter*>(cutter) )
+        sweep( MeshDropEngine<BullCutter>(c) );
+    else if ( const ConeCutter* c = dynamic_cast<const ConeCutter*>(cutter) )
+        sweep( MeshDropEngine<ConeCutter>(c) );
+    else
+        sweep( MeshDropEngine<MillingCutter>(cutter) );
+    std::cout << " " << nCalls << " dropCutter() calls, " << nPruned << " triangles outside the cutter footprint.\n";
+}
+
+// a face is under the cutter on line k if its extent across the lines is within radius of the line.
+// the faces are added to the lines in order of smin, so each line is sorted by smin for sweep().
+void RasterDropCutter::bucketFaces() {
+    const IndexedMesh* mesh = index->mesh();
+    const MeshFaceData& fd = mesh->faceData();
+    const double r = cutter->getRadius();
+    const unsigned int nf = mesh->numFaces();
+    smin.resize(nf);
+    smax.resize(nf);
+    std::vector<int> kmin(nf), kmax(nf); // the lines of each face
+    first.assign( nlines+1, 0 );
+    for (unsigned int f=0; f<nf; ++f) {
+        double t0 = 0.0, t1 = 0.0;
+        for (int m=0; m<3; ++m) {
+            const double x = fd.x[m][f] - origin.x;
+            const double y = fd.y[m][f] - origin.y;
+            const double s = x*dir.x + y*dir.y;       // along the lines
+            const double t = x*normal.x + y*normal.y; // across the lines
+            if ( (m == 0) || (s < smin[f]) ) smin[f] = s;
+            if ( (m == 0) || (s > smax[f]) ) smax[f] = s;
+            if ( (m == 0) || (t < t0) ) t0 = t;
+            if ( (m == 0) || (t > t1) ) t1 = t;
+        }
+        const double k0 = std::max( 0.0, ceil( (t0 - r) / stepover ) );
+        const double k1 = std::min( nlines - 1.0, floor( (t1 + r) / stepover ) );
+        if ( k1 < k0 ) { // not under any line
+            kmin[f] = 0;
+            kmax[f] = -1;
+            continue;
+        }
+        kmin[f] = (int)k0;
+        kmax[f] = (int)k1;
+        for (int k=kmin[f]; k<=kmax[f]; ++k)
+            ++first[k+1];
+    }
+    for (int k=0; k<nlines; ++k)
+        first[k+1] += first[k];
+    faces.resize( first[nlines] );
+    std::vector<unsigned int> bysmin(nf);
+    for (unsigned int f=0; f<nf; ++f)
+        bysmin[f] = f;
+    std::sort( bysmin.begin(), bysmin.end(), SminLess(smin) );
+    std::vector<unsigned int> pos( first.begin(), first.end()-1 );
+    for (unsigned int n=0; n<nf; ++n) {
+        const unsigned int f = bysmin[n];
+        for (int k=kmin[f]; k<=kmax[f]; ++k)
+            faces[ pos[k]++ ] = f;
+    }
+}
+
+// the cutter moves along line k from s=0 to s=length. the faces of the line enter the active set 
+// in order of smin, when smin <= s+r, and leave it when smax < s-r. the active set is sorted by 
+// decreasing maxz, so that MeshQuery can stop at the first face below the cutter, 
+// as the branch-and-bound of KDTree::visit_cutter_drop().
+template <class CutterT>
+void RasterDropCutter::sweep(const MeshDropEngine<CutterT>& engine) {
+    const IndexedMesh* mesh = index->mesh();
+    const MaxzGreater higher( mesh->faceData().maxz );
+    const DropKernel kernel( cutter );
+    const double r = cutter->getRadius();
+    nCalls = 0;
+    nPruned = 0;
+    int calls = 0, pruned = 0;
+    int k;
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    #pragma omp parallel private(k) reduction(+:calls,pruned)
+    {
+    MeshQuery query( mesh );              // per-thread vertex and edge stamps
+    std::vector<unsigned int> active;     // the faces under the cutter
+    #pragma omp for schedule(dynamic)
+    for (k=0; k<nlines; ++k) {
+        active.clear();
+        unsigned int next = first[k];     // the next face to enter the active set
+        const Point start = origin + (k*stepover)*normal;
+        const bool reverse = zigzag && (k % 2 == 1);
+        for (int j=0; j<npoints; ++j) {
+            const double s = length * j / (npoints-1);
+            while ( (next < first[k+1]) && (smin[ faces[next] ] <= s + r) ) {
+                const unsigned int f = faces[next++];
+                if ( smax[f] >= s - r ) // not passed between two samples
+                    active.insert( std::upper_bound( active.begin(), active.end(), f, higher ), f );
+            }
+            unsigned int m = 0;
+            for (unsigned int i=0; i<active.size(); ++i) {
+                if ( smax[ active[i] ] >= s - r )
+                    active[m++] = active[i];
+            }
+            active.resize(m);
+            const Point p = start + s*dir;
+            CLPoint& cl = clpoints[ k*npoints + (reverse ? npoints-1-j : j) ];
+            cl = CLPoint( p.x, p.y, minimumZ );
+            if ( active.empty() )
+                continue;
+            if ( kernel.supported() )
+                calls += query.dropCutter( &active[0], active.size(), kernel, engine, cl );
+            else
+                calls += query.dropCutter( &active[0], active.size(), engine, cl );
+        }
+    }
+    pruned += query.getPruned();
+    } // end OpenMP PARALLEL region
+    nCalls = calls;
+    nPruned = pruned;
+}
+
+} // end namespace
+// end file rasterdropcutter.cpp
@@ -0,0 +1,111 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RASTERDROPCUTTER_H
+#define RASTERDROPCUTTER_H
+
+#include <vector>
+
+#include "point.hpp"
+#include "clpoint.hpp"
+#include "operation.hpp"
+
+namespace ocl
+{
+
+class MillingCutter;
+template <class CutterT> class MeshDropEngine;
+
+///
+/// \brief drop-cutter on a raster of parallel lines, for zig-zag finishing paths
+///
+/// The raster is a number of parallel lines, the first one from the origin in the
+/// raster direction, the next ones offset by the step-over to the left of the direction.
+/// Each line is sampled uniformly, at most the sampling interval apart.
+///
+/// BatchDropCutter searches the kd-tree for each CL-point, although the cutter at two 
+/// neighbouring points of a line covers almost the same triangles. RasterDropCutter instead 
+/// sweeps the cutter along each line, and keeps the triangles under the cutter in an active 
+/// set: a triangle enters the set when the cutter reaches it along the line, and leaves 
+/// it when the cutter has passed it. The triangles of each line are found once, 
+/// by their extent across the lines. The lines are swept in parallel with OpenMP.
+class RasterDropCutter : public Operation {
+    public:
+        RasterDropCutter();
+        virtual ~RasterDropCutter();
+        /// set the raster: n lines of length len, the first one from o in direction dir, 
+        /// the next ones offset by stepover to the left of dir. dir is projected to the XY-plane.
+        /// a dir with no XY-component is rejected with an error, and the raster is not changed.
+        void setRaster(const Point& o, const Point& dir, double len, double stepover, int n);
+        /// set the minimum z-value, or "floor" for drop-cutter
+        void setZ(const double z) {minimumZ = z;}
+        /// return Z
+        double getZ() const {return minimumZ;}
+        /// if true (default) every other line is reversed, for a zig-zag path
+        void setZigZag(bool z) {zigzag = z;}
+        /// run drop-cutter on the raster
+        void run();
+        /// return the CL-points, line after line
+        std::vector<CLPoint> getCLPoints() {return clpoints;}
+        /// clears the vector of CLPoints
+        void clearCLPoints() {clpoints.clear();}
+        /// return the number of lines
+        int getLines() const {return nlines;}
+        /// return the number of CL-points on each line
+        int getLinePoints() const {return npoints;}
+    protected:
+        /// sweep the cutter along all lines, with the MeshDropEngine e of the cutter type
+        template <class CutterT>
+        void sweep(const MeshDropEngine<CutterT>& e);
+        /// find the triangles of each line, and their extent along the lines
+        void bucketFaces();
+    // DATA
+        /// start of the first line
+        Point origin;
+        /// unit direction of the lines
+        Point dir;
+        /// unit normal of the lines, to the left of dir
+        Point normal;
+        /// length of the lines
+        double length;
+        /// distance between the lines
+        double stepover;
+        /// number of lines
+        int nlines;
+        /// number of CL-points on each line
+        int npoints;
+        /// the lowest z height, used when no triangles are touched
+        double minimumZ;
+        /// reverse every other line
+        bool zigzag;
+        /// the CL-points of line n are clpoints[n*npoints] ... clpoints[(n+1)*npoints-1]
+        std::vector<CLPoint> clpoints;
+        /// extent of face n along the lines, relative to origin
+        std::vector<double> smin, smax;
+        /// the faces of line n are faces[first[n]] ... faces[first[n+1]-1]
+        std::vector<unsigned int> first;
+        /// the faces of all lines
+        std::vector<unsigned int> faces;
+};
+
+} // end namespace
+#endif
+// end file rasterdropcutter.hpp
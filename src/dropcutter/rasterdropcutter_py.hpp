@@ -0,0 +1,49 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RASTERDROPCUTTER_PY_H
+#define RASTERDROPCUTTER_PY_H
+
+#include <boost/python.hpp> 
+#include <boost/foreach.hpp> 
+
+#include "rasterdropcutter.hpp"
+
+namespace ocl
+{
+
+/// Python wrapper for RasterDropCutter
+class RasterDropCutter_py : public RasterDropCutter {
+    public:
+        RasterDropCutter_py() : RasterDropCutter() {};
+        /// return a list of CL-points to python
+        boost::python::list getCLPoints_py() {
+            boost::python::list plist;
+            BOOST_FOREACH(CLPoint p, clpoints) {
+                plist.append(p);
+            }
+            return plist;
+        };
+};
+
+} // end namespace
+#endif
+// end file rasterdropcutter_py.hpp
@@ -54,7 +54,6 @@ class CCPoint : public Point {
         CCPoint(const Point& p, CCType t);
         /// create a CCPoint at Point p
         CCPoint(const Point& p); 
-        virtual ~CCPoint(){};
         
         /// specifies the type of the Cutter Contact point. 
         CCType type;
@@ -30,33 +30,19 @@ namespace ocl
 /* ********************************************** CLPoint *************/
 
 CLPoint::CLPoint() 
-    : Point() {
-    cc = new CCPoint();
+    : Point(), cc() {
 }
 
 CLPoint::CLPoint(double x, double y, double z) 
-    : Point(x,y,z) {
-    cc = new CCPoint();
+    : Point(x,y,z), cc() {
 }
 
 CLPoint::CLPoint(double x, double y, double z, CCPoint& ccp) 
-    : Point(x,y,z) {
-    cc = new CCPoint( ccp );
-}
-
-
-CLPoint::CLPoint(const CLPoint& cl) 
-    : Point(cl.x,cl.y,cl.z) {
-    cc = new CCPoint( *cl.cc );
+    : Point(x,y,z), cc(ccp) {
 }
 
 CLPoint::CLPoint(const Point& p) 
-    : Point(p.x,p.y,p.z) {
-    cc = new CCPoint();
-}
-
-CLPoint::~CLPoint() {
-   delete cc;
+    : Point(p.x,p.y,p.z), cc() {
 }
 
 bool CLPoint::below(const Triangle& t) const {
@@ -78,9 +64,7 @@ bool CLPoint::liftZ(const double zin) {
 bool CLPoint::liftZ(double zin, CCPoint& ccp) {
     if (zin>z) {
         z=zin;
-        if (cc)
-            delete cc;
-        cc=new CCPoint( ccp );
+        cc=ccp;
         return true;
     } else {
         return false;
@@ -99,16 +83,6 @@ bool CLPoint::liftZ_if_inFacet(double zin, CCPoint& cc_tmp, const Triangle& t) {
     return false;
 }
 
-CLPoint& CLPoint::operator=(const CLPoint &clp) {
-    if (this == &clp)   // check for self-assignment
-        return *this;
-    x=clp.x;
-    y=clp.y;
-    z=clp.z;
-    cc= new CCPoint( *(clp.cc) );
-    return *this;
-}
-
 const CLPoint CLPoint::operator+(const CLPoint &p) const {
     return CLPoint(this->x + p.x, this->y + p.y, this->z + p.z);
 }
@@ -118,12 +92,12 @@ const CLPoint CLPoint::operator+(const Point &p) const {
 }
 
 CCPoint CLPoint::getCC() {
-    return *cc;
+    return cc;
 }
 
 std::string CLPoint::str() const {
     std::ostringstream o;
-    o << "CL(" << x << ", " << y << ", " << z << ") cc=" << *cc ;
+    o << "CL(" << x << ", " << y << ", " << z << ") cc=" << cc ;
     return o.str();
 }
 
@@ -33,6 +33,9 @@ namespace ocl
 ///
 /// \brief Cutter-Location (CL) point.
 ///
+/// The CCPoint is stored by value and no member is virtual, so a
+/// std::vector<CLPoint> is one contiguous array that is copied without
+/// any per-point allocation.
 class CLPoint : public Point {
     public:
         /// CLPoint at (0,0,0)
@@ -41,13 +44,10 @@ class CLPoint : public Point {
         CLPoint(double x, double y, double z);
         /// CLPoint at (x,y,z) with CCPoint ccp
         CLPoint(double x, double y, double z, CCPoint& ccp);
-        /// copy constructor
-        CLPoint(const CLPoint& cl);
         /// cl-point at Point p
         CLPoint(const Point& p);
-        virtual ~CLPoint();
-        /// Pointer to the corresponding CCPoint
-        CCPoint* cc; 
+        /// the corresponding CCPoint
+        CCPoint cc; 
         /// string repr
         std::string str() const;
         
@@ -70,8 +70,6 @@ class CLPoint : public Point {
         bool below(const Triangle& t) const;
         /// return the CCPoint (for python)
         CCPoint getCC();
-        /// assignment
-        CLPoint &operator=(const CLPoint &p);
         /// addition
         const CLPoint operator+(const CLPoint &p) const;
         const CLPoint operator+(const Point &p) const;
@@ -0,0 +1,289 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "indexedmesh.hpp"
+#include "stlsurf.hpp"
+#include "triangle.hpp"
+#include "numeric.hpp"
+
+namespace ocl
+{
+
+/// a cell of the uniform grid used for welding
+class WeldCell {
+    public:
+        WeldCell(boost::int64_t ix, boost::int64_t iy, boost::int64_t iz) : x(ix), y(iy), z(iz) {}
+        bool operator==(const WeldCell& o) const {return (x==o.x) && (y==o.y) && (z==o.z);}
+        boost::int64_t x, y, z;
+};
+
+/// hash of a WeldCell, found by boost::hash
+std::size_t hash_value(const WeldCell& c) {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, c.x);
+    boost::hash_combine(seed, c.y);
+    boost::hash_combine(seed, c.z);
+    return seed;
+}
+
+/// the first vertex in each grid cell. further vertices in the cell are chained with next[]
+typedef boost::unordered_map<WeldCell, unsigned int, boost::hash<WeldCell> > WeldGrid;
+
+static const unsigned int NO_VERTEX = 0xFFFFFFFF;
+
+/// return the index of a vertex within tol of p, after adding p as a new vertex if there is none
+static unsigned int weld(const Point& p, double tol, double cellsize, std::vector<Point>& verts,
+                         WeldGrid& grid, std::vector<unsigned int>& next) {
+    const boost::int64_t ix = (boost::int64_t) std::floor( p.x / cellsize );
+    const boost::int64_t iy = (boost::int64_t) std::floor( p.y / cellsize );
+    const boost::int64_t iz = (boost::int64_t) std::floor( p.z / cellsize );
+    // with cellsize >= tol a vertex within tol of p is in the cell of p, or in one of its neighbours
+    const int reach = (tol > 0.0) ? 1 : 0;
+    for (int dx=-reach; dx<=reach; ++dx) {
+        for (int dy=-reach; dy<=reach; ++dy) {
+            for (int dz=-reach; dz<=reach; ++dz) {
+                WeldGrid::const_iterator it = grid.find( WeldCell(ix+dx, iy+dy, iz+dz) );
+                if ( it == grid.end() )
+                    continue;
+                for (unsigned int v = it->second; v != NO_VERTEX; v = next[v]) {
+                    if ( (verts[v]-p).norm() <= tol )
+                        return v;
+                }
+            }
+        }
+    }
+    const unsigned int id = verts.size();
+    verts.push_back(p);
+    WeldGrid::iterator it = grid.find( WeldCell(ix, iy, iz) );
+    if ( it == grid.end() ) {
+        next.push_back( NO_VERTEX );
+        grid.insert( std::make_pair( WeldCell(ix, iy, iz), id ) );
+    } else {
+        next.push_back( it->second );
+        it->second = id;
+    }
+    return id;
+}
+
+void MeshFaceData::resize(unsigned int n) {
+    for (int m=0; m<3; ++m) {
+        x[m].resize(n);
+        y[m].resize(n);
+        z[m].resize(n);
+    }
+    nx.resize(n); ny.resize(n); nz.resize(n);
+    d.resize(n);
+    xynx.resize(n); xyny.resize(n);
+    dot00.resize(n); dot01.resize(n); dot11.resize(n);
+    invD.resize(n);
+    minx.resize(n); miny.resize(n); minz.resize(n);
+    maxx.resize(n); maxy.resize(n); maxz.resize(n);
+    flags.resize(n);
+}
+
+// the same quantities, computed in the same way, as in MillingCutter::facetDrop() and generalFacetPush()
+void MeshFaceData::set(unsigned int n, const Triangle& t) {
+    for (int m=0; m<3; ++m) {
+        x[m][n] = t.p[m].x;
+        y[m][n] = t.p[m].y;
+        z[m][n] = t.p[m].z;
+    }
+    Point normal = t.upNormal();
+    unsigned char f = 0;
+    if ( isZero_tol( normal.z ) )
+        f |= VERTICAL;
+    if ( isZero_tol( normal.x ) && isZero_tol( normal.y ) )
+        f |= HORIZONTAL;
+    if ( normal.zParallel() )
+        f |= Z_NORMAL;
+    flags[n] = f;
+    d[n] = - normal.dot( t.p[0] );
+    normal.normalize();
+    nx[n] = normal.x;
+    ny[n] = normal.y;
+    nz[n] = normal.z;
+    if ( f & Z_NORMAL ) {
+        xynx[n] = 0.0;
+        xyny[n] = 0.0;
+    } else {
+        Point xyNormal( normal.x, normal.y, 0.0 );
+        xyNormal.xyNormalize();
+        xynx[n] = xyNormal.x;
+        xyny[n] = xyNormal.y;
+    }
+    const Point v0 = t.p[2] - t.p[0];
+    const Point v1 = t.p[1] - t.p[0];
+    dot00[n] = v0.dot(v0);
+    dot01[n] = v0.dot(v1);
+    dot11[n] = v1.dot(v1);
+    invD[n] = 1.0 / ( dot00[n]*dot11[n] - dot01[n]*dot01[n] );
+    minx[n] = t.bb.minpt.x;
+    miny[n] = t.bb.minpt.y;
+    minz[n] = t.bb.minpt.z;
+    maxx[n] = t.bb.maxpt.x;
+    maxy[n] = t.bb.maxpt.y;
+    maxz[n] = t.bb.maxpt.z;
+}
+
+// the bounding-box is tested first, both for a quick reject and for a quick accept when 
+// it lies inside the circle. Otherwise the distance from the centre to the projected triangle
+// is zero if the centre is inside, and the distance to the nearest edge if not.
+bool MeshFaceData::outsideCircle(unsigned int n, double cx, double cy, double r) const {
+    const double rr = r*r;
+    const double dx = std::max( std::max( minx[n]-cx, cx-maxx[n] ), 0.0 ); // nearest point of the bbox
+    const double dy = std::max( std::max( miny[n]-cy, cy-maxy[n] ), 0.0 );
+    if ( dx*dx + dy*dy > rr )
+        return true;
+    const double fx = std::max( cx-minx[n], maxx[n]-cx ); // furthest point of the bbox
+    const double fy = std::max( cy-miny[n], maxy[n]-cy );
+    if ( fx*fx + fy*fy <= rr )
+        return false;
+    double side[3];
+    for (int m=0; m<3; ++m) {
+        const int k = (m+1) % 3;
+        side[m] = (x[k][n]-x[m][n])*(cy-y[m][n]) - (y[k][n]-y[m][n])*(cx-x[m][n]);
+    }
+    if ( ( (side[0] >= 0.0) && (side[1] >= 0.0) && (side[2] >= 0.0) ) || 
+         ( (side[0] <= 0.0) && (side[1] <= 0.0) && (side[2] <= 0.0) ) )
+        return false; // the centre is inside (or on the edge of) the projected triangle
+    for (int m=0; m<3; ++m) {
+        const int k = (m+1) % 3;
+        const double ex = x[k][n]-x[m][n], ey = y[k][n]-y[m][n];
+        const double px = cx-x[m][n],      py = cy-y[m][n];
+        const double len2 = ex*ex + ey*ey;
+        double t = (len2 > 0.0) ? (px*ex + py*ey) / len2 : 0.0;
+        t = std::min( std::max( t, 0.0 ), 1.0 );
+        const double qx = px - t*ex, qy = py - t*ey;
+        if ( qx*qx + qy*qy <= rr )
+            return false;
+    }
+    return true;
+}
+
+IndexedMesh::IndexedMesh(const STLSurf& s, double tolerance) : tol(tolerance) {
+    // the cell-size has a lower limit so that coordinates/cellsize fit in the int64 cell-index
+    const double cellsize = std::max( tol, 1e-9 );
+    WeldGrid grid;
+    std::vector<unsigned int> next;
+    verts.reserve( s.size()/2 + 3 );
+    next.reserve( s.size()/2 + 3 );
+    faces.resize( s.size() );
+    fdata.resize( s.size() );
+    unsigned int n = 0;
+    BOOST_FOREACH( const Triangle& t, s.tris ) {
+        for (int m=0; m<3; ++m)
+            faces[n].v[m] = weld( t.p[m], tol, cellsize, verts, grid, next );
+        fdata.set( n, t );
+        ++n;
+    }
+    
+    // each edge is (vmin, vmax). sort them, with the face-edge they came from, to find the unique ones
+    std::vector< std::pair< std::pair<unsigned int, unsigned int>, unsigned int> > refs;
+    refs.reserve( 3*faces.size() );
+    for (n=0; n<faces.size(); ++n) {
+        for (unsigned int m=0; m<3; ++m) {
+            unsigned int v1 = faces[n].v[m];
+            unsigned int v2 = faces[n].v[(m+1)%3];
+            refs.push_back( std::make_pair( std::make_pair( std::min(v1,v2), std::max(v1,v2) ), 3*n+m ) );
+        }
+    }
+    std::sort( refs.begin(), refs.end() );
+    edges.reserve( refs.size()/2 + 1 );
+    for (n=0; n<refs.size(); ++n) {
+        if ( (n==0) || (refs[n].first != refs[n-1].first) ) {
+            MeshEdge e;
+            e.v[0] = refs[n].first.first;
+            e.v[1] = refs[n].first.second;
+            edges.push_back(e);
+        }
+        faces[ refs[n].second / 3 ].e[ refs[n].second % 3 ] = edges.size()-1;
+    }
+    init_adjacency();
+}
+
+IndexedMesh::IndexedMesh(const STLSurf& s, double tolerance, const std::vector<Point>& v, 
+                         const std::vector<MeshEdge>& e, const std::vector<MeshFace>& f) 
+    : verts(v), edges(e), faces(f), tol(tolerance) {
+    assert( faces.size() == s.size() );
+    fdata.resize( s.size() );
+    unsigned int n = 0;
+    BOOST_FOREACH( const Triangle& t, s.tris ) {
+        fdata.set( n, t );
+        ++n;
+    }
+    init_adjacency();
+}
+
+void IndexedMesh::init_adjacency() {
+    unsigned int n;
+    // the faces around each vertex, counted first and then filled in
+    vfstart.assign( verts.size()+1, 0 );
+    for (n=0; n<faces.size(); ++n) {
+        for (int m=0; m<3; ++m)
+            ++vfstart[ faces[n].v[m]+1 ];
+    }
+    for (n=0; n<verts.size(); ++n)
+        vfstart[n+1] += vfstart[n];
+    vfaces.resize( 3*faces.size() );
+    std::vector<unsigned int> fill( vfstart.begin(), vfstart.end()-1 );
+    for (n=0; n<faces.size(); ++n) {
+        for (int m=0; m<3; ++m)
+            vfaces[ fill[ faces[n].v[m] ]++ ] = n;
+    }
+    
+    // edges that are vertical, as tested by MillingCutter::singleEdgeDrop(), get zero length
+    edata.ux.resize( edges.size() );
+    edata.uy.resize( edges.size() );
+    edata.len.resize( edges.size() );
+    for (n=0; n<edges.size(); ++n) {
+        const Point v = verts[ edges[n].v[1] ] - verts[ edges[n].v[0] ];
+        if ( isZero_tol( v.x ) && isZero_tol( v.y ) ) {
+            edata.ux[n] = 0.0;
+            edata.uy[n] = 0.0;
+            edata.len[n] = 0.0;
+        } else {
+            const double len = v.xyNorm();
+            edata.ux[n] = v.x / len;
+            edata.uy[n] = v.y / len;
+            edata.len[n] = len;
+        }
+    }
+}
+
+std::string IndexedMesh::str() const {
+    std::ostringstream o;
+    o << "IndexedMesh: " << verts.size() << " vertices, " << edges.size() << " edges, ";
+    o << faces.size() << " faces, weld tolerance " << tol;
+    return o.str();
+}
+
+} // end namespace
+// end file indexedmesh.cpp
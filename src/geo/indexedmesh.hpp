@@ -0,0 +1,200 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INDEXEDMESH_H
+#define INDEXEDMESH_H
+
+#include <string>
+#include <vector>
+
+#include "point.hpp"
+
+namespace ocl
+{
+
+class STLSurf;
+class Triangle;
+
+/// \brief an edge of an IndexedMesh, as two indices into the vertex array
+class MeshEdge {
+    public:
+        /// the end-points, v[0] <= v[1]. equal when the corners of the edge are welded into one vertex
+        unsigned int v[2];
+};
+
+/// \brief a triangle of an IndexedMesh, as indices into the vertex and edge arrays
+class MeshFace {
+    public:
+        /// the three corners
+        unsigned int v[3];
+        /// the three edges, e[n] joins v[n] and v[(n+1)%3]
+        unsigned int e[3];
+};
+
+/// \brief per-face data of an IndexedMesh, precomputed for drop-cutter and push-cutter
+///
+/// MillingCutter::facetDrop() and facetPush() find the up-normal, the plane of the
+/// facet and the XY-direction of the normal for every cutter-location and triangle.
+/// Here they are computed once per face, and stored with one array per quantity
+/// (structure-of-arrays), so that a kernel reads only the quantities it uses.
+/// The corners are those of the STLSurf triangle, not the welded vertices, so
+/// a facet contact found with this data is the same as one found with the Triangle.
+class MeshFaceData {
+    public:
+        /// flags[n] bits
+        enum {
+            /// the normal has no z-component (within tolerance): can't drop against the face
+            VERTICAL = 1,
+            /// the normal has no xy-component (within tolerance): horizontal facet-drop special case
+            HORIZONTAL = 2,
+            /// the normal is exactly along the z-axis: can't push against the face
+            Z_NORMAL = 4
+        };
+        /// resize all arrays to n faces
+        void resize(unsigned int n);
+        /// set face n from Triangle t
+        void set(unsigned int n, const Triangle& t);
+        /// corner m of face n
+        Point corner(unsigned int n, int m) const {return Point(x[m][n], y[m][n], z[m][n]);}
+        /// true if p, which lies in the plane of face n, is inside the face.
+        /// the same test as Point::isInside(const Triangle&), with the precomputed dot-products.
+        bool isInside(unsigned int n, const Point& p) const {
+            const double v0x = x[2][n]-x[0][n], v0y = y[2][n]-y[0][n], v0z = z[2][n]-z[0][n];
+            const double v1x = x[1][n]-x[0][n], v1y = y[1][n]-y[0][n], v1z = z[1][n]-z[0][n];
+            const double v2x = p.x-x[0][n],     v2y = p.y-y[0][n],     v2z = p.z-z[0][n];
+            const double dot02 = v0x*v2x + v0y*v2y + v0z*v2z;
+            const double dot12 = v1x*v2x + v1y*v2y + v1z*v2z;
+            const double u = (dot11[n] * dot02 - dot01[n] * dot12) * invD[n];
+            const double v = (dot00[n] * dot12 - dot01[n] * dot02) * invD[n];
+            return (u > 0.0) && (v > 0.0) && (u + v < 1.0);
+        }
+        /// true if the XY-projection of face n lies entirely outside the circle of radius r 
+        /// centred at (cx, cy), i.e. a cutter of radius r at (cx, cy) cannot touch the face
+        bool outsideCircle(unsigned int n, double cx, double cy, double r) const;
+        /// corner coordinates, x[m][n] is the x-coordinate of corner m of face n
+        std::vector<double> x[3];
+        /// corner y-coordinates
+        std::vector<double> y[3];
+        /// corner z-coordinates
+        std::vector<double> z[3];
+        /// unit up-normal
+        std::vector<double> nx, ny, nz;
+        /// plane constant, -dot(up-normal, corner 0), as in MillingCutter::facetDrop()
+        std::vector<double> d;
+        /// the xy-component of the normal, normalized in the xy-plane. zero when Z_NORMAL
+        std::vector<double> xynx, xyny;
+        /// for isInside(): with v0=p2-p0 and v1=p1-p0, dot00=v0.v0, dot01=v0.v1, dot11=v1.v1
+        std::vector<double> dot00, dot01, dot11;
+        /// for isInside(): 1/(dot00*dot11-dot01*dot01)
+        std::vector<double> invD;
+        /// bounding-box minimum
+        std::vector<double> minx, miny, minz;
+        /// bounding-box maximum
+        std::vector<double> maxx, maxy, maxz;
+        /// VERTICAL, HORIZONTAL and Z_NORMAL bits
+        std::vector<unsigned char> flags;
+};
+
+/// \brief per-edge data of an IndexedMesh, precomputed for drop-cutter
+class MeshEdgeData {
+    public:
+        /// unit xy-direction from v[0] towards v[1]. zero for vertical edges
+        std::vector<double> ux, uy;
+        /// length in the xy-plane. zero for vertical edges (within tolerance)
+        std::vector<double> len;
+};
+
+/// \brief shared-vertex representation of an STLSurf
+///
+/// An STL-file stores every triangle with its own three corners, so on a closed
+/// mesh each vertex is stored about six times and each edge twice. IndexedMesh
+/// welds corners that are within a tolerance of each other into one vertex, and
+/// lists each edge once. Drop-cutter and push-cutter can then test each vertex
+/// and edge once per query, instead of once for every triangle that uses it.
+///
+/// Faces are in the same order as STLSurf::tris, which is also the input order
+/// of a KDTree<Triangle> built from the surface (see KDTree::getOrder()).
+/// Welding is greedy: a corner is merged into the first vertex found within the
+/// tolerance, and vertices are numbered in order of first appearance.
+///
+/// faceData() and edgeData() hold quantities used by the drop-cutter and push-cutter
+/// kernels (MillingCutter::meshFacetDrop() etc.), computed once when the mesh is built.
+class IndexedMesh {
+    public:
+        /// build the mesh of s, welding corners closer than tolerance
+        IndexedMesh(const STLSurf& s, double tolerance = 1e-6);
+        /// restore the mesh of s, with the vertices, edges and faces of a mesh built earlier 
+        /// from the same triangles with the same tolerance. Only faceData(), edgeData() and the
+        /// faces around each vertex are computed. Used by SurfaceIndexCache.
+        IndexedMesh(const STLSurf& s, double tolerance, const std::vector<Point>& v, 
+                    const std::vector<MeshEdge>& e, const std::vector<MeshFace>& f);
+        virtual ~IndexedMesh() {}
+        /// number of unique vertices
+        unsigned int numVertices() const {return verts.size();}
+        /// number of unique edges
+        unsigned int numEdges() const {return edges.size();}
+        /// number of faces, equal to the number of triangles in the STLSurf
+        unsigned int numFaces() const {return faces.size();}
+        /// vertex n
+        const Point& vertex(unsigned int n) const {return verts[n];}
+        /// edge n
+        const MeshEdge& edge(unsigned int n) const {return edges[n];}
+        /// face n
+        const MeshFace& face(unsigned int n) const {return faces[n];}
+        /// number of faces around vertex v
+        unsigned int numVertexFaces(unsigned int v) const {return vfstart[v+1] - vfstart[v];}
+        /// the faces around vertex v, vertexFaces(v)[0] ... vertexFaces(v)[numVertexFaces(v)-1]
+        const unsigned int* vertexFaces(unsigned int v) const {return &vfaces[ vfstart[v] ];}
+        /// the precomputed per-face data
+        const MeshFaceData& faceData() const {return fdata;}
+        /// the precomputed per-edge data
+        const MeshEdgeData& edgeData() const {return edata;}
+        /// the weld tolerance
+        double getTolerance() const {return tol;}
+        /// string repr
+        std::string str() const;
+    protected:
+        /// find the faces around each vertex, and compute edgeData()
+        void init_adjacency();
+        /// the unique vertices
+        std::vector<Point> verts;
+        /// the unique edges
+        std::vector<MeshEdge> edges;
+        /// the faces
+        std::vector<MeshFace> faces;
+        /// the faces around vertex v are vfaces[ vfstart[v] ] ... vfaces[ vfstart[v+1]-1 ]
+        std::vector<unsigned int> vfstart;
+        /// the faces around each vertex, in order of increasing vertex index
+        std::vector<unsigned int> vfaces;
+        /// per-face data
+        MeshFaceData fdata;
+        /// per-edge data
+        MeshEdgeData edata;
+        /// weld tolerance
+        double tol;
+    private:
+        IndexedMesh() {}
+        IndexedMesh(const IndexedMesh&);
+        IndexedMesh& operator=(const IndexedMesh&);
+};
+
+} // end namespace
+#endif
+// end file indexedmesh.hpp
@@ -47,12 +47,6 @@ Point::Point(double xin, double yin) {
     z=0.0;
 }
 
-Point::Point(const Point &p) {
-    x=p.x;
-    y=p.y;
-    z=p.z;
-}
-
 
 //********     methods ********************** */
 
@@ -221,12 +215,16 @@ bool Point::isRight(const Point &p1, const Point &p2) const
 }
 
 bool Point::isInside(const Triangle &t) const {
+    return isInside( t.p[0], t.p[1], t.p[2] );
+}
+
+bool Point::isInside(const Point& p0, const Point& p1, const Point& p2) const {
     // point in triangle test
     // http://www.blackpawn.com/texts/pointinpoly/default.html
     
-    Point v0 = t.p[2] - t.p[0];
-    Point v1 = t.p[1] - t.p[0];
-    Point v2 = *this  - t.p[0];
+    Point v0 = p2 - p0;
+    Point v1 = p1 - p0;
+    Point v2 = *this  - p0;
     
     double dot00 = v0.dot(v0);
     double dot01 = v0.dot(v1);
@@ -266,15 +264,6 @@ bool Point::isInside(const Point& p1, const Point& p2) const {
  *  http://www.cs.caltech.edu/courses/cs11/material/cpp/donnie/cpp-ops.html
 */
 
-Point& Point::operator=(const Point &p) {
-    if (this == &p)
-        return *this;
-    x=p.x;
-    y=p.y;
-    z=p.z;
-    return *this;
-}
-
 // Point*scalar multiplication
 Point& Point::operator*=(const double &a) {
     x*=a;
@@ -20,6 +20,7 @@
 #ifndef POINT_H
 #define POINT_H
 
+#include <cmath>
 #include <string>
 #include <iostream>
 
@@ -39,10 +40,6 @@ class Point {
         Point(double x, double y, double z);
         /// create a point at (x,y,0)
         Point(double x, double y);
-        /// create a point at p
-        Point(const Point &p);
-        /// destructor. empty.
-        virtual ~Point() {};
         
         /// dot product
         double dot(const Point &p) const;
@@ -101,6 +98,8 @@ class Point {
          
         /// retruns true if Point *this is inside Triangle t 
         bool isInside(const Triangle &t) const; 
+        /// returns true if Point *this is inside the triangle with corners p0, p1, p2
+        bool isInside(const Point& p0, const Point& p1, const Point& p2) const; 
         /// retrun true if Point within line segment p1-p2
         bool isInside(const Point& p1, const Point& p2) const;
             
@@ -112,8 +111,6 @@ class Point {
         /// return true if vector parallel to z-axis
         bool zParallel() const;
         
-        /// assignment
-        Point &operator=(const Point &p);
         /// addition
         Point &operator+=(const Point &p);
         /// subtraction
@@ -19,13 +19,21 @@
 //  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include <fstream>  // required by read_from_file()
-#include <sstream>
 #include <cstring>
+#include <cmath>
 #include <list>
+#include <vector>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 #include "stlreader.hpp"
 #include "stlsurf.hpp"
+#include "mappedfile.hpp"
 
 namespace ocl
 {
@@ -54,104 +62,212 @@ namespace ocl
 
     void STLReader::read_from_file(const wchar_t* filepath, STLSurf& surface) {
         // read the stl file
-        std::ifstream ifs(Ttc(filepath), ios::binary);
-        if(!ifs)return;
-
-        char solid_string[6] = "aaaaa";
-        ifs.read(solid_string, 5);
-        if(ifs.eof())return;
-        if(strcmp(solid_string, "solid"))
-        {
-            // try binary file read
-
-            // read the header
-            char header[81];
-            header[80] = 0;
-            memcpy(header, solid_string, 5);
-            ifs.read(&header[5], 75);
-
-            unsigned int num_facets = 0;
-            ifs.read((char*)(&num_facets), 4);
-
-            for(unsigned int i = 0; i<num_facets; i++)
-            {
-                float n[3];
+        MappedFile f( Ttc(filepath) );
+        if ( !f.isOpen() || f.size() < 5 )
+            return;
+        if ( is_binary(f.data(), f.size()) )
+            read_binary(f.data(), f.size(), surface);
+        else
+            read_ascii(f.data(), f.size(), surface);
+    }
+
+    bool STLReader::is_binary(const char* data, std::size_t size) {
+        // binary files have an 80-byte header and a facet count, followed by 50 bytes per facet.
+        // Some binary files start their header with "solid", so check the size first.
+        if (size >= 84) {
+            unsigned int num_facets;
+            memcpy(&num_facets, data+80, 4);
+            if ( (size-84)/50 == num_facets && (size-84)%50 == 0 )
+                return true;
+        }
+        return strncmp(data, "solid", 5) != 0;
+    }
+
+    void STLReader::read_binary(const char* data, std::size_t size, STLSurf& surface) {
+        if (size < 84)
+            return;
+        unsigned int num_facets;
+        memcpy(&num_facets, data+80, 4);
+        if ( num_facets > (size-84)/50 ) // truncated file, read the complete facets
+            num_facets = (size-84)/50;
+        
+        // each thread decodes a contiguous range of facets into its own list, 
+        // the lists are then spliced together in file order.
+        int nparts = 1;
+#ifdef _OPENMP
+        if (num_facets > 10000) // not worth it for small files
+            nparts = omp_get_max_threads();
+#endif
+        std::vector< std::list<Triangle> > parts(nparts);
+        std::vector<Bbox> boxes(nparts);
+        #pragma omp parallel for schedule(static,1)
+        for (int m=0; m<nparts; ++m) {
+            unsigned int first = (unsigned int)( ((double)num_facets*m)/nparts );
+            unsigned int last  = (unsigned int)( ((double)num_facets*(m+1))/nparts );
+            for (unsigned int i=first; i<last; ++i) {
+                // a facet is: float normal[3], float vertex[3][3], short attribute
                 float x[3][3];
-                ifs.read((char*)(n), 12);
-                ifs.read((char*)(x[0]), 36);
-                short attr;
-                ifs.read((char*)(&attr), 2);
-                surface.addTriangle(Triangle(Point(x[0][0], x[0][1], x[0][2]), 
-                    Point(x[1][0], x[1][1], x[1][2]), 
-                    Point(x[2][0], x[2][1], x[2][2])));
+                memcpy(x, data + 84 + 50*(std::size_t)i + 12, 36);
+                parts[m].push_back( Triangle( Point(x[0][0], x[0][1], x[0][2]), 
+                                              Point(x[1][0], x[1][1], x[1][2]), 
+                                              Point(x[2][0], x[2][1], x[2][2]) ) );
+                boxes[m].addTriangle( parts[m].back() );
             }
         }
-        else
-        {
-            // "solid" already found
-            char str[1024] = "solid";
-            ifs.getline(&str[5], 1024);
-            //char title[1024];
-            //if(sscanf(str, "solid %s", title) == 1)
-            //m_title.assign(Ctt(title));
-
-            float n[3];
-            float x[3][3];
-            char five_chars[6] = "aaaaa";
-
-            int vertex = 0;
-
-            while(!ifs.eof())
-            {
-                ifs.getline(str, 1024);
-
-                int i = 0, j = 0;
-                for(; i<5; i++, j++)
-                {
-                    if(str[j] == 0)break;
-                    while(str[j] == ' ' || str[j] == '\t')j++;
-                    five_chars[i] = str[j];
+        add_parts(parts, boxes, surface);
+    }
+
+    /// true if the n characters at p, before end, are keyword
+    static bool starts_with(const char* p, const char* end, const char* keyword, std::size_t n) {
+        return (std::size_t)(end-p) >= n && strncmp(p, keyword, n) == 0;
+    }
+
+    /// powers of ten that are exact in a double
+    static const double exact_pow10[23] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    /// parse a number like "-1.5e+03" at p, before end, into v.
+    /// Returns a pointer past the number, or p if there is no number.
+    /// Unlike strtod() and istream this does not depend on the locale.
+    static const char* parse_float(const char* p, const char* end, float& v) {
+        const char* start = p;
+        bool negative = false;
+        if ( p<end && (*p == '-' || *p == '+') ) {
+            negative = (*p == '-');
+            ++p;
+        }
+        // up to 19 significant digits in an integer mantissa, the rest only change the exponent
+        boost::uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool found = false;
+        for ( ; p<end && *p >= '0' && *p <= '9'; ++p) {
+            found = true;
+            if (digits < 19) {
+                mantissa = 10*mantissa + (*p-'0');
+                if (mantissa)
+                    ++digits;
+            } else {
+                ++exponent;
+            }
+        }
+        if ( p<end && *p == '.' ) {
+            for (++p ; p<end && *p >= '0' && *p <= '9'; ++p) {
+                found = true;
+                if (digits < 19) {
+                    mantissa = 10*mantissa + (*p-'0');
+                    if (mantissa)
+                        ++digits;
+                    --exponent;
                 }
-                if(i == 5)
-                {
-                    if(!strcmp(five_chars, "verte"))
-                    {
-#ifdef WIN32
-                        sscanf(str, " vertex %f %f %f", &(x[vertex][0]), &(x[vertex][1]), &(x[vertex][2]));
-#else
-                        std::istringstream ss(str);
-                        ss.imbue(std::locale("C"));
-                        while(ss.peek() == ' ') ss.seekg(1, ios_base::cur);
-                        ss.seekg(std::string("vertex").size(), ios_base::cur);
-                        ss >> x[vertex][0] >> x[vertex][1] >> x[vertex][2];
-#endif
-                        vertex++;
-                        if(vertex > 2)vertex = 2;
-                    }
-                    else if(!strcmp(five_chars, "facet"))
-                    {
-#ifdef WIN32
-                        sscanf(str, " facet normal %f %f %f", &(n[0]), &(n[1]), &(n[2]));
-#else
-                        std::istringstream ss(str);
-                        ss.imbue(std::locale("C"));
-                        while(ss.peek() == ' ') ss.seekg(1, ios_base::cur);
-                        ss.seekg(std::string("facet normal").size(), ios_base::cur);
-                        ss >> n[0] >> n[1] >> n[2];
+            }
+        }
+        if (!found)
+            return start;
+        if ( p<end && (*p == 'e' || *p == 'E') ) {
+            const char* e = p+1;
+            bool eneg = false;
+            if ( e<end && (*e == '-' || *e == '+') ) {
+                eneg = (*e == '-');
+                ++e;
+            }
+            if ( e<end && *e >= '0' && *e <= '9' ) {
+                int ev = 0;
+                for ( ; e<end && *e >= '0' && *e <= '9'; ++e)
+                    if (ev < 10000)
+                        ev = 10*ev + (*e-'0');
+                exponent += eneg ? -ev : ev;
+                p = e;
+            }
+        }
+        double d = (double)mantissa;
+        if (exponent < 0 && exponent >= -22)
+            d /= exact_pow10[-exponent];
+        else if (exponent > 0 && exponent <= 22)
+            d *= exact_pow10[exponent];
+        else if (exponent != 0)
+            d *= pow(10.0, exponent);
+        v = (float)(negative ? -d : d);
+        return p;
+    }
+
+    /// parse the facets in the ASCII text [p, end) into tris, and grow bb.
+    static void parse_ascii_facets(const char* p, const char* end, std::list<Triangle>& tris, Bbox& bb) {
+        float x[3][3] = { {0,0,0}, {0,0,0}, {0,0,0} };
+        int vertex = 0;
+        while (p < end) {
+            while ( p<end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') )
+                ++p;
+            if ( starts_with(p, end, "vertex", 6) ) {
+                p += 6;
+                float* xv = x[ std::min(vertex, 2) ]; // like the old reader, extra vertices overwrite the third
+                for (int m=0; m<3; ++m) {
+                    while ( p<end && (*p == ' ' || *p == '\t') )
+                        ++p;
+                    p = parse_float(p, end, xv[m]);
+                }
+                ++vertex;
+            } else if ( starts_with(p, end, "facet", 5) ) {
+                vertex = 0;
+            } else if ( starts_with(p, end, "endfacet", 8) ) {
+                if (vertex >= 3) {
+                    tris.push_back( Triangle( Point(x[0][0], x[0][1], x[0][2]), 
+                                              Point(x[1][0], x[1][1], x[1][2]), 
+                                              Point(x[2][0], x[2][1], x[2][2]) ) );
+                    bb.addTriangle( tris.back() );
+                }
+                vertex = 0;
+            }
+            // skip to the next line
+            while ( p<end && *p != '\n' )
+                ++p;
+        }
+    }
+
+    void STLReader::read_ascii(const char* data, std::size_t size, STLSurf& surface) {
+        // split the file into parts that end just after an "endfacet" line, and parse them in parallel.
+        int nparts = 1;
+#ifdef _OPENMP
+        if (size > 1000000) // not worth it for small files
+            nparts = omp_get_max_threads();
 #endif
-                        vertex = 0;
-                    }
-                    else if(!strcmp(five_chars, "endfa"))
-                    {
-                        if(vertex == 2)
-                        {
-                            surface.addTriangle(Triangle(Point(x[0][0], x[0][1], x[0][2]), 
-                                Point(x[1][0], x[1][1], x[1][2]), 
-                                Point(x[2][0], x[2][1], x[2][2])));
-                        }
-                    }
+        const char* end = data+size;
+        std::vector<const char*> bounds(nparts+1);
+        bounds[0] = data;
+        bounds[nparts] = end;
+        for (int m=1; m<nparts; ++m) {
+            const char* p = data + (std::size_t)( ((double)size*m)/nparts );
+            if (p < bounds[m-1])
+                p = bounds[m-1];
+            const char* found = end;
+            for ( ; p+8 <= end; ++p) {
+                if ( *p == 'e' && strncmp(p, "endfacet", 8) == 0 ) {
+                    found = p;
+                    break;
                 }
             }
+            while ( found<end && *found != '\n' )
+                ++found;
+            bounds[m] = found;
+        }
+        std::vector< std::list<Triangle> > parts(nparts);
+        std::vector<Bbox> boxes(nparts);
+        #pragma omp parallel for schedule(static,1)
+        for (int m=0; m<nparts; ++m) {
+            parse_ascii_facets( bounds[m], bounds[m+1], parts[m], boxes[m] );
+        }
+        add_parts(parts, boxes, surface);
+    }
+
+    void STLReader::add_parts(std::vector< std::list<Triangle> >& parts, const std::vector<Bbox>& boxes, STLSurf& surface) {
+        for (unsigned int m=0; m<parts.size(); ++m) {
+            if ( parts[m].empty() )
+                continue;
+            surface.bb.addPoint( boxes[m].minpt );
+            surface.bb.addPoint( boxes[m].maxpt );
+            surface.tris.splice( surface.tris.end(), parts[m] );
         }
     }
 
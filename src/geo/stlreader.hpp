@@ -20,6 +20,14 @@
 #ifndef STLREADER_H
 #define STLREADER_H
 
+#include <cstddef>
+#include <string>
+#include <list>
+#include <vector>
+
+#include "triangle.hpp"
+#include "bbox.hpp"
+
 namespace ocl
 {
     
@@ -40,6 +48,15 @@ class STLReader {
     private:
         /// read STL-surface from file
         void read_from_file(const wchar_t* filepath, STLSurf& surface);
+        /// true if the size bytes at data are a binary STL-file
+        bool is_binary(const char* data, std::size_t size);
+        /// read a binary STL-file of size bytes at data. Facets are decoded in parallel.
+        void read_binary(const char* data, std::size_t size, STLSurf& surface);
+        /// read an ASCII STL-file of size bytes at data. The text is split at "endfacet" 
+        /// lines into parts that are parsed in parallel.
+        void read_ascii(const char* data, std::size_t size, STLSurf& surface);
+        /// add the triangles in parts, in order, and their bounding-boxes to surface
+        void add_parts(std::vector< std::list<Triangle> >& parts, const std::vector<Bbox>& boxes, STLSurf& surface);
 };
 
 }
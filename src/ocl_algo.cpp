@@ -26,8 +26,12 @@
 //#include "weave_py.h"           
 #include "waterline_py.hpp"      
 #include "adaptivewaterline_py.hpp"  
+#include "multiwaterline_py.hpp"
 #include "lineclfilter_py.hpp"    
 #include "numeric.hpp"
+#include "surfaceindex.hpp"
+#include "surfaceindexcache.hpp"
+#include "stlsurf.hpp"
 
 #include "zigzag.hpp"
 #ifndef WIN32
@@ -59,11 +63,22 @@ void export_algo() {
         .def("__str__", &ZigZag::str)
     ;
 
+    bp::class_<SurfaceIndex, boost::shared_ptr<SurfaceIndex>, boost::noncopyable>("SurfaceIndex", 
+            bp::init<const STLSurf&, bp::optional<unsigned int> >()[bp::with_custodian_and_ward<1,2>()] )
+        .def("build", &SurfaceIndex::build)
+        .def("getBucketSize", &SurfaceIndex::getBucketSize)
+        .def("__str__", &SurfaceIndex::str)
+    ;
+    bp::class_<SurfaceIndexCache>("SurfaceIndexCache", bp::init<std::string>())
+        .def("load", &SurfaceIndexCache::load, bp::with_custodian_and_ward_postcall<0,3>() )
+        .def("wasHit", &SurfaceIndexCache::wasHit)
+    ;
     bp::class_<BatchPushCutter>("BatchPushCutter_base")
     ;
     bp::class_<BatchPushCutter_py, bp::bases<BatchPushCutter> >("BatchPushCutter")
         .def("run", &BatchPushCutter_py::run)
         .def("setSTL", &BatchPushCutter_py::setSTL)
+        .def("setSurfaceIndex", &BatchPushCutter_py::setSurfaceIndex)
         .def("setCutter", &BatchPushCutter_py::setCutter)
         .def("setThreads", &BatchPushCutter_py::setThreads)
         .def("appendFiber", &BatchPushCutter_py::appendFiber)
@@ -106,6 +121,7 @@ void export_algo() {
     bp::class_<Waterline_py, bp::bases<Waterline> >("Waterline")
         .def("setCutter", &Waterline_py::setCutter)
         .def("setSTL", &Waterline_py::setSTL)
+        .def("setSurfaceIndex", &Waterline_py::setSurfaceIndex)
         .def("setZ", &Waterline_py::setZ)
         .def("setSampling", &Waterline_py::setSampling)
         .def("run", &Waterline_py::run)
@@ -121,6 +137,7 @@ void export_algo() {
     bp::class_<AdaptiveWaterline_py, bp::bases<AdaptiveWaterline> >("AdaptiveWaterline")
         .def("setCutter", &AdaptiveWaterline_py::setCutter)
         .def("setSTL", &AdaptiveWaterline_py::setSTL)
+        .def("setSurfaceIndex", &AdaptiveWaterline_py::setSurfaceIndex)
         .def("setZ", &AdaptiveWaterline_py::setZ)
         .def("setSampling", &AdaptiveWaterline_py::setSampling)
         .def("setMinSampling", &AdaptiveWaterline_py::setMinSampling)
@@ -131,6 +148,26 @@ void export_algo() {
         .def("getXFibers", &AdaptiveWaterline_py::getXFibers)
         .def("getYFibers", &AdaptiveWaterline_py::getYFibers)
     ;
+    bp::class_<MultiWaterline>("MultiWaterline_base")
+    ;
+    bp::class_<MultiWaterline_py, bp::bases<MultiWaterline> >("MultiWaterline")
+        .def("setCutter", &MultiWaterline_py::setCutter)
+        .def("setSTL", &MultiWaterline_py::setSTL)
+        .def("setSurfaceIndex", &MultiWaterline_py::setSurfaceIndex)
+        .def("setZ", &MultiWaterline_py::py_setZ)
+        .def("setSampling", &MultiWaterline_py::setSampling)
+        .def("setBatchSize", &MultiWaterline_py::setBatchSize)
+        .def("setSlabHeight", &MultiWaterline_py::setSlabHeight)
+        .def("setLengthLimit", &MultiWaterline_py::setLengthLimit)
+        .def("setCallback", &MultiWaterline_py::setCallback)
+        .def("run", &MultiWaterline_py::run)
+        .def("numLevels", &MultiWaterline_py::numLevels)
+        .def("getZ", &MultiWaterline_py::getZ)
+        .def("isDone", &MultiWaterline_py::isDone)
+        .def("getLoops", &MultiWaterline_py::py_getLoops)
+        .def("setThreads", &MultiWaterline_py::setThreads)
+        .def("getThreads", &MultiWaterline_py::getThreads)
+    ;
     /*
     bp::class_<Weave>("Weave_base")
     ;
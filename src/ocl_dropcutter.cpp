@@ -23,6 +23,8 @@
 #include "batchdropcutter_py.hpp" 
 #include "pathdropcutter_py.hpp"  
 #include "adaptivepathdropcutter_py.hpp"  
+#include "rasterdropcutter_py.hpp"
+#include "heightmapdropcutter_py.hpp"
 
 
 /*
@@ -41,14 +43,25 @@ void export_dropcutter() {
         .def("run", &BatchDropCutter_py::run)
         .def("getCLPoints", &BatchDropCutter_py::getCLPoints_py)
         .def("setSTL", &BatchDropCutter_py::setSTL)
+        .def("setSurfaceIndex", &BatchDropCutter_py::setSurfaceIndex)
         .def("setCutter", &BatchDropCutter_py::setCutter)
         .def("setThreads", &BatchDropCutter_py::setThreads)
         .def("getThreads", &BatchDropCutter_py::getThreads)
         .def("appendPoint", &BatchDropCutter_py::appendPoint)
+        .def("appendPoints", &BatchDropCutter_py::appendPoints)
+        .def("appendPoints", &BatchDropCutter_py::appendPointsXY)
+        .def("clearCLPoints", &BatchDropCutter_py::clearCLPoints)
+        .def("getCLArray", &BatchDropCutter_py::getCLArray)
+        .def("getCCArray", &BatchDropCutter_py::getCCArray)
+        .def("getCCTypes", &BatchDropCutter_py::getCCTypes)
         .def("getTrianglesUnderCutter", &BatchDropCutter_py::getTrianglesUnderCutter)
         .def("getCalls", &BatchDropCutter_py::getCalls)
+        .def("getPruned", &BatchDropCutter_py::getPruned)
         .def("getBucketSize", &BatchDropCutter_py::getBucketSize)
         .def("setBucketSize", &BatchDropCutter_py::setBucketSize)
+        .def("setMortonOrder", &BatchDropCutter_py::setMortonOrder)
+        .def("setPacketSize", &BatchDropCutter_py::setPacketSize)
+        .def("setWarmStart", &BatchDropCutter_py::setWarmStart)
     ;
 
 
@@ -59,8 +72,10 @@ void export_dropcutter() {
         .def("getCLPoints", &PathDropCutter_py::getCLPoints_py)
         .def("setCutter", &PathDropCutter_py::setCutter)
         .def("setSTL", &PathDropCutter_py::setSTL)
+        .def("setSurfaceIndex", &PathDropCutter_py::setSurfaceIndex)
         .def("setSampling", &PathDropCutter_py::setSampling)
         .def("setPath", &PathDropCutter_py::setPath)
+        .def("setWarmStart", &PathDropCutter_py::setWarmStart)
         .def("getZ", &PathDropCutter_py::getZ)
         .def("setZ", &PathDropCutter_py::setZ)
     ;
@@ -71,6 +86,7 @@ void export_dropcutter() {
         .def("getCLPoints", &AdaptivePathDropCutter_py::getCLPoints_py)
         .def("setCutter", &AdaptivePathDropCutter_py::setCutter)
         .def("setSTL", &AdaptivePathDropCutter_py::setSTL)
+        .def("setSurfaceIndex", &AdaptivePathDropCutter_py::setSurfaceIndex)
         .def("setSampling", &AdaptivePathDropCutter_py::setSampling)
         .def("setMinSampling", &AdaptivePathDropCutter_py::setMinSampling)
         .def("setCosLimit", &AdaptivePathDropCutter_py::setCosLimit)
@@ -79,6 +95,45 @@ void export_dropcutter() {
         .def("getZ", &AdaptivePathDropCutter_py::getZ)
         .def("setZ", &AdaptivePathDropCutter_py::setZ)
     ;
+    bp::class_<RasterDropCutter>("RasterDropCutter_base")
+    ;
+    bp::class_<RasterDropCutter_py , bp::bases<RasterDropCutter> >("RasterDropCutter")
+        .def("run", &RasterDropCutter_py::run)
+        .def("getCLPoints", &RasterDropCutter_py::getCLPoints_py)
+        .def("setCutter", &RasterDropCutter_py::setCutter)
+        .def("setSTL", &RasterDropCutter_py::setSTL)
+        .def("setSurfaceIndex", &RasterDropCutter_py::setSurfaceIndex)
+        .def("setSampling", &RasterDropCutter_py::setSampling)
+        .def("getSampling", &RasterDropCutter_py::getSampling)
+        .def("setRaster", &RasterDropCutter_py::setRaster)
+        .def("setZigZag", &RasterDropCutter_py::setZigZag)
+        .def("getZ", &RasterDropCutter_py::getZ)
+        .def("setZ", &RasterDropCutter_py::setZ)
+        .def("setThreads", &RasterDropCutter_py::setThreads)
+        .def("getThreads", &RasterDropCutter_py::getThreads)
+        .def("getLines", &RasterDropCutter_py::getLines)
+        .def("getLinePoints", &RasterDropCutter_py::getLinePoints)
+        .def("getCalls", &RasterDropCutter_py::getCalls)
+        .def("getPruned", &RasterDropCutter_py::getPruned)
+    ;
+    bp::class_<HeightMapDropCutter>("HeightMapDropCutter_base")
+    ;
+    bp::class_<HeightMapDropCutter_py , bp::bases<HeightMapDropCutter> >("HeightMapDropCutter")
+        .def("run", &HeightMapDropCutter_py::run)
+        .def("getCLPoints", &HeightMapDropCutter_py::getCLPoints_py)
+        .def("getHeights", &HeightMapDropCutter_py::getHeights_py)
+        .def("getHeight", &HeightMapDropCutter_py::getHeight)
+        .def("setCutter", &HeightMapDropCutter_py::setCutter)
+        .def("setSTL", &HeightMapDropCutter_py::setSTL)
+        .def("setSurfaceIndex", &HeightMapDropCutter_py::setSurfaceIndex)
+        .def("setGrid", &HeightMapDropCutter_py::setGrid)
+        .def("setTolerance", &HeightMapDropCutter_py::setTolerance)
+        .def("getExactDrops", &HeightMapDropCutter_py::getExactDrops)
+        .def("getZ", &HeightMapDropCutter_py::getZ)
+        .def("setZ", &HeightMapDropCutter_py::setZ)
+        .def("setThreads", &HeightMapDropCutter_py::setThreads)
+        .def("getThreads", &HeightMapDropCutter_py::getThreads)
+    ;
 
 
 }
@@ -30,6 +30,7 @@
 #include "bbox.hpp"               // no python
 #include "path_py.hpp"            // new-style wrapper
 #include "stlreader.hpp"          // no python
+#include "indexedmesh.hpp"        // no python
 
 /*
  *  Python wrapping
@@ -131,6 +132,13 @@ void export_geometry() {
     bp::class_<STLReader>("STLReader")
         .def(bp::init<const std::wstring&, STLSurf&>())
     ;
+    bp::class_<IndexedMesh, boost::noncopyable>("IndexedMesh", bp::init<const STLSurf&, bp::optional<double> >())
+        .def("numVertices", &IndexedMesh::numVertices)
+        .def("numEdges", &IndexedMesh::numEdges)
+        .def("numFaces", &IndexedMesh::numFaces)
+        .def("getTolerance", &IndexedMesh::getTolerance)
+        .def("__str__", &IndexedMesh::str)
+    ;
     bp::class_<Bbox>("Bbox")
         .def("isInside", &Bbox::isInside )
         .def_readonly("maxpt", &Bbox::maxpt)
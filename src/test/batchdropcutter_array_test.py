@@ -0,0 +1,71 @@
+# checks the array input and output of BatchDropCutter, under Python 2 and 3
+# usage: python batchdropcutter_array_test.py <directory of ocl.so>
+
+import sys
+import struct
+
+sys.path.insert(0, sys.argv[1])
+import ocl
+
+def rows(view):
+    """ the rows of a 2-D float64 memoryview, as tuples """
+    n, cols = view.shape
+    values = struct.unpack( "%dd" % (n*cols), view.tobytes() )
+    return [ values[m*cols:(m+1)*cols] for m in range(n) ]
+
+def check(ok, msg):
+    if not ok:
+        print("ERROR: " + msg)
+        sys.exit(1)
+
+s = ocl.STLSurf()
+s.addTriangle( ocl.Triangle( ocl.Point(0,0,0), ocl.Point(10,0,1), ocl.Point(0,10,2) ) )
+s.addTriangle( ocl.Triangle( ocl.Point(10,0,1), ocl.Point(10,10,3), ocl.Point(0,10,2) ) )
+cutter = ocl.BallCutter(2.0, 10)
+bdc = ocl.BatchDropCutter()
+bdc.setSTL(s)
+bdc.setCutter(cutter)
+
+empty = bdc.getCLArray()
+check( empty.shape == (0, 3), "shape of the empty array is %s" % (empty.shape,) )
+del empty
+
+for i in range(11):
+    for j in range(11):
+        bdc.appendPoint( ocl.CLPoint(i, j, -5) )
+cl = bdc.getCLArray()
+cc = bdc.getCCArray()
+types = bdc.getCCTypes()
+check( cl.shape == (121, 3) and cc.shape == (121, 3) and types.shape == (121,), "wrong shapes" )
+check( cl.format == "d" and types.format == "i" and cl.readonly, "wrong format or not read-only" )
+
+# the views share the CL-points, so they show the results of run()
+bdc.run()
+pts = bdc.getCLPoints()
+for p, (x, y, z) in zip( pts, rows(cl) ):
+    check( (p.x, p.y, p.z) == (x, y, z), "CL-point %s, array (%f, %f, %f)" % (p, x, y, z) )
+check( min( z for (x, y, z) in rows(cl) ) > -5, "the array does not show the results of run()" )
+for p, (x, y, z) in zip( pts, rows(cc) ):
+    c = p.getCC()
+    check( (c.x, c.y, c.z) == (x, y, z), "CC-point %s, array (%f, %f, %f)" % (c, x, y, z) )
+codes = struct.unpack( "%di" % len(pts), types.tobytes() )
+check( list(codes) == [ int(p.getCC().type) for p in pts ], "CC-types differ" )
+
+# the CL-points can't be moved while they are exported
+try:
+    bdc.appendPoint( ocl.CLPoint(0, 0, -5) )
+    check( False, "appendPoint() with exported CL-points" )
+except BufferError:
+    pass
+try:
+    bdc.clearCLPoints()
+    check( False, "clearCLPoints() with exported CL-points" )
+except BufferError:
+    pass
+check( cl.shape == (121, 3) and len( bdc.getCLPoints() ) == 121, "the CL-points were cleared" )
+del cl, cc, types
+bdc.appendPoint( ocl.CLPoint(0, 0, -5) )
+check( bdc.getCLArray().shape == (122, 3), "appendPoint() after the arrays are deleted" )
+bdc.clearCLPoints()
+check( bdc.getCLArray().shape == (0, 3), "clearCLPoints() after the arrays are deleted" )
+print("all arrays agree.")
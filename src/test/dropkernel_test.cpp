@@ -0,0 +1,110 @@
+/*  $Id$
+ * 
+ *  Copyright 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com)
+ *  
+ *  This file is part of OpenCAMlib.
+ *
+ *  OpenCAMlib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenCAMlib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenCAMlib.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// checks that the AVX2 DropKernel gives the same CL-points as the scalar one,
+// and the same heights as MillingCutter::dropCutterSTL()
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "point.hpp"
+#include "triangle.hpp"
+#include "stlsurf.hpp"
+#include "clpoint.hpp"
+#include "cylcutter.hpp"
+#include "ballcutter.hpp"
+#include "bullcutter.hpp"
+#include "surfaceindex.hpp"
+#include "meshquery.hpp"
+#include "dropkernel.hpp"
+
+using namespace ocl;
+
+/// a wavy n*n grid of quads, two triangles each, with some vertical and horizontal faces
+void wavySurface(STLSurf& s, int n) {
+    std::vector<Point> p;
+    for (int i=0; i<=n; ++i) {
+        for (int j=0; j<=n; ++j) {
+            double z = sin(0.7*i) * cos(0.4*j);
+            if ( i > n/2 && j > n/2 ) 
+                z = 1.5; // a flat plateau, with vertical faces at its edge
+            p.push_back( Point(i, j, z) );
+        }
+    }
+    for (int i=0; i<n; ++i) {
+        for (int j=0; j<n; ++j) {
+            const Point& a = p[ i*(n+1) + j ];
+            const Point& b = p[ (i+1)*(n+1) + j ];
+            const Point& c = p[ (i+1)*(n+1) + j+1 ];
+            const Point& d = p[ i*(n+1) + j+1 ];
+            s.addTriangle( Triangle(a, b, c) );
+            s.addTriangle( Triangle(a, c, d) );
+        }
+    }
+}
+
+/// true if a and b have the same z and cc-point
+bool same(const CLPoint& a, const CLPoint& b) {
+    return (a.z == b.z) && (a.cc == b.cc) && (a.cc.type == b.cc.type);
+}
+
+/// drop cutter c at the grid with the scalar and the AVX2 kernel, and return the number of errors
+int check(const SurfaceIndex& index, const MillingCutter* c, const std::vector<CLPoint>& grid) {
+    DropKernel ks( c, false );
+    DropKernel kv( c, true );
+    MeshQuery query( index.mesh() );
+    int errors = 0;
+    for (unsigned int n=0; n<grid.size(); ++n) {
+        CLPoint scalar( grid[n] ), simd( grid[n] ), brute( grid[n] );
+        query.dropCutter( index.xyTree(), ks, scalar );
+        query.dropCutter( index.xyTree(), kv, simd );
+        c->dropCutterSTL( brute, index.getSTL() );
+        if ( !same(scalar, simd) || fabs( brute.z - simd.z ) > 1e-9 ) {
+            if (errors < 10)
+                std::cout << "ERROR: " << c->str() << " scalar " << scalar.str() << " AVX2 " << simd.str() 
+                          << " brute-force " << brute.str() << "\n";
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int main() {
+    STLSurf s;
+    wavySurface(s, 20);
+    SurfaceIndex index(s);
+    std::cout << "dropkernel_test: " << s.size() << " triangles, AVX2 " 
+              << (DropKernel::hasAVX2() ? "available" : "not available, only the scalar kernel is checked") << "\n";
+    std::vector<CLPoint> grid;
+    for (int i=0; i<=40; ++i)
+        for (int j=0; j<=40; ++j)
+            grid.push_back( CLPoint(-1.0 + 0.55*i, -1.0 + 0.55*j, -5.0) );
+    CylCutter cyl(1.3, 10);
+    BallCutter ball(1.3, 10);
+    BullCutter bull(1.3, 0.3, 10);
+    int errors = check(index, &cyl, grid) + check(index, &ball, grid) + check(index, &bull, grid);
+    if (errors) {
+        std::cout << "ERROR: " << errors << " points differ!\n";
+        return 1;
+    }
+    std::cout << "all points agree.\n";
+    return 0;
+}
@@ -0,0 +1,59 @@
+# checks that MultiWaterline gives the same loops as Waterline for a cutter shorter than the part is tall
+# usage: python multiwaterline_test.py <directory of ocl.so>
+
+import sys
+
+sys.path.insert(0, sys.argv[1])
+import ocl
+
+def check(ok, msg):
+    if not ok:
+        print("ERROR: " + msg)
+        sys.exit(1)
+
+def rounded(loops):
+    return [ [ (round(p.x, 6), round(p.y, 6), round(p.z, 6)) for p in loop ] for loop in loops ]
+
+# a low tent, and a triangular plate that overhangs it 5 units higher up. The plate is one triangle, without
+# an interior edge, where Waterline, which pushes each triangle, may graze the shared edge twice
+s = ocl.STLSurf()
+s.addTriangle( ocl.Triangle( ocl.Point(0,0,0), ocl.Point(4,0,0), ocl.Point(2,2,1) ) )
+s.addTriangle( ocl.Triangle( ocl.Point(4,0,0), ocl.Point(4,4,0), ocl.Point(2,2,1) ) )
+s.addTriangle( ocl.Triangle( ocl.Point(4,4,0), ocl.Point(0,4,0), ocl.Point(2,2,1) ) )
+s.addTriangle( ocl.Triangle( ocl.Point(0,4,0), ocl.Point(0,0,0), ocl.Point(2,2,1) ) )
+s.addTriangle( ocl.Triangle( ocl.Point(-3.93,-3.11,6), ocl.Point(9.07,-2.87,6), ocl.Point(1.89,9.13,6) ) )
+cutter = ocl.CylCutter(1.0, 2.0) # much shorter than the 6 units from the tent to the plate
+zh = [0.2, 0.5, 3.0, 5.5]
+sampling = 0.25
+
+mwl = ocl.MultiWaterline()
+mwl.setSTL(s)
+mwl.setCutter(cutter)
+mwl.setZ(zh)
+mwl.setSampling(sampling)
+mwl.setSlabHeight(1.0)
+mwl.run()
+limited = ocl.MultiWaterline()
+limited.setSTL(s)
+limited.setCutter(cutter)
+limited.setZ(zh)
+limited.setSampling(sampling)
+limited.setSlabHeight(1.0)
+limited.setLengthLimit(True)
+limited.run()
+
+differ = 0
+for n in range(len(zh)):
+    wl = ocl.Waterline()
+    wl.setSTL(s)
+    wl.setCutter(cutter)
+    wl.setZ(zh[n])
+    wl.setSampling(sampling)
+    wl.run()
+    loops = rounded( wl.getLoops() )
+    check( len(loops) > 0, "Waterline has no loops at z=%r" % zh[n] )
+    check( rounded( mwl.getLoops(n) ) == loops, "MultiWaterline and Waterline differ at z=%r" % zh[n] )
+    if rounded( limited.getLoops(n) ) != loops:
+        differ += 1
+check( differ > 0, "the length limit does not change the loops, the test part is too low" )
+print("MultiWaterline agrees with Waterline.")
@@ -0,0 +1,59 @@
+# checks that a surface with a degenerate triangle is served from the SurfaceIndexCache
+# usage: python surfaceindexcache_test.py <directory of ocl.so>
+
+import sys
+import os
+import shutil
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import ocl
+
+def check(ok, msg):
+    if not ok:
+        print("ERROR: " + msg)
+        sys.exit(1)
+
+# two triangles of a square, and a sliver whose first two corners are welded into one vertex
+triangles = [ [(0,0,0), (10,0,0), (0,10,1)],
+              [(10,0,0), (10,10,1), (0,10,1)],
+              [(10,0,0), (10,0,1e-8), (5,-3,0.5)] ]
+
+def drop(idx):
+    """ z of a grid of CL-points dropped with a BallCutter """
+    cutter = ocl.BallCutter(2.0, 10)
+    bdc = ocl.BatchDropCutter()
+    bdc.setSurfaceIndex(idx)
+    bdc.setCutter(cutter)
+    for i in range(13):
+        for j in range(13):
+            bdc.appendPoint( ocl.CLPoint(i-1, j-3, -5) )
+    bdc.run()
+    return [ p.z for p in bdc.getCLPoints() ]
+
+tmp = tempfile.mkdtemp()
+try:
+    fname = os.path.join(tmp, "sliver.stl")
+    f = open(fname, "w")
+    f.write("solid sliver\n")
+    for t in triangles:
+        f.write("facet normal 0 0 1\nouter loop\n")
+        for p in t:
+            f.write("vertex %r %r %r\n" % p)
+        f.write("endloop\nendfacet\n")
+    f.write("endsolid sliver\n")
+    f.close()
+    
+    cache = ocl.SurfaceIndexCache(tmp)
+    s1 = ocl.STLSurf()
+    idx1 = cache.load(fname, s1, 1)
+    check( not cache.wasHit(), "the first load() is a hit" )
+    check( "3 faces" in str(idx1), "the mesh was not built: %s" % idx1 )
+    s2 = ocl.STLSurf()
+    idx2 = cache.load(fname, s2, 1)
+    check( cache.wasHit(), "the second load() is not a hit" )
+    check( str(idx1) == str(idx2), "%s is restored as %s" % (idx1, idx2) )
+    check( drop(idx1) == drop(idx2), "drop-cutter differs after a cache hit" )
+finally:
+    shutil.rmtree(tmp)
+print("cache hit with a degenerate triangle.")
@@ -22,8 +22,6 @@
 
 #include <vector>
 
-#include <boost/graph/adjacency_list.hpp>
-
 #include "point.hpp"
 #include "halfedgediagram.hpp"
 
@@ -157,10 +155,7 @@ struct VertexProps {
     static int count;
 };
 
-typedef boost::adjacency_list_traits<boost::listS, 
-                                     boost::listS, 
-                                     boost::bidirectionalS, 
-                                     boost::listS >::edge_descriptor HEEdge;
+typedef HEDIEdge HEEdge;
 typedef unsigned int HEFace;    
                         
 
@@ -210,28 +205,13 @@ struct FaceProps {
 
 
 // the type of graph with which we construct the voronoi-diagram
-typedef HEDIGraph<     boost::listS,             // out-edges stored in a std::list
-                       boost::listS,             // vertex set stored here
-                       boost::bidirectionalS,    // bidirectional graph.
-                       VertexProps,              // vertex properties
-                       EdgeProps,                // edge properties
-                       FaceProps,                // face properties
-                       boost::no_property,       // graph properties
-                       boost::listS              // edge storage
-                       > HEGraph;
-
-typedef boost::graph_traits< HEGraph >::vertex_descriptor  HEVertex;
-typedef boost::graph_traits< HEGraph >::vertex_iterator    HEVertexItr;
+typedef HEDIGraph< VertexProps, EdgeProps, FaceProps > HEGraph;
 
-typedef boost::graph_traits< HEGraph >::edge_iterator      HEEdgeItr;
-typedef boost::graph_traits< HEGraph >::out_edge_iterator  HEOutEdgeItr;
-typedef boost::graph_traits< HEGraph >::adjacency_iterator HEAdjacencyItr;
-typedef boost::graph_traits< HEGraph >::vertices_size_type HEVertexSize;
+typedef HEGraph::Vertex HEVertex;
 
 
 // these containers are used instead of iterators when accessing
 // adjacent vertices, edges, faces.
-// FIXME: it may be faster to rewrite the code so it uses iterators, as does the BGL.
 typedef std::vector<HEVertex> VertexVector;
 typedef std::vector<HEFace> FaceVector;
 typedef std::vector<HEEdge> EdgeVector;  